@@ -0,0 +1,368 @@
+#include "Benchmarks.h"
+#include "UCIEngine.h"
+#include "Database.h"
+#include "DBWriter.h"
+#include "GamesTableModel.h"
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+using bench::printLatency;
+
+namespace
+{
+	// Drives UCIEngine synchronously by running local event loop until awaited event comes
+	class EngineDriver
+	{
+	public:
+		EngineDriver(void)
+			: m_awaited(UCIEventInfo::Type::None), m_last(UCIEventInfo::Type::None), m_infoCount(0)
+		{
+			m_timeout.setSingleShot(true);
+			QObject::connect(&m_timeout, &QTimer::timeout, &m_loop, &QEventLoop::quit);
+		}
+		UCIEngine::Callback callback(void)
+		{
+			return [this](UCIEngine*, const UCIEventInfo* eventInfo) {
+				if (eventInfo->type == UCIEventInfo::Type::Info)
+					++m_infoCount;
+				if (eventInfo->type == m_awaited || eventInfo->type == UCIEventInfo::Type::Error)
+				{
+					m_last = eventInfo->type;
+					m_loop.quit();
+				}
+			};
+		}
+		// Returns false on engine error or timeout
+		bool wait(UCIEventInfo::Type type, int timeout = 10000)
+		{
+			m_awaited = type;
+			m_last = UCIEventInfo::Type::None;
+			m_timeout.start(timeout);
+			m_loop.exec();
+			m_timeout.stop();
+			m_awaited = UCIEventInfo::Type::None;
+			return m_last == type;
+		}
+		inline long long infoCount(void) const noexcept
+		{
+			return m_infoCount;
+		}
+	private:
+		QEventLoop m_loop;
+		QTimer m_timeout;
+		UCIEventInfo::Type m_awaited;
+		UCIEventInfo::Type m_last;
+		long long m_infoCount;
+	};
+
+	// Random legal games from the standard position with dates spread over ~20 years.
+	// Every 16th one has unknown date, as games imported from PGN with '????.??.??'
+	std::vector<DBWriter::GameEntry> generateGames(int count, std::mt19937& rng)
+	{
+		std::vector<DBWriter::GameEntry> games;
+		games.reserve(count);
+		BlendXChess::MoveList moves;
+		for (int i = 0; i < count; ++i)
+		{
+			BlendXChess::Game game;
+			const int plies = 40 + int(rng() % 80);
+			for (int ply = 0; ply < plies && game.getGameState() == BlendXChess::GameState::ACTIVE; ++ply)
+			{
+				moves.clear();
+				game.generateLegalMoves(moves);
+				game.DoMove(moves[int(rng() % moves.count())]);
+			}
+			const QDate date = i % 16 == 15 ? QDate() : QDate(2000, 1, 1).addDays(rng() % 7300);
+			games.push_back({ 0, 0, game.getMoves(), QString(), db::resultString(game.getGameState()),
+				date, game.getPositionKeys() });
+		}
+		return games;
+	}
+
+	// Insert games into the selected backend and measure typical queries on them
+	void benchBackend(std::vector<DBWriter::GameEntry> games, int queries, std::mt19937& rng)
+	{
+		const QString connectionName = "bench_storage";
+		{
+			QSqlDatabase database = db::openDefault(connectionName);
+			if (!database.isOpen())
+				throw std::runtime_error("Could not open database: " + database.lastError().text().toStdString());
+			const int whiteId = db::findOrCreatePlayer("Bench White", 0, database);
+			const int blackId = db::findOrCreatePlayer("Bench Black", 0, database);
+			size_t positions = 0;
+			for (DBWriter::GameEntry& game : games)
+			{
+				game.whitePlayerId = whiteId;
+				game.blackPlayerId = blackId;
+				positions += game.positionKeys.size();
+			}
+			std::vector<BlendXChess::Key> searchKeys;
+			for (int i = 0; i < queries; ++i)
+			{
+				const auto& keys = games[rng() % games.size()].positionKeys;
+				searchKeys.push_back(keys[rng() % std::min<size_t>(keys.size(), 24)]);
+			}
+
+			// Bulk insert
+			QElapsedTimer timer;
+			timer.start();
+			DBWriter writer(DBWriter::Options(), "bench_writer");
+			for (DBWriter::GameEntry& game : games)
+				writer.push(std::move(game));
+			const DBWriter::Stats stats = writer.finish();
+			const double insertSeconds = timer.nsecsElapsed() / 1e9;
+			if (stats.failed > 0)
+				throw std::runtime_error("Writer failed: " + stats.lastError.toStdString());
+			std::cout << "insert: " << stats.written << " games (" << positions << " positions) in "
+				<< std::setprecision(2) << insertSeconds << " s, " << std::setprecision(0)
+				<< stats.written / insertSeconds << " games/s\n";
+
+			// Position search, reading all found games like the browser does
+			std::vector<double> samples;
+			long long found = 0;
+			for (BlendXChess::Key key : searchKeys)
+			{
+				timer.start();
+				QSqlQuery query = db::findGamesByPosition(key, database);
+				while (query.next())
+					++found;
+				samples.push_back(timer.nsecsElapsed() / 1000.0);
+			}
+			printLatency("position search", samples);
+			std::cout << "  " << std::setprecision(1) << double(found) / std::max<size_t>(searchKeys.size(), 1)
+				<< " games per search\n";
+
+			// First page of the game browser
+			samples.clear();
+			const QString pageSQL = db::gamesListSQL("ORDER BY games.date DESC, games.id DESC LIMIT 200");
+			for (int i = 0; i < std::min(queries, 200); ++i)
+			{
+				timer.start();
+				QSqlQuery query(database);
+				query.setForwardOnly(true);
+				if (!query.exec(pageSQL))
+					throw std::runtime_error("Page query failed: " + query.lastError().text().toStdString());
+				while (query.next())
+					;
+				samples.push_back(timer.nsecsElapsed() / 1000.0);
+			}
+			printLatency("games page", samples);
+
+			// Keyset pagination by date must visit every game once, including ones with unknown date
+			for (Qt::SortOrder order : { Qt::DescendingOrder, Qt::AscendingOrder })
+			{
+				std::vector<bool> seen;
+				QVariantList lastRow, bindValues;
+				int rows = 0, pages = 0;
+				do
+				{
+					QSqlQuery query(database);
+					query.setForwardOnly(true);
+					query.prepare(GamesTableModel::pageSQL(GamesTableModel::Filter(), GamesTableModel::DATE,
+						order, lastRow, bindValues));
+					for (const QVariant& value : bindValues)
+						query.addBindValue(value);
+					if (!query.exec())
+						throw std::runtime_error("Page query failed: " + query.lastError().text().toStdString());
+					for (rows = 0; query.next(); ++rows)
+					{
+						lastRow.clear();
+						for (int column = 0; column < GamesTableModel::COLUMN_COUNT; ++column)
+							lastRow.append(query.value(column));
+						const size_t id = lastRow[GamesTableModel::ID].toUInt();
+						if (id >= seen.size())
+							seen.resize(id + 1);
+						if (seen[id])
+							throw std::runtime_error("Game " + std::to_string(id) + " is on two pages");
+						seen[id] = true;
+					}
+					++pages;
+				} while (rows == GamesTableModel::PAGE_SIZE);
+				const long long visited = std::count(seen.begin(), seen.end(), true);
+				if (visited != stats.written)
+					throw std::runtime_error("Pagination visited " + std::to_string(visited) + " of "
+						+ std::to_string(stats.written) + " games");
+				std::cout << "pagination (date " << (order == Qt::AscendingOrder ? "asc" : "desc") << "): "
+					<< visited << " games on " << pages << " pages\n";
+			}
+
+			// Sequential scan of all games with movetext
+			int scanned = 0;
+			timer.start();
+			db::forEachGame([&scanned](const db::GameRecord&) { ++scanned; return true; }, database);
+			const double scanSeconds = timer.nsecsElapsed() / 1e9;
+			std::cout << "scan: " << scanned << " games in " << std::setprecision(2) << scanSeconds << " s, "
+				<< std::setprecision(0) << scanned / std::max(scanSeconds, 1e-9) << " games/s" << std::endl;
+		}
+		QSqlDatabase::removeDatabase(connectionName);
+	}
+}
+
+int bench::runUCI(QCoreApplication& app)
+{
+	QCommandLineParser parser;
+	parser.setApplicationDescription("UCI layer benchmark");
+	parser.addHelpOption();
+	parser.addOptions({
+		{ "bench-uci", "Run UCI benchmark instead of GUI." },
+		{ "engine", "Engine path, or mock engine parameters.", "path", "mock:options=30;info=20000" },
+		{ "pings", "Count of isready round trips.", "n", "1000" },
+		{ "searches", "Count of searches.", "n", "20" },
+		{ "depth", "Depth of each search.", "plies", "1" }
+		});
+	parser.process(app);
+	BlendXChess::Game::initialize();
+	const int pings = parser.value("pings").toInt(), searches = parser.value("searches").toInt();
+	const int depth = parser.value("depth").toInt();
+
+	EngineDriver driver;
+	UCIEngine engine;
+	QElapsedTimer timer;
+	try
+	{
+		timer.start();
+		engine.reset(parser.value("engine"), driver.callback());
+		if (!driver.wait(UCIEventInfo::Type::UciOk))
+			throw std::runtime_error("Engine didn't answer 'uci'");
+		const double handshake = timer.nsecsElapsed() / 1000.0;
+		std::cout << "Engine " << engine.getName() << " with " << engine.getOptions().size() << " options\n";
+		printLatency("uci handshake", { handshake });
+
+		// Finish option setting, after which engine is Ready
+		engine.sendIsReady();
+		if (!driver.wait(UCIEventInfo::Type::ReadyOk))
+			throw std::runtime_error("Engine didn't answer 'isready'");
+
+		// Command latency: isready -> readyok
+		std::vector<double> samples;
+		for (int i = 0; i < pings; ++i)
+		{
+			timer.start();
+			engine.sendSync();
+			if (!driver.wait(UCIEventInfo::Type::ReadyOk))
+				throw std::runtime_error("Engine didn't answer 'isready'");
+			samples.push_back(timer.nsecsElapsed() / 1000.0);
+		}
+		printLatency("isready -> readyok", samples);
+
+		// Search latency and info throughput: go -> bestmove, counting info lines in between
+		samples.clear();
+		const long long infoBefore = driver.infoCount();
+		QElapsedTimer total;
+		total.start();
+		for (int i = 0; i < searches; ++i)
+		{
+			engine.sendPosition("startpos");
+			timer.start();
+			engine.sendGo(depth);
+			if (!driver.wait(UCIEventInfo::Type::BestMove, 60000))
+				throw std::runtime_error("Engine didn't answer 'go'");
+			samples.push_back(timer.nsecsElapsed() / 1000.0);
+		}
+		const double seconds = total.nsecsElapsed() / 1e9;
+		printLatency("go -> bestmove", samples);
+		const long long infoLines = driver.infoCount() - infoBefore;
+		std::cout << "info lines: " << infoLines << " in " << std::setprecision(3) << seconds << " s, "
+			<< std::setprecision(0) << (seconds > 0 ? infoLines / seconds : 0.0) << " lines/s" << std::endl;
+		engine.close();
+	}
+	catch (const std::runtime_error& err)
+	{
+		std::cerr << err.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+int bench::runStorage(QCoreApplication& app)
+{
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Storage backends benchmark");
+	parser.addHelpOption();
+	parser.addOptions({
+		{ "bench-storage", "Run storage benchmark instead of GUI." },
+		{ "games", "Count of generated games.", "n", "20000" },
+		{ "queries", "Count of position searches.", "n", "1000" },
+		{ "sqlite", "Scratch SQLite database file.", "path",
+			QDir::temp().filePath("blendx_bench.sqlite") },
+		{ "mysql", "Scratch MySQL database (created and dropped).", "database", "blendx_bench" },
+		{ "no-mysql", "Benchmark SQLite only." },
+		{ "seed", "Random seed.", "n", "1" }
+		});
+	parser.process(app);
+	BlendXChess::Game::initialize();
+	std::mt19937 rng(parser.value("seed").toUInt());
+	const int gameCount = std::max(parser.value("games").toInt(), 1);
+	const int queries = std::max(parser.value("queries").toInt(), 1);
+
+	QElapsedTimer timer;
+	timer.start();
+	const std::vector<DBWriter::GameEntry> games = generateGames(gameCount, rng);
+	std::cout << "Generated " << games.size() << " games in " << timer.elapsed() << " ms\n";
+
+	int exitCode = 0;
+	const QString sqlitePath = parser.value("sqlite");
+	const auto removeSQLite = [&sqlitePath](void) {
+		for (const char* suffix : { "", "-wal", "-shm" })
+			QFile::remove(sqlitePath + suffix);
+	};
+	std::cout << "\n== sqlite (" << sqlitePath.toStdString() << ") ==\n";
+	removeSQLite();
+	try
+	{
+		db::setBackend(std::make_unique<SQLiteBackend>(sqlitePath));
+		benchBackend(games, queries, rng);
+	}
+	catch (const std::runtime_error& err)
+	{
+		std::cerr << err.what() << std::endl;
+		exitCode = 1;
+	}
+	removeSQLite();
+
+	if (parser.isSet("no-mysql"))
+		return exitCode;
+	const QString mysqlDatabase = parser.value("mysql");
+	std::cout << "\n== mysql (" << mysqlDatabase.toStdString() << ") ==\n";
+	auto mysql = std::make_unique<MySQLBackend>(mysqlDatabase);
+	const MySQLBackend& mysqlRef = *mysql;
+	bool created = false;
+	try
+	{
+		mysqlRef.createDatabase();
+		created = true;
+		db::setBackend(std::move(mysql));
+		benchBackend(games, queries, rng);
+	}
+	catch (const std::runtime_error& err)
+	{
+		std::cerr << err.what() << std::endl;
+		exitCode = 1;
+	}
+	try
+	{
+		if (created)
+			mysqlRef.dropDatabase();
+	}
+	catch (const std::runtime_error& err)
+	{
+		std::cerr << err.what() << std::endl;
+	}
+	return exitCode;
+}
+
+void bench::printLatency(const char* name, std::vector<double> samples)
+{
+	if (samples.empty())
+		return;
+	std::sort(samples.begin(), samples.end());
+	const double mean = std::accumulate(samples.begin(), samples.end(), 0.0) / samples.size();
+	std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(1)
+		<< " mean " << std::setw(9) << mean << " us, median " << std::setw(9) << samples[samples.size() / 2]
+		<< " us, p99 " << std::setw(9) << samples[samples.size() * 99 / 100] << " us ("
+		<< samples.size() << " samples)\n";
+}
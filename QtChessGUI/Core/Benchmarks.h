@@ -0,0 +1,17 @@
+#pragma once
+#include <QtCore>
+#include <vector>
+
+// Headless benchmark modes started from command line. Each returns process exit code
+namespace bench
+{
+	// --bench-uci: round-trip latency of UCI commands and throughput of info
+	// lines through UCIEngine, with mock (default) or real engine
+	int runUCI(QCoreApplication& app);
+	// --bench-storage: insert and query throughput of SQLite and MySQL backends
+	// on generated games, each in its own scratch database. Also checks that keyset pagination
+	// of the games browser visits every game once
+	int runStorage(QCoreApplication& app);
+	// Print mean, median and 99th percentile of samples given in microseconds
+	void printLatency(const char* name, std::vector<double> samples);
+}
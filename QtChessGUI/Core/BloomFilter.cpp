@@ -0,0 +1,32 @@
+#include "BloomFilter.h"
+
+BloomFilter::BloomFilter(size_t expectedCount)
+{
+	reset(expectedCount);
+}
+
+void BloomFilter::reset(size_t expectedCount)
+{
+	// Power of two bits, so that probe position is taken by mask
+	uint64_t bits = 1 << 16;
+	while (bits < uint64_t(expectedCount) * BITS_PER_HASH)
+		bits <<= 1;
+	m_words.assign(size_t(bits / 64), 0);
+	m_mask = bits - 1;
+}
+
+void BloomFilter::insert(uint64_t hash) noexcept
+{
+	const uint64_t delta = step(hash);
+	for (int i = 0; i < PROBES; ++i, hash += delta)
+		m_words[(hash & m_mask) >> 6] |= uint64_t(1) << (hash & 63);
+}
+
+bool BloomFilter::mayContain(uint64_t hash) const noexcept
+{
+	const uint64_t delta = step(hash);
+	for (int i = 0; i < PROBES; ++i, hash += delta)
+		if (!(m_words[(hash & m_mask) >> 6] & uint64_t(1) << (hash & 63)))
+			return false;
+	return true;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Probabilistic set of 64-bit hashes in a fixed bit array. mayContain never gives false
+// negatives, and with the chosen sizing gives false positives for about 0.05% of absent hashes
+// (as long as no more than expected count of hashes is inserted)
+class BloomFilter
+{
+public:
+	BloomFilter(size_t expectedCount = 0);
+	// Remove all hashes and resize for given count of them
+	void reset(size_t expectedCount);
+	void insert(uint64_t hash) noexcept;
+	bool mayContain(uint64_t hash) const noexcept;
+private:
+	static constexpr int BITS_PER_HASH = 16;
+	static constexpr int PROBES = 8;
+	// Second hash for double hashing, odd so that probes don't repeat
+	static inline uint64_t step(uint64_t hash) noexcept;
+
+	std::vector<uint64_t> m_words;
+	uint64_t m_mask; // Count of bits (power of two) minus one
+};
+
+inline uint64_t BloomFilter::step(uint64_t hash) noexcept
+{
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDULL;
+	hash ^= hash >> 33;
+	return hash | 1;
+}
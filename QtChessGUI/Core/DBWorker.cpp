@@ -0,0 +1,38 @@
+#include "DBWorker.h"
+#include "Database.h"
+
+DBWorker::DBWorker(const QString& connectionName)
+	: m_connectionName(connectionName), m_executor(new QObject)
+{
+	m_executor->moveToThread(&m_thread);
+	connect(&m_thread, &QThread::finished, m_executor, &QObject::deleteLater);
+	m_thread.start();
+}
+
+DBWorker::~DBWorker(void)
+{
+	// Tasks are run in order, so this one waits for all queued before it
+	QMetaObject::invokeMethod(m_executor, [this](void) {
+		if (!QSqlDatabase::contains(m_connectionName))
+			return;
+		QSqlDatabase::database(m_connectionName, false).close();
+		QSqlDatabase::removeDatabase(m_connectionName);
+	}, Qt::BlockingQueuedConnection);
+	m_thread.quit();
+	m_thread.wait();
+}
+
+void DBWorker::post(std::function<void(void)> task)
+{
+	QMetaObject::invokeMethod(m_executor, std::move(task), Qt::QueuedConnection);
+}
+
+QSqlDatabase DBWorker::connection(void)
+{
+	// Connection is added once and reopened by QSqlDatabase::database if it was lost
+	QSqlDatabase database = QSqlDatabase::contains(m_connectionName)
+		? QSqlDatabase::database(m_connectionName) : db::openDefault(m_connectionName);
+	if (!database.isOpen())
+		throw std::runtime_error("Could not connect to database: " + database.lastError().text().toStdString());
+	return database;
+}
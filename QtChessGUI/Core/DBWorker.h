@@ -0,0 +1,97 @@
+#pragma once
+#include <QtCore>
+#include <QtSql>
+#include <future>
+#include <functional>
+#include <type_traits>
+
+// Runs database jobs one after another on a dedicated thread which owns its own
+// connection, so that GUI thread never waits for the database. Job is a callable
+// taking QSqlDatabase and may throw std::runtime_error to report failure.
+// Results are obtained either as std::future or by callback in GUI thread
+class DBWorker : public QObject
+{
+public:
+	using ErrorCallback = std::function<void(const QString&)>;
+
+	DBWorker(const QString& connectionName = "db_worker");
+	// Waits for the queued jobs and closes connection
+	~DBWorker(void);
+	// Queue job, exceptions it throws are stored in the future
+	template<typename Job>
+	auto submit(Job job) -> std::future<std::invoke_result_t<Job, QSqlDatabase>>;
+	// Queue job and call onDone with its result (or onError with message of thrown exception)
+	// in the thread of DBWorker. Callbacks are skipped if context is destroyed by then
+	template<typename Job, typename OnDone>
+	void run(QObject* context, Job job, OnDone onDone, ErrorCallback onError = {});
+private:
+	void post(std::function<void(void)> task);
+	// Connection of worker thread, opened on first use. Throws std::runtime_error on failure
+	QSqlDatabase connection(void);
+
+	const QString m_connectionName;
+	QThread m_thread;
+	QObject* m_executor; // Lives in m_thread and runs posted tasks
+};
+
+template<typename Job>
+auto DBWorker::submit(Job job) -> std::future<std::invoke_result_t<Job, QSqlDatabase>>
+{
+	using Result = std::invoke_result_t<Job, QSqlDatabase>;
+	auto promise = std::make_shared<std::promise<Result>>();
+	std::future<Result> future = promise->get_future();
+	post([this, promise, job = std::move(job)](void) mutable {
+		try
+		{
+			if constexpr (std::is_void_v<Result>)
+			{
+				job(connection());
+				promise->set_value();
+			}
+			else
+				promise->set_value(job(connection()));
+		}
+		catch (...)
+		{
+			promise->set_exception(std::current_exception());
+		}
+	});
+	return future;
+}
+
+template<typename Job, typename OnDone>
+void DBWorker::run(QObject* context, Job job, OnDone onDone, ErrorCallback onError)
+{
+	using Result = std::invoke_result_t<Job, QSqlDatabase>;
+	QPointer<QObject> guard(context);
+	post([this, guard, job = std::move(job), onDone = std::move(onDone), onError = std::move(onError)](void) mutable {
+		// Result is moved to GUI thread along with callbacks
+		auto deliver = [this, guard](auto callback) {
+			QMetaObject::invokeMethod(this, [guard, callback = std::move(callback)](void) mutable {
+				if (guard)
+					callback();
+			}, Qt::QueuedConnection);
+		};
+		try
+		{
+			if constexpr (std::is_void_v<Result>)
+			{
+				job(connection());
+				deliver([onDone = std::move(onDone)](void) mutable { onDone(); });
+			}
+			else
+				deliver([onDone = std::move(onDone), result = job(connection())](void) mutable {
+					onDone(std::move(result)); });
+		}
+		catch (const std::exception& err)
+		{
+			const QString message = QString::fromStdString(err.what());
+			deliver([onError = std::move(onError), message](void) {
+				if (onError)
+					onError(message);
+				else
+					qWarning() << "Database job failed:" << message;
+			});
+		}
+	});
+}
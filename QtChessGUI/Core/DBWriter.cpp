@@ -0,0 +1,349 @@
+#include "DBWriter.h"
+#include "Database.h"
+#include "PlayerRegistry.h"
+#include <unordered_set>
+#include <algorithm>
+#include <iterator>
+#include <cstring>
+#include <utility>
+
+using namespace BlendXChess;
+
+namespace
+{
+	// Rows per multi-row INSERT into game_positions
+	constexpr int POSITIONS_BATCH = 1000;
+}
+
+DBWriter::DBWriter(const Options& options, const QString& connectionName)
+	: m_options(options), m_connectionName(connectionName), m_closed(false), m_written(0),
+	// Statements are limited by count of bound values (only 999 in SQLite)
+	m_gamesBatch(std::max(1, std::min(options.batchSize, db::backend().maxBindValues() / 8))),
+	m_positionsBatch(std::min(POSITIONS_BATCH, db::backend().maxBindValues() / 3))
+{
+	m_timer.start();
+	m_thread = QThread::create([this](void) { run(); });
+	m_thread->start();
+}
+
+DBWriter::~DBWriter(void)
+{
+	finish();
+}
+
+bool DBWriter::push(GameEntry game)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_notFull.wait(lock, [this](void) { return m_closed || m_queue.size() < m_options.queueCapacity; });
+	if (m_closed)
+		return false;
+	m_queue.push_back(std::move(game));
+	lock.unlock();
+	m_notEmpty.notify_one();
+	return true;
+}
+
+DBWriter::Stats DBWriter::finish(void)
+{
+	if (!m_thread)
+		return m_stats;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_closed = true;
+	}
+	m_notEmpty.notify_all();
+	m_notFull.notify_all();
+	m_thread->wait();
+	delete m_thread;
+	m_thread = nullptr;
+	return m_stats;
+}
+
+std::vector<DBWriter::CommittedGame> DBWriter::takeCommitted(void)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return std::exchange(m_committed, {});
+}
+
+void DBWriter::run(void)
+{
+	{
+		QSqlDatabase database = db::openDefault(m_connectionName);
+		QString error;
+		if (!database.isOpen())
+			error = "Could not connect to database: " + database.lastError().text();
+		else
+			try
+			{
+				loadStoredHashes(database);
+			}
+			catch (const std::runtime_error& err)
+			{
+				error = err.what();
+			}
+		if (error.isEmpty())
+		{
+			std::vector<GameEntry> games;
+			while (true)
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_notEmpty.wait(lock, [this](void) { return m_closed || !m_queue.empty(); });
+				if (m_queue.empty())
+					break; // Closed and everything is written
+				// Whatever is queued, up to one transaction. Under load the queue is full
+				// anyway, and a single game from tournament isn't delayed waiting for others
+				const size_t count = std::min(m_queue.size(), size_t(m_options.transactionSize));
+				games.assign(std::make_move_iterator(m_queue.begin()),
+					std::make_move_iterator(m_queue.begin() + count));
+				m_queue.erase(m_queue.begin(), m_queue.begin() + count);
+				lock.unlock();
+				m_notFull.notify_all();
+				writeTransaction(database, games);
+			}
+		}
+		else
+		{
+			m_stats.lastError = error;
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_closed = true;
+			m_stats.failed += int(m_queue.size());
+			m_queue.clear();
+		}
+		m_notFull.notify_all();
+		// Statements must be destroyed before their connection is removed
+		m_gamesInsert.reset();
+		m_positionsInsert.reset();
+		m_partialInsert.reset();
+		database.close();
+	}
+	QSqlDatabase::removeDatabase(m_connectionName);
+	m_stats.elapsed = m_timer.elapsed();
+}
+
+void DBWriter::loadStoredHashes(QSqlDatabase& database)
+{
+	QSqlQuery query(database);
+	query.setForwardOnly(true);
+	if (!query.exec("SELECT COUNT(*) FROM games") || !query.first())
+		throw std::runtime_error("Error counting stored games: " + query.lastError().text().toStdString());
+	m_storedHashes.reset(size_t(query.value(0).toLongLong()) + m_options.expectedGames);
+	if (!query.exec("SELECT moveHash FROM games WHERE moveHash IS NOT NULL"))
+		throw std::runtime_error("Error reading game hashes: " + query.lastError().text().toStdString());
+	while (query.next())
+		m_storedHashes.insert(uint64_t(query.value(0).toLongLong()));
+}
+
+void DBWriter::resolvePlayers(QSqlDatabase& database, GameEntry& entry)
+{
+	const auto resolve = [this, &database](int& id, const QString& name, int elo) {
+		if (id >= 0)
+			return;
+		if (!m_options.players)
+			throw std::runtime_error("Game has no player id");
+		id = m_options.players->findOrCreatePlayer(name, elo, database);
+	};
+	resolve(entry.whitePlayerId, entry.whiteName, entry.whiteElo);
+	resolve(entry.blackPlayerId, entry.blackName, entry.blackElo);
+}
+
+void DBWriter::writeTransaction(QSqlDatabase& database, std::vector<GameEntry>& games)
+{
+	// Replay games whose positions weren't supplied by producer (only the starting position if
+	// positions aren't indexed) and hash them. Illegal games and ones whose players couldn't be
+	// resolved are not stored. Players are created before the transaction, since that commits
+	std::vector<qint64> hashes;
+	hashes.reserve(games.size());
+	size_t legal = 0;
+	for (size_t i = 0; i < games.size(); ++i)
+	{
+		GameEntry& entry = games[i];
+		try
+		{
+			resolvePlayers(database, entry);
+			if (entry.positionKeys.empty())
+			{
+				Game game;
+				game.loadMoves(m_options.indexPositions ? entry.moves : std::vector<Move>(),
+					entry.startFEN.toStdString());
+				entry.positionKeys = game.getPositionKeys();
+			}
+			hashes.push_back(db::gameHash(entry.positionKeys.front(), entry.moves));
+		}
+		catch (const std::runtime_error& err)
+		{
+			++m_stats.failed;
+			if (entry.whitePlayerId < 0 || entry.blackPlayerId < 0)
+				m_stats.lastError = err.what();
+			continue;
+		}
+		if (legal != i)
+			games[legal] = std::move(entry);
+		++legal;
+	}
+	games.erase(games.begin() + legal, games.end());
+	if (games.empty())
+		return;
+	try
+	{
+		if (!db::backend().beginWrite(database))
+			throw std::runtime_error("Error starting transaction: " + database.lastError().text().toStdString());
+		removeDuplicates(database, games, hashes);
+		const int count = int(games.size());
+		int firstId = 0;
+		if (count > 0)
+		{
+			// Ids are assigned here rather than by AUTO_INCREMENT, whose values for a multi-row
+			// INSERT needn't be consecutive. Locking the end of index keeps other inserts out
+			QSqlQuery idQuery(database);
+			idQuery.prepare("SELECT COALESCE(MAX(id), 0) FROM games" + db::backend().lockForUpdate());
+			if (!idQuery.exec() || !idQuery.first())
+				throw std::runtime_error("Error reserving game ids: " + idQuery.lastError().text().toStdString());
+			firstId = idQuery.value(0).toInt() + 1;
+			for (int i = 0; i < count; i += m_gamesBatch)
+				insertGames(database, games.data() + i, hashes.data() + i, std::min(m_gamesBatch, count - i), firstId + i);
+			if (m_options.indexPositions)
+			{
+				std::vector<std::tuple<Key, int, int>> rows;
+				std::unordered_set<Key> seen;
+				for (int i = 0; i < count; ++i)
+				{
+					// Only the first occurrence of repeated position is stored
+					const std::vector<Key>& keys = games[i].positionKeys;
+					seen.clear();
+					for (int ply = 0; ply < int(keys.size()); ++ply)
+						if (seen.insert(keys[ply]).second)
+							rows.emplace_back(keys[ply], firstId + i, ply);
+					if (int(rows.size()) >= m_positionsBatch)
+					{
+						insertPositions(database, rows);
+						rows.clear();
+					}
+				}
+				insertPositions(database, rows);
+			}
+		}
+		if (!database.commit())
+			throw std::runtime_error("Error committing games: " + database.lastError().text().toStdString());
+		m_stats.written += count;
+		m_written.fetch_add(count, std::memory_order_relaxed);
+		if (m_options.keepCommitted)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (int i = 0; i < count; ++i)
+				m_committed.push_back({ firstId + i, std::move(games[i]) });
+		}
+	}
+	catch (const std::runtime_error& err)
+	{
+		database.rollback();
+		m_stats.failed += int(games.size());
+		m_stats.lastError = err.what();
+	}
+}
+
+void DBWriter::removeDuplicates(QSqlDatabase& database, std::vector<GameEntry>& games, std::vector<qint64>& hashes)
+{
+	// Repeats within the batch are found exactly. Of the others only those which Bloom filter
+	// reports as possibly stored are looked up, all with a single query
+	std::unordered_set<qint64> batchHashes;
+	std::vector<bool> duplicate(games.size(), false);
+	QStringList candidates;
+	for (size_t i = 0; i < games.size(); ++i)
+		if (!batchHashes.insert(hashes[i]).second)
+			duplicate[i] = true;
+		else if (m_storedHashes.mayContain(uint64_t(hashes[i])))
+			candidates << QString::number(hashes[i]);
+	if (!candidates.isEmpty())
+	{
+		// Hashes are integers, so they are written into statement rather than bound
+		QSqlQuery query(database);
+		query.setForwardOnly(true);
+		if (!query.exec("SELECT moveHash FROM games WHERE moveHash IN (" + candidates.join(',') + ')'))
+			throw std::runtime_error("Error searching stored games: " + query.lastError().text().toStdString());
+		std::unordered_set<qint64> stored;
+		while (query.next())
+			stored.insert(query.value(0).toLongLong());
+		for (size_t i = 0; i < games.size(); ++i)
+			if (stored.count(hashes[i]))
+				duplicate[i] = true;
+	}
+	size_t kept = 0;
+	for (size_t i = 0; i < games.size(); ++i)
+	{
+		if (duplicate[i])
+			continue;
+		// Filter may get hashes of games whose transaction fails, which only costs a lookup later
+		m_storedHashes.insert(uint64_t(hashes[i]));
+		if (kept != i)
+		{
+			games[kept] = std::move(games[i]);
+			hashes[kept] = hashes[i];
+		}
+		++kept;
+	}
+	m_stats.duplicates += int(games.size() - kept);
+	games.erase(games.begin() + kept, games.end());
+	hashes.erase(hashes.begin() + kept, hashes.end());
+}
+
+void DBWriter::insertGames(QSqlDatabase& database, const GameEntry* games, const qint64* hashes,
+	int count, int firstId)
+{
+	QSqlQuery& query = prepareInsert(database,
+		"INSERT INTO games(id, whitePlayerId, blackPlayerId, PGN, moves, startFEN, moveHash, date, result) VALUES ",
+		"(?, ?, ?, '', ?, ?, ?, ?, ?)", count, m_gamesBatch, m_gamesInsert);
+	int pos = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		query.bindValue(pos++, firstId + i);
+		query.bindValue(pos++, games[i].whitePlayerId);
+		query.bindValue(pos++, games[i].blackPlayerId);
+		query.bindValue(pos++, db::encodeMoves(games[i].moves));
+		query.bindValue(pos++, games[i].startFEN.isEmpty() ? QVariant(QVariant::String) : QVariant(games[i].startFEN));
+		query.bindValue(pos++, hashes[i]);
+		query.bindValue(pos++, games[i].date.isValid() ? QVariant(games[i].date) : QVariant(QVariant::Date));
+		query.bindValue(pos++, games[i].result);
+	}
+	if (!query.exec())
+		throw std::runtime_error("Error storing games in database: " + query.lastError().text().toStdString());
+}
+
+void DBWriter::insertPositions(QSqlDatabase& database, const std::vector<std::tuple<Key, int, int>>& rows)
+{
+	for (size_t batchBeg = 0; batchBeg < rows.size(); batchBeg += m_positionsBatch)
+	{
+		const int batchRows = int(std::min(rows.size() - batchBeg, size_t(m_positionsBatch)));
+		QSqlQuery& query = prepareInsert(database, "INSERT INTO game_positions(zobrist, gameId, ply) VALUES ",
+			"(?, ?, ?)", batchRows, m_positionsBatch, m_positionsInsert);
+		int pos = 0;
+		for (size_t i = batchBeg; i < batchBeg + batchRows; ++i)
+		{
+			query.bindValue(pos++, qint64(std::get<0>(rows[i])));
+			query.bindValue(pos++, std::get<1>(rows[i]));
+			query.bindValue(pos++, std::get<2>(rows[i]));
+		}
+		if (!query.exec())
+			throw std::runtime_error("Error indexing game positions: " + query.lastError().text().toStdString());
+	}
+}
+
+QSqlQuery& DBWriter::prepareInsert(QSqlDatabase& database, const char* head, const char* row,
+	int rows, int fullRows, std::optional<QSqlQuery>& full)
+{
+	const bool isFull = rows == fullRows;
+	if (isFull && full)
+		return *full;
+	std::optional<QSqlQuery>& query = isFull ? full : m_partialInsert;
+	QString sql = head;
+	sql.reserve(sql.size() + rows * (int(strlen(row)) + 2));
+	for (int i = 0; i < rows; ++i)
+	{
+		if (i > 0)
+			sql += ", ";
+		sql += row;
+	}
+	query.emplace(database);
+	if (!query->prepare(sql))
+		throw std::runtime_error("Error preparing insert: " + query->lastError().text().toStdString());
+	return *query;
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include <QtCore>
+#include <QtSql>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <optional>
+#include <tuple>
+#include "BloomFilter.h"
+#include "../Engine/engine.h"
+
+class PlayerRegistry;
+
+// Bulk game insertion on a dedicated thread with its own database connection.
+// Producers (PGN import, tournament runner) push games into a bounded queue and
+// block while it's full. The writer stores them with multi-row INSERT statements
+// prepared once and reused, committing every transactionSize games. Games which are already
+// stored (see db::gameHash) are skipped. Hashes of stored games are loaded into a Bloom filter
+// when writer starts, so that only games it reports as possibly stored are looked up in database
+class DBWriter
+{
+public:
+	struct Options
+	{
+		int batchSize = 250; // Games per INSERT statement (lowered to fit backend limit of bound values)
+		int transactionSize = 5000; // Games per transaction
+		size_t queueCapacity = 20000; // Pushing blocks while this many games are waiting
+		bool indexPositions = true; // Also fill game_positions
+		size_t expectedGames = 1 << 20; // Games expected to be pushed, for sizing the Bloom filter
+		// Finds or creates players of games given by names (on writer thread, so that producer
+		// doesn't wait for database). Should outlive the writer
+		PlayerRegistry* players = nullptr;
+		bool keepCommitted = false; // Keep committed games for takeCommitted
+	};
+	struct GameEntry
+	{
+		int whitePlayerId, blackPlayerId;
+		std::vector<BlendXChess::Move> moves;
+		QString startFEN; // Without counters, empty for standard starting position
+		QString result;
+		QDate date; // Invalid if unknown, then NULL is stored
+		// Keys of the game's positions (see Game::getPositionKeys). If empty while positions
+		// are indexed, moves are replayed on the writer thread
+		std::vector<BlendXChess::Key> positionKeys;
+		// Players by name (with Elo for a new one) in place of negative ids, see Options::players
+		QString whiteName, blackName;
+		int whiteElo = 0, blackElo = 0;
+	};
+	struct CommittedGame
+	{
+		int id;
+		GameEntry game;
+	};
+	struct Stats
+	{
+		int written = 0;
+		int failed = 0; // Games of failed transactions and illegal ones (if positions are indexed)
+		int duplicates = 0; // Games which were already stored or pushed before
+		qint64 elapsed = 0; // ms since the writer was started
+		QString lastError;
+		inline double gamesPerSecond(void) const noexcept;
+	};
+
+	DBWriter(const Options& options = Options(), const QString& connectionName = "db_writer");
+	// Finishes writing of queued games
+	~DBWriter(void);
+	// Queue game, waiting while the queue is full. Returns false if writer is already finished
+	bool push(GameEntry game);
+	// Write all queued games and stop the thread. Returns final statistics
+	Stats finish(void);
+	// Games written so far (may be called from any thread)
+	inline int written(void) const noexcept;
+	// Games committed since previous call, in order of ids, if Options::keepCommitted is set. Unlike
+	// pushed games, these are known to be stored, so that derived data may be updated with them
+	std::vector<CommittedGame> takeCommitted(void);
+private:
+	void run(void);
+	void loadStoredHashes(QSqlDatabase& database);
+	// Replace names of players with their ids. Throws std::runtime_error on failure
+	void resolvePlayers(QSqlDatabase& database, GameEntry& entry);
+	void writeTransaction(QSqlDatabase& database, std::vector<GameEntry>& games);
+	// Remove games which are already stored or repeated in the batch along with their hashes
+	void removeDuplicates(QSqlDatabase& database, std::vector<GameEntry>& games, std::vector<qint64>& hashes);
+	void insertGames(QSqlDatabase& database, const GameEntry* games, const qint64* hashes,
+		int count, int firstId);
+	void insertPositions(QSqlDatabase& database, const std::vector<std::tuple<BlendXChess::Key, int, int>>& rows);
+	// Statement with given rows count, reusing full-size one which is prepared once
+	QSqlQuery& prepareInsert(QSqlDatabase& database, const char* head, const char* row,
+		int rows, int fullRows, std::optional<QSqlQuery>& full);
+
+	const Options m_options;
+	const QString m_connectionName;
+	std::mutex m_mutex;
+	std::condition_variable m_notEmpty, m_notFull;
+	std::deque<GameEntry> m_queue;
+	std::vector<CommittedGame> m_committed;
+	bool m_closed;
+	std::atomic<int> m_written;
+	const int m_gamesBatch, m_positionsBatch; // Rows per INSERT
+	Stats m_stats; // Owned by the writer thread until it finishes
+	BloomFilter m_storedHashes; // Owned by the writer thread
+	QElapsedTimer m_timer;
+	// Prepared statements for full batches, and the one for the last partial batch
+	std::optional<QSqlQuery> m_gamesInsert, m_positionsInsert;
+	std::optional<QSqlQuery> m_partialInsert;
+	QThread* m_thread;
+};
+
+inline double DBWriter::Stats::gamesPerSecond(void) const noexcept
+{
+	return elapsed > 0 ? written * 1000.0 / elapsed : 0.0;
+}
+
+inline int DBWriter::written(void) const noexcept
+{
+	return m_written.load(std::memory_order_relaxed);
+}
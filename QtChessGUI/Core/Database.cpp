@@ -0,0 +1,575 @@
+#include "Database.h"
+#include <sstream>
+#include <unordered_set>
+#include <algorithm>
+
+using namespace BlendXChess;
+
+namespace
+{
+	// Rows per multi-row insert statement
+	constexpr int INSERT_BATCH = 500;
+	// Games per transaction of db::migrateMoves
+	constexpr int MIGRATE_BATCH = 1000;
+	// Version of games.moves format, stored as its first byte
+	constexpr char MOVES_FORMAT = 1;
+
+	std::unique_ptr<StorageBackend> currentBackend;
+
+	void execOrThrow(QSqlQuery& query, const char* what)
+	{
+		if (!query.exec())
+			throw std::runtime_error(std::string(what) + ": " + query.lastError().text().toStdString());
+	}
+
+	// Value of games.startFEN column, which is null for standard starting position
+	QVariant startFENValue(const Game& game)
+	{
+		static const std::string standardFEN = Game().getPositionFEN(true);
+		const std::string startFEN = game.getStartFEN();
+		return startFEN == standardFEN ? QVariant(QVariant::String)
+			: QVariant(QString::fromStdString(startFEN).trimmed());
+	}
+}
+
+namespace db
+{
+	void setBackend(std::unique_ptr<StorageBackend> backend)
+	{
+		currentBackend = std::move(backend);
+	}
+
+	const StorageBackend& backend(void)
+	{
+		if (!currentBackend)
+			currentBackend = std::make_unique<MySQLBackend>();
+		return *currentBackend;
+	}
+
+	QSqlDatabase openDefault(const QString& connectionName)
+	{
+		QSqlDatabase database = backend().connect(connectionName);
+		if (database.isOpen())
+			ensureSchema(database);
+		return database;
+	}
+
+	void ensureSchema(QSqlDatabase database)
+	{
+		backend().ensureSchema(database);
+	}
+
+	QString resultString(GameState state)
+	{
+		switch (state)
+		{
+		case GameState::DRAW: return "1/2-1/2";
+		case GameState::WHITE_WIN: return "1-0";
+		case GameState::BLACK_WIN: return "0-1";
+		default: return "Active";
+		}
+	}
+
+	GameState resultState(const QString& result)
+	{
+		if (result == "1-0")
+			return GameState::WHITE_WIN;
+		if (result == "0-1")
+			return GameState::BLACK_WIN;
+		if (result == "1/2-1/2")
+			return GameState::DRAW;
+		return GameState::ACTIVE;
+	}
+
+	QByteArray encodeMoves(const std::vector<Move>& moves)
+	{
+		QByteArray data(1 + 2 * int(moves.size()), Qt::Uninitialized);
+		char* out = data.data();
+		*out++ = MOVES_FORMAT;
+		for (Move move : moves)
+		{
+			*out++ = char(move.raw() & 0xFF);
+			*out++ = char(move.raw() >> 8);
+		}
+		return data;
+	}
+
+	std::vector<Move> decodeMoves(const QByteArray& data)
+	{
+		if (data.isEmpty() || data[0] != MOVES_FORMAT || data.size() % 2 == 0)
+			throw std::runtime_error("Stored moves are in unknown format");
+		std::vector<Move> moves;
+		moves.reserve(data.size() / 2);
+		const auto* in = reinterpret_cast<const unsigned char*>(data.constData()) + 1;
+		for (int i = 0; i < data.size() / 2; ++i, in += 2)
+			moves.emplace_back(MoveRaw(in[0] | in[1] << 8));
+		return moves;
+	}
+
+	qint64 gameHash(Key startKey, const std::vector<Move>& moves)
+	{
+		// Polynomial hash of raw moves seeded by the position key, finalized by a mixer
+		// (splitmix64) so that games differing only in the last move differ in all bits
+		uint64_t hash = startKey;
+		for (Move move : moves)
+			hash = (hash + move.raw() + 1) * 0x9E3779B97F4A7C15ULL;
+		hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+		return qint64(hash ^ (hash >> 31));
+	}
+
+	void loadStoredGame(Game& game, const QByteArray& moves, const QString& startFEN, const QString& PGN)
+	{
+		if (moves.isNull())
+		{
+			std::istringstream iss(PGN.toStdString());
+			game.loadGame(iss);
+		}
+		else
+			game.loadMoves(decodeMoves(moves), startFEN.toStdString());
+	}
+
+	int playerElo(int playerId, QSqlDatabase database)
+	{
+		QSqlQuery query(database);
+		query.prepare("SELECT ELO FROM players WHERE id = ?");
+		query.addBindValue(playerId);
+		return query.exec() && query.first() ? query.value(0).toInt() : 0;
+	}
+
+	void forEachGame(const std::function<bool(const GameRecord&)>& visitor, QSqlDatabase database)
+	{
+		QSqlQuery query(database);
+		query.setForwardOnly(true);
+		query.prepare("SELECT games.id, whitePlayerId, blackPlayerId, moves, startFEN, PGN, result, wp.ELO, bp.ELO "
+			"FROM games LEFT JOIN players wp ON wp.id = whitePlayerId LEFT JOIN players bp ON bp.id = blackPlayerId "
+			"ORDER BY games.id");
+		execOrThrow(query, "Error reading games");
+		while (query.next())
+		{
+			const GameRecord record{ query.value(0).toInt(), query.value(1).toInt(), query.value(2).toInt(),
+				query.value(3).toByteArray(), query.value(4).toString(), query.value(5).toString(),
+				query.value(6).toString(), query.value(7).toInt(), query.value(8).toInt() };
+			if (!visitor(record))
+				break;
+		}
+	}
+
+	int insertGame(int whiteId, int blackId, const Game& game, const QString& result,
+		const QDate& date, const GameStats& stats, QSqlDatabase database)
+	{
+		backend().beginWrite(database);
+		try
+		{
+			const std::vector<Move> moves = game.getMoves();
+			const qint64 hash = gameHash(game.getPositionKeys().front(), moves);
+			QSqlQuery query(database);
+			query.prepare("SELECT id FROM games WHERE moveHash = ?");
+			query.addBindValue(hash);
+			execOrThrow(query, "Error searching game in database");
+			if (query.first())
+				throw std::runtime_error("This game is already stored in database (id "
+					+ std::to_string(query.value(0).toInt()) + ')');
+			// Movetext is no longer stored, PGN column is left empty
+			query.prepare("INSERT INTO games(whitePlayerId, blackPlayerId, PGN, moves, startFEN, moveHash, date, result) "
+				"VALUES(?, ?, '', ?, ?, ?, ?, ?)");
+			query.addBindValue(whiteId);
+			query.addBindValue(blackId);
+			query.addBindValue(encodeMoves(moves));
+			query.addBindValue(startFENValue(game));
+			query.addBindValue(hash);
+			query.addBindValue(date);
+			query.addBindValue(result);
+			execOrThrow(query, "Error storing game in database");
+			const int gameId = query.lastInsertId().toInt();
+			indexGame(gameId, game, database);
+			storeMoveStats(gameId, stats, int(moves.size()), database);
+			database.commit();
+			return gameId;
+		}
+		catch (const std::runtime_error&)
+		{
+			database.rollback();
+			throw;
+		}
+	}
+
+	void indexGame(int gameId, const Game& game, QSqlDatabase database)
+	{
+		// Only the first occurrence of repeated position is stored
+		const std::vector<Key> keys = game.getPositionKeys();
+		std::unordered_set<Key> seen;
+		std::vector<std::pair<Key, int>> rows;
+		for (int ply = 0; ply < int(keys.size()); ++ply)
+			if (seen.insert(keys[ply]).second)
+				rows.emplace_back(keys[ply], ply);
+		QSqlQuery query(database);
+		const size_t batchSize = std::min(INSERT_BATCH, backend().maxBindValues() / 3);
+		for (size_t batchBeg = 0; batchBeg < rows.size(); batchBeg += batchSize)
+		{
+			const size_t batchEnd = std::min(rows.size(), batchBeg + batchSize);
+			QString sql = "INSERT INTO game_positions(zobrist, gameId, ply) VALUES ";
+			for (size_t i = batchBeg; i < batchEnd; ++i)
+				sql += i == batchBeg ? "(?, ?, ?)" : ", (?, ?, ?)";
+			query.prepare(sql);
+			for (size_t i = batchBeg; i < batchEnd; ++i)
+			{
+				query.addBindValue(qint64(rows[i].first));
+				query.addBindValue(gameId);
+				query.addBindValue(rows[i].second);
+			}
+			execOrThrow(query, "Error indexing game positions");
+		}
+	}
+
+	void storeMoveStats(int gameId, const GameStats& stats, int plies, QSqlDatabase database)
+	{
+		std::vector<int> rows; // Plies
+		for (int ply = 0; ply < std::min(plies, int(stats.size())); ++ply)
+			if (!stats[ply].empty())
+				rows.push_back(ply);
+		QSqlQuery query(database);
+		const size_t batchSize = std::min(INSERT_BATCH, backend().maxBindValues() / 8);
+		for (size_t batchBeg = 0; batchBeg < rows.size(); batchBeg += batchSize)
+		{
+			const size_t batchEnd = std::min(rows.size(), batchBeg + batchSize);
+			QString sql = "INSERT INTO move_stats(gameId, ply, scoreType, score, depth, nodes, nps, time) VALUES ";
+			for (size_t i = batchBeg; i < batchEnd; ++i)
+				sql += i == batchBeg ? "(?, ?, ?, ?, ?, ?, ?, ?)" : ", (?, ?, ?, ?, ?, ?, ?, ?)";
+			query.prepare(sql);
+			for (size_t i = batchBeg; i < batchEnd; ++i)
+			{
+				const MoveStats& moveStats = stats[rows[i]];
+				query.addBindValue(gameId);
+				query.addBindValue(rows[i]);
+				query.addBindValue(int(moveStats.scoreType));
+				query.addBindValue(moveStats.score);
+				query.addBindValue(moveStats.depth);
+				query.addBindValue(moveStats.nodes);
+				query.addBindValue(moveStats.nps);
+				query.addBindValue(moveStats.time);
+			}
+			execOrThrow(query, "Error storing move statistics");
+		}
+	}
+
+	GameStats readMoveStats(int gameId, QSqlDatabase database)
+	{
+		QSqlQuery query(database);
+		query.setForwardOnly(true);
+		query.prepare("SELECT ply, scoreType, score, depth, nodes, nps, time FROM move_stats "
+			"WHERE gameId = ? ORDER BY ply");
+		query.addBindValue(gameId);
+		execOrThrow(query, "Error reading move statistics");
+		GameStats stats;
+		while (query.next())
+		{
+			const int ply = query.value(0).toInt();
+			if (ply < 0)
+				continue;
+			stats.resize(std::max(stats.size(), size_t(ply) + 1));
+			stats[ply] = { InfoDetails::ScoreType(query.value(1).toInt()), query.value(2).toInt(),
+				query.value(3).toInt(), query.value(4).toLongLong(), query.value(5).toLongLong(),
+				query.value(6).toInt() };
+		}
+		return stats;
+	}
+
+	int rebuildPositionIndex(const std::function<bool(int, int)>& progress, QSqlDatabase database)
+	{
+		QSqlQuery countQuery("SELECT COUNT(*) FROM games", database);
+		const int total = countQuery.first() ? countQuery.value(0).toInt() : 0;
+		backend().beginWrite(database);
+		try
+		{
+			QSqlQuery clearQuery(database);
+			clearQuery.prepare("DELETE FROM game_positions");
+			execOrThrow(clearQuery, "Error clearing position index");
+			QSqlQuery gamesQuery(database);
+			gamesQuery.setForwardOnly(true);
+			gamesQuery.prepare("SELECT id, moves, startFEN, PGN FROM games");
+			execOrThrow(gamesQuery, "Error reading games");
+			int processed = 0, indexed = 0;
+			Game game;
+			while (gamesQuery.next())
+			{
+				try
+				{
+					loadStoredGame(game, gamesQuery.value(1).toByteArray(), gamesQuery.value(2).toString(),
+						gamesQuery.value(3).toString());
+					indexGame(gamesQuery.value(0).toInt(), game, database);
+					++indexed;
+				}
+				catch (const std::runtime_error&)
+				{
+					// Game with illegal movetext can't be indexed, but shouldn't stop the others
+				}
+				if (++processed % 100 == 0 && progress && !progress(processed, total))
+				{
+					database.rollback();
+					return 0;
+				}
+			}
+			database.commit();
+			return indexed;
+		}
+		catch (const std::runtime_error&)
+		{
+			database.rollback();
+			throw;
+		}
+	}
+
+	QString gamesListSQL(const QString& filter)
+	{
+		// Player is either engine or human, whose name is stored in persons
+		return "SELECT games.id, games.whitePlayerId, games.blackPlayerId, "
+			"COALESCE(we.name, wp.name) AS wname, CASE WHEN we.id IS NULL THEN 'Human' ELSE 'Engine' END AS wtype, "
+			"COALESCE(be.name, bp.name) AS bname, CASE WHEN be.id IS NULL THEN 'Human' ELSE 'Engine' END AS btype, "
+			"games.date, games.result FROM games "
+			"LEFT JOIN engine_players we ON we.id = games.whitePlayerId "
+			"LEFT JOIN human_players wh ON wh.id = games.whitePlayerId "
+			"LEFT JOIN persons wp ON wp.id = wh.personId "
+			"LEFT JOIN engine_players be ON be.id = games.blackPlayerId "
+			"LEFT JOIN human_players bh ON bh.id = games.blackPlayerId "
+			"LEFT JOIN persons bp ON bp.id = bh.personId " + filter;
+	}
+
+	QSqlQuery findGamesByPosition(Key key, QSqlDatabase database)
+	{
+		QSqlQuery query(database);
+		query.prepare(gamesListSQL("INNER JOIN game_positions gp ON gp.gameId = games.id "
+			"WHERE gp.zobrist = ? ORDER BY games.date DESC"));
+		query.addBindValue(qint64(key));
+		execOrThrow(query, "Error searching games by position");
+		return query;
+	}
+
+	int findOrCreatePlayer(const QString& name, int elo, QSqlDatabase database)
+	{
+		QSqlQuery query(database);
+		query.prepare("SELECT id FROM engine_players WHERE name = ? UNION ALL "
+			"SELECT human_players.id FROM human_players INNER JOIN persons ON personId = persons.id "
+			"WHERE persons.name = ? LIMIT 1");
+		query.addBindValue(name);
+		query.addBindValue(name);
+		execOrThrow(query, "Error searching player");
+		if (query.first())
+			return query.value(0).toInt();
+		backend().beginWrite(database);
+		try
+		{
+			query.prepare("INSERT INTO players(ELO) VALUES(?)");
+			query.addBindValue(elo);
+			execOrThrow(query, "Error creating player");
+			const int playerId = query.lastInsertId().toInt();
+			query.prepare("INSERT INTO persons(name) VALUES(?)");
+			query.addBindValue(name);
+			execOrThrow(query, "Error creating player");
+			const int personId = query.lastInsertId().toInt();
+			query.prepare("INSERT INTO human_players(id, personId) VALUES(?, ?)");
+			query.addBindValue(playerId);
+			query.addBindValue(personId);
+			execOrThrow(query, "Error creating player");
+			database.commit();
+			return playerId;
+		}
+		catch (const std::runtime_error&)
+		{
+			database.rollback();
+			throw;
+		}
+	}
+
+	Rows selectRows(const QString& sql, const QVariantList& bindValues, QSqlDatabase database)
+	{
+		QSqlQuery query(database);
+		query.setForwardOnly(true);
+		query.prepare(sql);
+		for (const QVariant& value : bindValues)
+			query.addBindValue(value);
+		execOrThrow(query, "Error reading from database");
+		Rows rows;
+		const int columns = query.record().count();
+		while (query.next())
+		{
+			QVariantList row;
+			row.reserve(columns);
+			for (int column = 0; column < columns; ++column)
+				row.append(query.value(column));
+			rows.append(row);
+		}
+		return rows;
+	}
+
+	Game readGame(int id, QSqlDatabase database)
+	{
+		QSqlQuery query(database);
+		query.prepare("SELECT moves, startFEN, PGN FROM games WHERE id = ?");
+		query.addBindValue(id);
+		execOrThrow(query, "Error reading game from database");
+		if (!query.first())
+			throw std::runtime_error("No game with id " + std::to_string(id) + " in database");
+		Game game;
+		loadStoredGame(game, query.value(0).toByteArray(), query.value(1).toString(), query.value(2).toString());
+		return game;
+	}
+
+	int migrateMoves(const std::function<bool(int, int)>& progress, QSqlDatabase database)
+	{
+		QSqlQuery countQuery("SELECT COUNT(*) FROM games WHERE moves IS NULL OR moveHash IS NULL", database);
+		const int total = countQuery.first() ? countQuery.value(0).toInt() : 0;
+		countQuery.finish();
+		// Batches are selected by id, so that games left behind aren't read again
+		QSqlQuery selectQuery(database);
+		selectQuery.setForwardOnly(true);
+		selectQuery.prepare("SELECT id, moves, startFEN, PGN FROM games WHERE (moves IS NULL OR moveHash IS NULL) "
+			"AND id > ? ORDER BY id LIMIT " + QString::number(MIGRATE_BATCH));
+		QSqlQuery duplicateQuery(database);
+		duplicateQuery.prepare("SELECT COUNT(*) FROM games WHERE moveHash = ?");
+		QSqlQuery updateQuery(database);
+		updateQuery.prepare("UPDATE games SET moves = ?, PGN = '', moveHash = ? WHERE id = ?");
+		struct Converted
+		{
+			int id;
+			QByteArray moves;
+			qint64 hash;
+		};
+		std::vector<Converted> converted;
+		std::unordered_set<qint64> batchHashes;
+		int processed = 0, migrated = 0, lastId = 0;
+		Game game;
+		while (true)
+		{
+			selectQuery.bindValue(0, lastId);
+			execOrThrow(selectQuery, "Error reading games");
+			converted.clear();
+			int selected = 0;
+			while (selectQuery.next())
+			{
+				++selected;
+				lastId = selectQuery.value(0).toInt();
+				const QByteArray moves = selectQuery.value(1).toByteArray();
+				try
+				{
+					loadStoredGame(game, moves, selectQuery.value(2).toString(), selectQuery.value(3).toString());
+					const std::vector<Move> gameMoves = game.getMoves();
+					converted.push_back({ lastId, moves.isNull() ? encodeMoves(gameMoves) : moves,
+						gameHash(game.getPositionKeys().front(), gameMoves) });
+				}
+				catch (const std::runtime_error&)
+				{
+					// Illegal movetext is kept as it is, so that it can still be fixed by hand
+				}
+			}
+			selectQuery.finish();
+			if (selected == 0)
+				break;
+			backend().beginWrite(database);
+			try
+			{
+				batchHashes.clear();
+				for (const Converted& row : converted)
+				{
+					// Duplicate which was stored before hashes were introduced keeps null hash
+					duplicateQuery.bindValue(0, row.hash);
+					execOrThrow(duplicateQuery, "Error searching game in database");
+					const bool duplicate = !batchHashes.insert(row.hash).second
+						|| (duplicateQuery.first() && duplicateQuery.value(0).toInt() > 0);
+					duplicateQuery.finish();
+					updateQuery.bindValue(0, row.moves);
+					updateQuery.bindValue(1, duplicate ? QVariant(QVariant::LongLong) : QVariant(row.hash));
+					updateQuery.bindValue(2, row.id);
+					execOrThrow(updateQuery, "Error storing converted game");
+				}
+				database.commit();
+			}
+			catch (const std::runtime_error&)
+			{
+				database.rollback();
+				throw;
+			}
+			processed += selected;
+			migrated += int(converted.size());
+			if (progress && !progress(processed, total))
+				break;
+		}
+		return migrated;
+	}
+
+	int addEngine(const EngineData& engine, QSqlDatabase database)
+	{
+		backend().beginWrite(database);
+		try
+		{
+			QSqlQuery query(database);
+			query.prepare("INSERT INTO players(ELO) VALUES(?)");
+			query.addBindValue(engine.elo);
+			execOrThrow(query, "Error storing engine in database");
+			const int playerId = query.lastInsertId().toInt();
+			query.prepare("INSERT INTO engine_players(id,authorId,programmingLanguage,name,version,path) VALUES(?,?,?,?,?,?)");
+			query.addBindValue(playerId);
+			query.addBindValue(engine.authorId);
+			query.addBindValue(engine.programmingLanguage);
+			query.addBindValue(engine.name);
+			query.addBindValue(engine.version);
+			query.addBindValue(engine.path);
+			execOrThrow(query, "Error storing engine in database");
+			database.commit();
+			return playerId;
+		}
+		catch (const std::runtime_error&)
+		{
+			database.rollback();
+			throw;
+		}
+	}
+
+	void updateEngine(int id, const EngineData& engine, QSqlDatabase database)
+	{
+		backend().beginWrite(database);
+		try
+		{
+			QSqlQuery query(database);
+			query.prepare("UPDATE players SET ELO = ? WHERE id = ?");
+			query.addBindValue(engine.elo);
+			query.addBindValue(id);
+			execOrThrow(query, "Error updating engine in database");
+			query.prepare("UPDATE engine_players SET authorId = ?, programmingLanguage = ?, name = ?, version = ?, path = ? WHERE id = ?");
+			query.addBindValue(engine.authorId);
+			query.addBindValue(engine.programmingLanguage);
+			query.addBindValue(engine.name);
+			query.addBindValue(engine.version);
+			query.addBindValue(engine.path);
+			query.addBindValue(id);
+			execOrThrow(query, "Error updating engine in database");
+			database.commit();
+		}
+		catch (const std::runtime_error&)
+		{
+			database.rollback();
+			throw;
+		}
+	}
+
+	void removeEngine(int id, QSqlDatabase database)
+	{
+		backend().beginWrite(database);
+		try
+		{
+			QSqlQuery query(database);
+			query.prepare("DELETE FROM engine_players WHERE id = ?");
+			query.addBindValue(id);
+			execOrThrow(query, "Error deleting engine from database");
+			query.prepare("DELETE FROM players WHERE id = ?");
+			query.addBindValue(id);
+			execOrThrow(query, "Error deleting engine from database");
+			database.commit();
+		}
+		catch (const std::runtime_error&)
+		{
+			database.rollback();
+			throw;
+		}
+	}
+}
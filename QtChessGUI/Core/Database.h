@@ -0,0 +1,106 @@
+#pragma once
+#include <QtSql>
+#include <functional>
+#include <memory>
+#include "StorageBackend.h"
+#include "MoveStats.h"
+#include "../Engine/engine.h"
+
+// Helpers for the chess database shared by GUI and headless modes
+namespace db
+{
+	// Editable data of engine player
+	struct EngineData
+	{
+		QString name;
+		QString version;
+		QVariant authorId; // Null if unknown
+		QString programmingLanguage;
+		QString path;
+		int elo;
+	};
+	// Result rows of a query, each with values of all its columns
+	using Rows = QVector<QVariantList>;
+	// Stored game with players' ratings
+	struct GameRecord
+	{
+		int id;
+		int whitePlayerId, blackPlayerId;
+		QByteArray moves; // Packed moves (see encodeMoves), null for games not migrated yet
+		QString startFEN; // Empty for standard starting position
+		QString PGN; // Movetext of games stored before moves column was added
+		QString result;
+		int whiteElo, blackElo; // 0 if unknown
+	};
+	// Select storage used by openDefault (MySQL on localhost unless set). Should be
+	// called before any connection is opened
+	void setBackend(std::unique_ptr<StorageBackend> backend);
+	const StorageBackend& backend(void);
+	// Add and open connection to the selected storage, creating missing tables used by
+	// the application. Result should be checked with isOpen()
+	QSqlDatabase openDefault(const QString& connectionName = QLatin1String(QSqlDatabase::defaultConnection));
+	// Create tables which may be missing in older databases
+	void ensureSchema(QSqlDatabase database = QSqlDatabase::database());
+	// Value of games.result column for given game state
+	QString resultString(BlendXChess::GameState state);
+	// Game state for given value of games.result column
+	BlendXChess::GameState resultState(const QString& result);
+	// Moves packed into games.moves column: format version byte followed by raw
+	// 16-bit moves in little-endian order. Decoding throws std::runtime_error if data is malformed
+	QByteArray encodeMoves(const std::vector<BlendXChess::Move>& moves);
+	std::vector<BlendXChess::Move> decodeMoves(const QByteArray& data);
+	// Hash identifying game by key of its starting position (see Game::getPositionKey) and moves.
+	// It's stored in games.moveHash, which is unique, so that the same game isn't stored twice
+	qint64 gameHash(BlendXChess::Key startKey, const std::vector<BlendXChess::Move>& moves);
+	// Load stored game from its packed moves, or from movetext if they are null.
+	// Throws std::runtime_error if game is malformed
+	void loadStoredGame(BlendXChess::Game& game, const QByteArray& moves, const QString& startFEN,
+		const QString& PGN);
+	// Rating of player (0 if it's unknown)
+	int playerElo(int playerId, QSqlDatabase database = QSqlDatabase::database());
+	// Call visitor for every stored game in order of ids until it returns false. Throws std::runtime_error on failure
+	void forEachGame(const std::function<bool(const GameRecord&)>& visitor,
+		QSqlDatabase database = QSqlDatabase::database());
+	// Store game (its moves up to current position) in games table, its positions in
+	// game_positions index and statistics of its engine moves in move_stats. Throws std::runtime_error
+	// on failure (including the case when the same game is already stored), otherwise returns new game id
+	int insertGame(int whiteId, int blackId, const BlendXChess::Game& game, const QString& result,
+		const QDate& date = QDate::currentDate(), const GameStats& stats = GameStats(),
+		QSqlDatabase database = QSqlDatabase::database());
+	// Add positions of game up to its current one to game_positions. Throws std::runtime_error on failure
+	void indexGame(int gameId, const BlendXChess::Game& game, QSqlDatabase database = QSqlDatabase::database());
+	// Add statistics of first plies moves of game (empty ones are skipped) to move_stats.
+	// Throws std::runtime_error on failure
+	void storeMoveStats(int gameId, const GameStats& stats, int plies,
+		QSqlDatabase database = QSqlDatabase::database());
+	// Statistics of moves of stored game, with empty ones for plies without them (and none after
+	// the last stored one). Throws std::runtime_error on failure
+	GameStats readMoveStats(int gameId, QSqlDatabase database = QSqlDatabase::database());
+	// Recreate game_positions for all stored games. Progress callback receives count of processed and
+	// all games and may return false to cancel. Returns count of indexed games (unparsable are skipped)
+	int rebuildPositionIndex(const std::function<bool(int, int)>& progress = {},
+		QSqlDatabase database = QSqlDatabase::database());
+	// List of games with the same columns as ExtGames procedure, filtered by given joins/conditions
+	QString gamesListSQL(const QString& filter = QString());
+	// Executed query listing games which reached position with given key (see Game::getPositionKey)
+	QSqlQuery findGamesByPosition(BlendXChess::Key key, QSqlDatabase database = QSqlDatabase::database());
+	// Id of engine or human player with given name. Missing human player is created
+	// with given rating. Throws std::runtime_error on failure
+	int findOrCreatePlayer(const QString& name, int elo = 0, QSqlDatabase database = QSqlDatabase::database());
+	// Execute SELECT and return all its rows. Throws std::runtime_error on failure
+	Rows selectRows(const QString& sql, const QVariantList& bindValues = QVariantList(),
+		QSqlDatabase database = QSqlDatabase::database());
+	// Stored game. Throws std::runtime_error on failure or if there's no such game
+	BlendXChess::Game readGame(int id, QSqlDatabase database = QSqlDatabase::database());
+	// Convert movetext of games stored before moves column was added into packed moves and fill
+	// missing game hashes, one transaction per batch so that it may be interrupted and resumed.
+	// Progress callback receives count of processed and all such games and may return false to stop.
+	// Returns count of converted games (unparsable ones are left as they are, duplicates of already
+	// hashed games are left without hash). Throws std::runtime_error on failure
+	int migrateMoves(const std::function<bool(int, int)>& progress = {},
+		QSqlDatabase database = QSqlDatabase::database());
+	// Add, modify and remove engine player (with its players row). Throw std::runtime_error on failure
+	int addEngine(const EngineData& engine, QSqlDatabase database = QSqlDatabase::database());
+	void updateEngine(int id, const EngineData& engine, QSqlDatabase database = QSqlDatabase::database());
+	void removeEngine(int id, QSqlDatabase database = QSqlDatabase::database());
+}
@@ -0,0 +1,112 @@
+#include "EnginePool.h"
+#include <algorithm>
+
+EnginePool::EnginePool(int maxIdle, int healthCheckInterval)
+	: m_maxIdle(maxIdle)
+{
+	QObject::connect(&m_healthTimer, &QTimer::timeout, [this]() {checkHealth(); });
+	m_healthTimer.start(healthCheckInterval);
+}
+
+EnginePool::~EnginePool(void)
+{
+	for (auto& entry : m_entries)
+		closeEntry(entry);
+}
+
+UCIEngine* EnginePool::acquire(QString path, UCIEngine::Callback eventCallback,
+	const UCIEngine::OptionValues& options)
+{
+	Entry* best = nullptr;
+	for (auto& entry : m_entries)
+	{
+		if (entry.busy || entry.engine->getPath() != path
+			|| entry.engine->getState() != UCIEngine::State::Ready || !entry.engine->isAlive())
+			continue;
+		// Prefer engine with requested options, then the most recently used one
+		const bool sameOptions = !options.empty() && entry.engine->hasOptionValues(options);
+		const bool bestSameOptions = best && !options.empty() && best->engine->hasOptionValues(options);
+		if (!best || sameOptions && !bestSameOptions ||
+			sameOptions == bestSameOptions && entry.idleTime.elapsed() < best->idleTime.elapsed())
+			best = &entry;
+	}
+	if (best)
+	{
+		best->busy = true;
+		best->engine->reuse(eventCallback);
+		return best->engine.get();
+	}
+	m_entries.push_back(Entry{ std::make_unique<UCIEngine>(path, eventCallback), true });
+	return m_entries.back().engine.get();
+}
+
+void EnginePool::release(UCIEngine* engine)
+{
+	auto it = std::find_if(m_entries.begin(), m_entries.end(),
+		[engine](const Entry& entry) {return entry.engine.get() == engine; });
+	if (it == m_entries.end())
+		return;
+	const UCIEngine::State state = engine->getState();
+	if (state != UCIEngine::State::Ready && state != UCIEngine::State::Searching
+		&& state != UCIEngine::State::Pondering || !engine->isAlive())
+	{ // Engine didn't finish initialization or is broken, so it's not worth keeping
+		closeEntry(*it);
+		m_entries.erase(it);
+		return;
+	}
+	engine->detach();
+	it->busy = false;
+	it->idleTime.start();
+	trimIdle();
+}
+
+void EnginePool::clear(void)
+{
+	for (auto& entry : m_entries)
+		if (!entry.busy)
+			closeEntry(entry);
+	m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(),
+		[](const Entry& entry) {return !entry.busy; }), m_entries.end());
+}
+
+void EnginePool::checkHealth(void)
+{
+	for (auto& entry : m_entries)
+	{
+		if (entry.busy)
+			continue;
+		if (entry.engine->isAlive(m_healthTimer.interval()))
+			entry.engine->sendPing();
+		else
+			closeEntry(entry);
+	}
+	m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(),
+		[](const Entry& entry) {return !entry.engine; }), m_entries.end());
+}
+
+void EnginePool::trimIdle(void)
+{
+	while (idleCount() > m_maxIdle)
+	{
+		auto oldest = m_entries.end();
+		for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+			if (!it->busy && (oldest == m_entries.end()
+				|| it->idleTime.elapsed() > oldest->idleTime.elapsed()))
+				oldest = it;
+		closeEntry(*oldest);
+		m_entries.erase(oldest);
+	}
+}
+
+void EnginePool::closeEntry(Entry& entry)
+{
+	if (!entry.engine)
+		return;
+	try
+	{
+		entry.engine->close();
+	}
+	catch (const std::runtime_error&)
+	{} // Process was killed, nothing else to do
+	entry.engine.reset();
+}
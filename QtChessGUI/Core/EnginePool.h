@@ -0,0 +1,53 @@
+#pragma once
+#include <QtCore>
+#include <memory>
+#include <vector>
+#include "UCIEngine.h"
+
+// Keeps engine processes alive between games, so that following games with the
+// same engine skip process startup, 'uci' handshake and (if options are unchanged)
+// hash reallocation. Engines are identified by path and set of option values
+class EnginePool
+{
+public:
+	EnginePool(int maxIdle = 4, int healthCheckInterval = 30000);
+	~EnginePool(void);
+	// Get engine for given path, reusing idle one if possible (the one which already has
+	// the options caller is going to set is preferred). In any case callback will receive
+	// UciOk and engine will be in SettingOptions state, like after UCIEngine::reset
+	UCIEngine* acquire(QString path, UCIEngine::Callback eventCallback,
+		const UCIEngine::OptionValues& options = {});
+	// Return engine acquired from this pool, stopping its search if needed
+	void release(UCIEngine* engine);
+	// Close all idle engines
+	void clear(void);
+	inline int idleCount(void) const noexcept;
+	inline int busyCount(void) const noexcept;
+private:
+	struct Entry
+	{
+		std::unique_ptr<UCIEngine> engine;
+		bool busy;
+		QElapsedTimer idleTime; // Time since release
+	};
+	// Ping idle engines and drop those which are dead or didn't answer the last ping
+	void checkHealth(void);
+	// Close engines exceeding idle limit, oldest released first
+	void trimIdle(void);
+	void closeEntry(Entry& entry);
+
+	std::vector<Entry> m_entries;
+	QTimer m_healthTimer;
+	int m_maxIdle;
+};
+
+inline int EnginePool::idleCount(void) const noexcept
+{
+	return int(std::count_if(m_entries.begin(), m_entries.end(),
+		[](const Entry& entry) {return !entry.busy; }));
+}
+
+inline int EnginePool::busyCount(void) const noexcept
+{
+	return int(m_entries.size()) - idleCount();
+}
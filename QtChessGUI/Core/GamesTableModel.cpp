@@ -0,0 +1,306 @@
+#include "GamesTableModel.h"
+#include "Database.h"
+
+namespace
+{
+	// Stands for unknown date in sort expression, so that such games come before all others
+	const char* const NULL_DATE = "0001-01-01";
+	// Expressions games are ordered by for each column. They never yield NULL (unknown
+	// date is NULL_DATE), since NULLs would break row value comparisons of keyset pagination
+	const char* const SORT_EXPRESSIONS[GamesTableModel::COLUMN_COUNT] = {
+		"games.id",
+		"games.whitePlayerId",
+		"games.blackPlayerId",
+		"COALESCE(we.name, wp.name, '')",
+		"CASE WHEN we.id IS NULL THEN 'Human' ELSE 'Engine' END",
+		"COALESCE(be.name, bp.name, '')",
+		"CASE WHEN be.id IS NULL THEN 'Human' ELSE 'Engine' END",
+		"COALESCE(games.date, '0001-01-01')", // NULL_DATE
+		"games.result"
+	};
+	const char* const HEADERS[GamesTableModel::COLUMN_COUNT] = {
+		"Id", "White Id", "Black Id", "White Name", "White Type",
+		"Black Name", "Black Type", "Date", "Result"
+	};
+}
+
+//============================================================
+// GamesPageFetcher
+//============================================================
+
+GamesPageFetcher::GamesPageFetcher(void)
+	: m_connectionName(QString("games_fetcher_%1").arg(quintptr(this)))
+{}
+
+GamesPageFetcher::~GamesPageFetcher(void)
+{
+	if (!QSqlDatabase::contains(m_connectionName))
+		return;
+	QSqlDatabase::database(m_connectionName, false).close();
+	QSqlDatabase::removeDatabase(m_connectionName);
+}
+
+void GamesPageFetcher::fetch(int generation, const QString& sql, const QVariantList& bindValues)
+{
+	// Connections can't be shared between threads, so fetcher has its own one
+	QSqlDatabase database = QSqlDatabase::contains(m_connectionName)
+		? QSqlDatabase::database(m_connectionName) : db::openDefault(m_connectionName);
+	if (!database.isOpen())
+	{
+		emit fetched(generation, {}, "Could not connect to database: " + database.lastError().text());
+		return;
+	}
+	QSqlQuery query(database);
+	query.setForwardOnly(true);
+	query.prepare(sql);
+	for (const QVariant& value : bindValues)
+		query.addBindValue(value);
+	if (!query.exec())
+	{
+		emit fetched(generation, {}, "Could not fetch games: " + query.lastError().text());
+		return;
+	}
+	QVariantList rows;
+	rows.reserve(GamesTableModel::PAGE_SIZE);
+	while (query.next())
+	{
+		QVariantList row;
+		row.reserve(GamesTableModel::COLUMN_COUNT);
+		for (int column = 0; column < GamesTableModel::COLUMN_COUNT; ++column)
+			row.append(query.value(column));
+		rows.append(QVariant(row));
+	}
+	emit fetched(generation, rows, QString());
+}
+
+//============================================================
+// GamesTableModel
+//============================================================
+
+GamesTableModel::GamesTableModel(QObject* parent, const Filter& filter)
+	: QAbstractTableModel(parent), m_filter(filter), m_sortColumn(DATE), m_sortOrder(Qt::DescendingOrder),
+	m_generation(0), m_requestPending(false), m_atEnd(false), m_fetchWanted(false),
+	m_hasPrefetched(false)
+{
+	GamesPageFetcher* fetcher = new GamesPageFetcher;
+	fetcher->moveToThread(&m_thread);
+	connect(&m_thread, &QThread::finished, fetcher, &QObject::deleteLater);
+	connect(this, &GamesTableModel::requestPage, fetcher, &GamesPageFetcher::fetch);
+	connect(fetcher, &GamesPageFetcher::fetched, this, &GamesTableModel::sPageFetched);
+	m_thread.start();
+	reload();
+}
+
+GamesTableModel::~GamesTableModel(void)
+{
+	m_thread.quit();
+	m_thread.wait();
+}
+
+void GamesTableModel::setFilter(const Filter& filter)
+{
+	m_filter = filter;
+	reload();
+}
+
+int GamesTableModel::gameId(int row) const
+{
+	return m_rows[row][ID].toInt();
+}
+
+int GamesTableModel::rowCount(const QModelIndex& parent) const
+{
+	return parent.isValid() ? 0 : m_rows.size();
+}
+
+int GamesTableModel::columnCount(const QModelIndex& parent) const
+{
+	return parent.isValid() ? 0 : COLUMN_COUNT;
+}
+
+QVariant GamesTableModel::data(const QModelIndex& index, int role) const
+{
+	if (!index.isValid() || role != Qt::DisplayRole)
+		return QVariant();
+	return m_rows[index.row()][index.column()];
+}
+
+QVariant GamesTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+	if (orientation != Qt::Horizontal || role != Qt::DisplayRole || section >= COLUMN_COUNT)
+		return QAbstractTableModel::headerData(section, orientation, role);
+	return HEADERS[section];
+}
+
+bool GamesTableModel::canFetchMore(const QModelIndex& parent) const
+{
+	return !parent.isValid() && (m_hasPrefetched || !m_atEnd);
+}
+
+void GamesTableModel::fetchMore(const QModelIndex& parent)
+{
+	if (parent.isValid())
+		return;
+	if (m_hasPrefetched)
+	{
+		m_hasPrefetched = false;
+		appendPage(m_prefetched);
+		m_prefetched.clear();
+		requestNextPage();
+	}
+	else
+	{ // Page will be shown as soon as it arrives
+		m_fetchWanted = true;
+		requestNextPage();
+	}
+}
+
+void GamesTableModel::sort(int column, Qt::SortOrder order)
+{
+	if (column < 0 || column >= COLUMN_COUNT || (column == m_sortColumn && order == m_sortOrder))
+		return;
+	m_sortColumn = column;
+	m_sortOrder = order;
+	reload();
+}
+
+void GamesTableModel::reload(void)
+{
+	beginResetModel();
+	m_rows.clear();
+	endResetModel();
+	++m_generation;
+	m_requestPending = m_atEnd = m_hasPrefetched = false;
+	m_prefetched.clear();
+	m_lastRow.clear();
+	m_fetchWanted = true; // First page is shown right away
+	m_reloadTimer.start();
+	requestNextPage();
+}
+
+void GamesTableModel::requestNextPage(void)
+{
+	if (m_requestPending || m_atEnd)
+		return;
+	QVariantList bindValues;
+	const QString sql = pageSQL(m_filter, m_sortColumn, m_sortOrder, m_lastRow, bindValues);
+	m_requestPending = true;
+	emit requestPage(m_generation, sql, bindValues);
+}
+
+QString GamesTableModel::pageSQL(const Filter& filter, int sortColumn, Qt::SortOrder order,
+	const QVariantList& lastRow, QVariantList& bindValues)
+{
+	QString clause;
+	QStringList conditions;
+	bindValues.clear();
+	if (filter.position)
+	{ // Each game is indexed at most once per position, so join doesn't duplicate rows
+		clause = "INNER JOIN game_positions gp ON gp.gameId = games.id ";
+		conditions << "gp.zobrist = ?";
+		bindValues << qint64(*filter.position);
+	}
+	if (filter.games)
+	{ // Ids are written into statement, since count of bound values is limited
+		QStringList ids;
+		ids.reserve(int(filter.games->size()));
+		for (int id : *filter.games)
+			ids << QString::number(id);
+		conditions << (ids.isEmpty() ? QString("1 = 0") : "games.id IN (" + ids.join(',') + ')');
+	}
+	if (!filter.player.isEmpty())
+	{
+		conditions << QString("(%1 LIKE ? OR %2 LIKE ?)")
+			.arg(SORT_EXPRESSIONS[WHITE_NAME], SORT_EXPRESSIONS[BLACK_NAME]);
+		const QString pattern = '%' + filter.player + '%';
+		bindValues << pattern << pattern;
+	}
+	if (filter.from.isValid())
+	{
+		conditions << "games.date >= ?";
+		bindValues << filter.from;
+	}
+	if (filter.to.isValid())
+	{
+		conditions << "games.date < ?";
+		bindValues << filter.to.addDays(1);
+	}
+	if (!filter.result.isEmpty())
+	{
+		conditions << "games.result = ?";
+		bindValues << filter.result;
+	}
+	// Continue right after the last fetched row in (sort value, id) order
+	const char* comparison = order == Qt::AscendingOrder ? ">" : "<";
+	const char* direction = order == Qt::AscendingOrder ? "ASC" : "DESC";
+	const QString sortExpression = SORT_EXPRESSIONS[sortColumn];
+	if (!lastRow.isEmpty())
+	{
+		if (sortColumn == ID)
+		{
+			conditions << QString("games.id %1 ?").arg(comparison);
+			bindValues << lastRow[ID];
+		}
+		else
+		{
+			conditions << QString("(%1 %2 ? OR (%1 = ? AND games.id %2 ?))")
+				.arg(sortExpression, comparison);
+			// Row holds the column itself, so it's converted to the value of sort expression.
+			// Dates are compared as ISO strings, which both backends get from COALESCE
+			QVariant lastValue = lastRow[sortColumn];
+			if (sortColumn == DATE)
+				lastValue = lastValue.isNull() ? QString(NULL_DATE) : lastValue.toDate().toString(Qt::ISODate);
+			else if (lastValue.isNull())
+				lastValue = QString("");
+			bindValues << lastValue << lastValue << lastRow[ID];
+		}
+	}
+	if (!conditions.isEmpty())
+		clause += "WHERE " + conditions.join(" AND ") + ' ';
+	if (sortColumn == ID)
+		clause += QString("ORDER BY games.id %1 ").arg(direction);
+	else
+		clause += QString("ORDER BY %1 %2, games.id %2 ").arg(sortExpression, direction);
+	clause += QString("LIMIT %1").arg(PAGE_SIZE);
+	return db::gamesListSQL(clause);
+}
+
+void GamesTableModel::appendPage(const QVariantList& rows)
+{
+	if (rows.isEmpty())
+		return;
+	beginInsertRows(QModelIndex(), m_rows.size(), m_rows.size() + rows.size() - 1);
+	for (const QVariant& row : rows)
+		m_rows.append(row.toList());
+	endInsertRows();
+}
+
+void GamesTableModel::sPageFetched(int generation, const QVariantList& rows, const QString& error)
+{
+	if (generation != m_generation)
+		return; // Filter or sorting has changed since the request
+	m_requestPending = false;
+	if (!error.isEmpty())
+	{
+		m_atEnd = true;
+		emit errorOccurred(error);
+		return;
+	}
+	const bool firstPage = m_lastRow.isEmpty();
+	m_atEnd = rows.size() < PAGE_SIZE;
+	if (!rows.isEmpty())
+		m_lastRow = rows.last().toList();
+	if (m_fetchWanted)
+	{
+		m_fetchWanted = false;
+		appendPage(rows);
+		if (firstPage)
+			emit firstPageLoaded(m_reloadTimer.elapsed());
+		requestNextPage(); // Prefetch
+	}
+	else
+	{
+		m_prefetched = rows;
+		m_hasPrefetched = !rows.isEmpty();
+	}
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QThread>
+#include <QDate>
+#include <QtSql>
+#include <optional>
+#include <vector>
+#include "../Engine/engine.h"
+
+// Runs page queries on its own database connection in a background thread
+class GamesPageFetcher : public QObject
+{
+	Q_OBJECT
+
+public:
+	GamesPageFetcher(void);
+	~GamesPageFetcher(void);
+	// Execute query and emit fetched with its rows (each one is QVariantList)
+	void fetch(int generation, const QString& sql, const QVariantList& bindValues);
+signals:
+	void fetched(int generation, const QVariantList& rows, const QString& error);
+private:
+	QString m_connectionName;
+};
+
+// Games list (columns of db::gamesListSQL) loaded page by page using keyset pagination,
+// so opening and scrolling cost the same regardless of the number of stored games.
+// Filtering and sorting are done by the database server. While the view shows
+// loaded rows the next page is already being fetched in the background
+class GamesTableModel : public QAbstractTableModel
+{
+	Q_OBJECT
+
+public:
+	enum Column {
+		ID, WHITE_PLAYER_ID, BLACK_PLAYER_ID, WHITE_NAME, WHITE_TYPE,
+		BLACK_NAME, BLACK_TYPE, DATE, RESULT, COLUMN_COUNT
+	};
+	struct Filter
+	{
+		QString player; // Part of either player's name
+		QDate from, to; // Inclusive, null means unbounded
+		QString result; // games.result value, empty means any
+		std::optional<BlendXChess::Key> position; // Games which reached it (see Game::getPositionKey)
+		std::optional<std::vector<int>> games; // Only games with these ids (e.g. found by PatternIndex)
+	};
+	static constexpr int PAGE_SIZE = 200;
+
+	GamesTableModel(QObject* parent = nullptr, const Filter& filter = Filter());
+	~GamesTableModel(void);
+	// Restrict shown games and reload from the first page
+	void setFilter(const Filter& filter);
+	inline const Filter& filter(void) const noexcept;
+	// Id of the game shown in given row
+	int gameId(int row) const;
+	int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+	int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+	QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+	QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+	bool canFetchMore(const QModelIndex& parent) const override;
+	void fetchMore(const QModelIndex& parent) override;
+	void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+	// Statement of the page which follows lastRow (the first page if it's empty) in given order,
+	// with values to bind into bindValues
+	static QString pageSQL(const Filter& filter, int sortColumn, Qt::SortOrder order,
+		const QVariantList& lastRow, QVariantList& bindValues);
+signals:
+	void errorOccurred(const QString& error);
+	// Emitted with number of milliseconds it took to receive the first page after reload
+	void firstPageLoaded(qint64 elapsed);
+	void requestPage(int generation, const QString& sql, const QVariantList& bindValues);
+private:
+	void reload(void);
+	void requestNextPage(void);
+	void appendPage(const QVariantList& rows);
+	void sPageFetched(int generation, const QVariantList& rows, const QString& error);
+
+	Filter m_filter;
+	int m_sortColumn;
+	Qt::SortOrder m_sortOrder;
+	QVector<QVariantList> m_rows;
+	// Last fetched row (possibly a prefetched one), the next page starts after it
+	QVariantList m_lastRow;
+	// Incremented on every reload so that pages of previous queries are dropped
+	int m_generation;
+	bool m_requestPending;
+	bool m_atEnd;
+	// View asked for more rows before the requested page arrived
+	bool m_fetchWanted;
+	// Prefetched page which the view hasn't asked for yet
+	QVariantList m_prefetched;
+	bool m_hasPrefetched;
+	QElapsedTimer m_reloadTimer;
+	QThread m_thread;
+};
+
+inline const GamesTableModel::Filter& GamesTableModel::filter(void) const noexcept
+{
+	return m_filter;
+}
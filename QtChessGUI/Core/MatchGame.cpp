@@ -0,0 +1,224 @@
+#include "MatchGame.h"
+#include <algorithm>
+
+using namespace BlendXChess;
+
+MatchGame::MatchGame(int slot, quint64 cpuMask, QObject* parent)
+	: QObject(parent), m_slot(slot), m_cpuMask(cpuMask), m_playing(false), m_started(false),
+	m_engines{ nullptr, nullptr }, m_clock{ 0, 0 }
+{
+	m_timeoutTimer = new QTimer(this);
+	m_timeoutTimer->setSingleShot(true);
+	connect(m_timeoutTimer, &QTimer::timeout, this, &MatchGame::sMoveTimeout);
+}
+
+MatchGame::~MatchGame(void)
+{
+	for (auto& engine : m_engines)
+		if (engine)
+			m_pool->release(engine);
+}
+
+void MatchGame::play(const MatchSetup& setup)
+{
+	m_setup = setup;
+	m_playing = true;
+	m_started = false;
+	m_moves.clear();
+	m_game.reset();
+	if (!m_pool)
+		m_pool = std::make_unique<EnginePool>(2);
+	const MatchEngine* participants[COLOR_CNT] = { &setup.whiteEngine, &setup.blackEngine };
+	try
+	{
+		for (Side side : {WHITE, BLACK})
+		{
+			m_engines[side] = m_pool->acquire(participants[side]->path,
+				[this](UCIEngine* sender, const UCIEventInfo* eventInfo) {
+				eventCallback(sender, eventInfo); }, participants[side]->options);
+			if (m_cpuMask)
+				m_engines[side]->setAffinity(m_cpuMask);
+		}
+	}
+	catch (const std::runtime_error& err)
+	{
+		finish("*", QString("engine failed to start: ") + err.what());
+	}
+}
+
+void MatchGame::eventCallback(UCIEngine* sender, const UCIEventInfo* eventInfo)
+{
+	if (!m_playing)
+		return;
+	const Side side = sender == m_engines[WHITE] ? WHITE : BLACK;
+	switch (eventInfo->type)
+	{
+	case UCIEventInfo::Type::UciOk:
+		try
+		{
+			applyOptions(sender, side == WHITE ? m_setup.whiteEngine : m_setup.blackEngine);
+		}
+		catch (const std::runtime_error& err)
+		{
+			finish("*", QString("could not set options: ") + err.what());
+			return;
+		}
+		sender->sendNewGame();
+		sender->sendIsReady();
+		break;
+	case UCIEventInfo::Type::ReadyOk:
+		if (!m_started && m_engines[WHITE]->getState() == UCIEngine::State::Ready
+			&& m_engines[BLACK]->getState() == UCIEngine::State::Ready)
+			startGame();
+		break;
+	case UCIEventInfo::Type::BestMove:
+		if (m_started && sender == m_engines[m_game.getPosition().getTurn()])
+			onBestMove(eventInfo->bestMove);
+		break;
+	case UCIEventInfo::Type::Error:
+		if (sender->getState() == UCIEngine::State::NotSet) // Process has terminated
+			finish(side == WHITE ? "0-1" : "1-0", QString(side == WHITE ? "White" : "Black")
+				+ " engine crashed");
+		break;
+	default:
+		break;
+	}
+}
+
+void MatchGame::applyOptions(UCIEngine* engine, const MatchEngine& participant)
+{
+	for (const auto& [name, value] : participant.options)
+		engine->setOptionFromString(name, value);
+}
+
+void MatchGame::startGame(void)
+{
+	m_started = true;
+	const Opening& opening = m_setup.opening;
+	if (opening.fen.empty())
+		m_game.reset();
+	else
+		m_game.loadFEN(opening.fen, true);
+	for (const auto& move : opening.moves)
+	{
+		m_game.DoMove(move, FMT_UCI); // Book is validated when loaded
+		m_moves.push_back(move);
+	}
+	m_clock[WHITE] = m_clock[BLACK] = m_setup.timeControl.base;
+	emit positionChanged(m_slot, QString::fromStdString(m_game.getPositionFEN()));
+	adjudicate();
+	if (m_playing)
+		goEngine();
+}
+
+void MatchGame::goEngine(void)
+{
+	const Side side = m_game.getPosition().getTurn();
+	const TimeControl& timeControl = m_setup.timeControl;
+	SearchLimits limits;
+	limits.depth = timeControl.depth;
+	limits.movetime = timeControl.movetime;
+	int timeout = timeControl.movetime + m_setup.moveTimeout;
+	if (timeControl.base > 0)
+	{
+		limits.wtime = m_clock[WHITE];
+		limits.btime = m_clock[BLACK];
+		limits.winc = limits.binc = timeControl.increment;
+		timeout = m_clock[side] + m_setup.timeMargin;
+	}
+	m_engines[side]->sendPosition(m_setup.opening.fen.empty() ? "startpos" : m_setup.opening.fen, m_moves);
+	m_engines[side]->sendGo(limits);
+	m_moveTime.start();
+	m_timeoutTimer->start(timeout);
+}
+
+void MatchGame::onBestMove(const std::string& move)
+{
+	m_timeoutTimer->stop();
+	const Side side = m_game.getPosition().getTurn();
+	const QString sideName = side == WHITE ? "White" : "Black";
+	const QString loss = side == WHITE ? "0-1" : "1-0";
+	if (m_setup.timeControl.base > 0)
+	{
+		m_clock[side] -= int(m_moveTime.elapsed());
+		if (m_clock[side] < -m_setup.timeMargin)
+		{
+			finish(loss, sideName + " loses on time");
+			return;
+		}
+		m_clock[side] = std::max(m_clock[side], 0) + m_setup.timeControl.increment;
+	}
+	if (!m_game.DoMove(move, FMT_UCI))
+	{
+		finish(loss, sideName + " made illegal move " + QString::fromStdString(move));
+		return;
+	}
+	m_moves.push_back(move);
+	emit positionChanged(m_slot, QString::fromStdString(m_game.getPositionFEN()));
+	adjudicate();
+	if (!m_playing)
+		return;
+	if (m_setup.maxPlies > 0 && int(m_moves.size()) >= m_setup.maxPlies)
+		finish("1/2-1/2", "adjudicated draw by move limit");
+	else
+		goEngine();
+}
+
+void MatchGame::adjudicate(void)
+{
+	switch (m_game.getGameState())
+	{
+	case GameState::WHITE_WIN:
+		finish("1-0", "White mates");
+		break;
+	case GameState::BLACK_WIN:
+		finish("0-1", "Black mates");
+		break;
+	case GameState::DRAW:
+		switch (m_game.getDrawCause())
+		{
+		case DrawCause::RULE_50: finish("1/2-1/2", "draw by fifty moves rule"); break;
+		case DrawCause::MATERIAL: finish("1/2-1/2", "draw by insufficient material"); break;
+		case DrawCause::THREEFOLD_REPETITION: finish("1/2-1/2", "draw by threefold repetition"); break;
+		case DrawCause::STALEMATE: finish("1/2-1/2", "draw by stalemate"); break;
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void MatchGame::finish(const QString& result, const QString& termination)
+{
+	m_playing = false;
+	m_timeoutTimer->stop();
+	MatchResult matchResult;
+	matchResult.gameIndex = m_setup.gameIndex;
+	matchResult.pairIndex = m_setup.pairIndex;
+	matchResult.round = m_setup.round;
+	matchResult.white = m_setup.white;
+	matchResult.black = m_setup.black;
+	matchResult.result = result;
+	matchResult.termination = termination;
+	matchResult.startFEN = QString::fromStdString(m_setup.opening.fen);
+	matchResult.movetext = QString::fromStdString(m_game.getGame());
+	matchResult.moves = m_game.getMoves();
+	matchResult.plies = int(m_moves.size());
+	// We may be inside engine's callback here, so engines are released after it returns
+	QMetaObject::invokeMethod(this, [this, matchResult]() {
+		for (auto& engine : m_engines)
+			if (engine)
+				m_pool->release(engine), engine = nullptr;
+		emit finished(m_slot, matchResult);
+	}, Qt::QueuedConnection);
+}
+
+void MatchGame::sMoveTimeout(void)
+{
+	if (!m_playing)
+		return;
+	const Side side = m_game.getPosition().getTurn();
+	const QString sideName = side == WHITE ? "White" : "Black";
+	finish(side == WHITE ? "0-1" : "1-0", sideName + (m_setup.timeControl.base > 0
+		? " loses on time" : " engine stalled"));
+}
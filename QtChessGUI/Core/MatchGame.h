@@ -0,0 +1,106 @@
+#pragma once
+#include <QtCore>
+#include <memory>
+#include <vector>
+#include "UCIEngine.h"
+#include "EnginePool.h"
+#include "OpeningBook.h"
+#include "../Engine/engine.h"
+
+// Participant of engine match or tournament
+struct MatchEngine
+{
+	QString name;
+	QString path;
+	int playerId = -1; // Id in engine_players table, -1 if engine is given by path
+	std::vector<std::pair<std::string, std::string>> options; // Set before every game
+};
+
+// Search limits of match games. If base time is set, engines play with clock
+struct TimeControl
+{
+	int depth = 0;
+	int movetime = 0; // ms
+	int base = 0; // ms
+	int increment = 0; // ms
+};
+
+// Everything needed to play a single game
+struct MatchSetup
+{
+	int gameIndex = 0;
+	int pairIndex = 0; // Games of one opening with reversed colors have same pair index
+	int round = 0; // Tournament round (from 0), each pairing of engines is played once in it
+	int white = 0, black = 0; // Indices of participants in tournament
+	MatchEngine whiteEngine, blackEngine;
+	Opening opening;
+	TimeControl timeControl;
+	int maxPlies = 0; // Adjudicate draw after this many plies (0 for no limit)
+	int moveTimeout = 30000; // ms, engine not answering in time (besides its clock) is considered stalled
+	int timeMargin = 50; // ms, allowed clock overrun due to communication delays
+};
+
+struct MatchResult
+{
+	int gameIndex = 0;
+	int pairIndex = 0;
+	int round = 0;
+	int white = 0, black = 0;
+	QString result; // "1-0", "0-1", "1/2-1/2" or "*" if game was aborted
+	QString termination;
+	QString startFEN; // Empty for standard start position
+	QString movetext;
+	std::vector<BlendXChess::Move> moves;
+	int plies = 0;
+};
+Q_DECLARE_METATYPE(MatchResult)
+
+// Plays engine games one at a time, reporting results with a signal. Meant to live in a worker
+// thread (all methods should be called from it), engine processes are kept warm between games
+class MatchGame : public QObject
+{
+	Q_OBJECT
+
+public:
+	MatchGame(int slot, quint64 cpuMask = 0, QObject* parent = nullptr);
+	~MatchGame(void);
+	inline int slot(void) const noexcept;
+	inline bool isPlaying(void) const noexcept;
+	void play(const MatchSetup& setup);
+signals:
+	void finished(int slot, const MatchResult& result);
+	void positionChanged(int slot, const QString& fen);
+private:
+	void eventCallback(UCIEngine* sender, const UCIEventInfo* eventInfo);
+	void applyOptions(UCIEngine* engine, const MatchEngine& participant);
+	void startGame(void);
+	void goEngine(void);
+	void onBestMove(const std::string& move);
+	// Game result by state of m_game, if it is finished
+	void adjudicate(void);
+	void finish(const QString& result, const QString& termination);
+	void sMoveTimeout(void);
+	// Data
+	int m_slot;
+	quint64 m_cpuMask; // Engine processes are pinned to these CPUs if non-zero
+	bool m_playing;
+	bool m_started;
+	MatchSetup m_setup;
+	BlendXChess::Game m_game;
+	std::vector<std::string> m_moves; // Made from start position, UCI format
+	std::unique_ptr<EnginePool> m_pool; // Created in the worker thread on first game
+	UCIEngine* m_engines[BlendXChess::COLOR_CNT];
+	int m_clock[BlendXChess::COLOR_CNT]; // ms
+	QElapsedTimer m_moveTime;
+	QTimer* m_timeoutTimer;
+};
+
+inline int MatchGame::slot(void) const noexcept
+{
+	return m_slot;
+}
+
+inline bool MatchGame::isPlaying(void) const noexcept
+{
+	return m_playing;
+}
@@ -0,0 +1,169 @@
+#include "MatchStats.h"
+#include <cmath>
+#include <limits>
+#include <sstream>
+#include <iomanip>
+
+namespace
+{
+	double normalCDF(double x)
+	{
+		return 0.5 * std::erfc(-x / std::sqrt(2.0));
+	}
+
+	// Inverse of normalCDF by bisection (it's called rarely, so precision matters more than speed)
+	double normalQuantile(double p)
+	{
+		double low = -10.0, high = 10.0;
+		for (int iter = 0; iter < 100; ++iter)
+		{
+			const double mid = (low + high) / 2;
+			(normalCDF(mid) < p ? low : high) = mid;
+		}
+		return (low + high) / 2;
+	}
+
+	double regularized(int count, double regularization)
+	{
+		return count == 0 ? regularization : count;
+	}
+
+	// Count given to outcomes which haven't happened when computing LLR
+	constexpr double LLR_REGULARIZATION = 0.5;
+}
+
+MatchStats::MatchStats(void)
+	: m_wins(0), m_draws(0), m_losses(0), m_pentanomial{}, m_pairs(0)
+{}
+
+void MatchStats::addGame(double score)
+{
+	if (score > 0.75)
+		++m_wins;
+	else if (score < 0.25)
+		++m_losses;
+	else
+		++m_draws;
+}
+
+void MatchStats::addPair(double firstScore, double secondScore)
+{
+	++m_pentanomial[int(std::lround(2 * (firstScore + secondScore)))];
+	++m_pairs;
+}
+
+double MatchStats::score(void) const
+{
+	return games() == 0 ? 0.5 : (m_wins + 0.5 * m_draws) / games();
+}
+
+double MatchStats::eloDiff(void) const
+{
+	return scoreToElo(score());
+}
+
+std::pair<double, double> MatchStats::eloInterval(double confidence) const
+{
+	const bool byPairs = m_pairs > 0;
+	const auto [mean, variance] = byPairs ? pentanomialMoments() : trinomialMoments();
+	const int samples = byPairs ? m_pairs : games();
+	if (samples == 0)
+		return { 0.0, 0.0 };
+	const double margin = normalQuantile(0.5 + confidence / 2) * std::sqrt(variance / samples);
+	return { scoreToElo(mean - margin), scoreToElo(mean + margin) };
+}
+
+double MatchStats::los(void) const
+{
+	if (m_wins + m_losses == 0)
+		return 0.5;
+	return normalCDF((m_wins - m_losses) / std::sqrt(double(m_wins + m_losses)));
+}
+
+double MatchStats::llr(const SPRTParams& params) const
+{
+	const bool byPairs = m_pairs > 0;
+	// One-sided results (eg only wins) would have zero variance, so outcomes which haven't
+	// happened get small counts and the test can still stop on such results
+	const auto [mean, variance] = byPairs ? pentanomialMoments(LLR_REGULARIZATION)
+		: trinomialMoments(LLR_REGULARIZATION);
+	const int samples = byPairs ? m_pairs : games();
+	if (samples == 0)
+		return 0.0;
+	const double score0 = eloToScore(params.elo0), score1 = eloToScore(params.elo1);
+	return samples * (score1 - score0) * (2 * mean - score0 - score1) / (2 * variance);
+}
+
+MatchStats::SPRTResult MatchStats::sprt(const SPRTParams& params) const
+{
+	const double ratio = llr(params);
+	if (ratio >= params.upperBound())
+		return SPRTResult::AcceptH1;
+	if (ratio <= params.lowerBound())
+		return SPRTResult::AcceptH0;
+	return SPRTResult::Continue;
+}
+
+std::string MatchStats::summary(const SPRTParams* params) const
+{
+	std::ostringstream oss;
+	const auto [low, high] = eloInterval();
+	oss << std::fixed << std::setprecision(1) << "Elo " << eloDiff() << " [" << low << ", " << high
+		<< "], LOS " << los() * 100 << "%, +" << m_wins << " =" << m_draws << " -" << m_losses;
+	if (m_pairs > 0)
+	{
+		oss << ", pairs";
+		for (int count : m_pentanomial)
+			oss << ' ' << count;
+	}
+	if (params)
+		oss << std::setprecision(2) << ", LLR " << llr(*params) << " ["
+			<< params->lowerBound() << ", " << params->upperBound() << ']';
+	return oss.str();
+}
+
+double MatchStats::eloToScore(double elo)
+{
+	return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+double MatchStats::scoreToElo(double score)
+{
+	if (score <= 0.0)
+		return -std::numeric_limits<double>::infinity();
+	if (score >= 1.0)
+		return std::numeric_limits<double>::infinity();
+	return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+std::pair<double, double> MatchStats::trinomialMoments(double regularization) const
+{
+	if (games() == 0)
+		return { 0.5, 0.0 };
+	const double wins = regularized(m_wins, regularization), draws = regularized(m_draws, regularization),
+		losses = regularized(m_losses, regularization);
+	const double count = wins + draws + losses;
+	const double mean = (wins + 0.5 * draws) / count;
+	const double variance = (wins * std::pow(1.0 - mean, 2) + draws * std::pow(0.5 - mean, 2)
+		+ losses * std::pow(mean, 2)) / count;
+	return { mean, variance };
+}
+
+std::pair<double, double> MatchStats::pentanomialMoments(double regularization) const
+{
+	if (m_pairs == 0)
+		return { 0.5, 0.0 };
+	// Per-game score of a pair is one of 0, 0.25, 0.5, 0.75, 1
+	double counts[5], count = 0.0, mean = 0.0;
+	for (int i = 0; i < 5; ++i)
+	{
+		counts[i] = regularized(m_pentanomial[i], regularization);
+		count += counts[i];
+		mean += counts[i] * (i / 4.0);
+	}
+	mean /= count;
+	double variance = 0.0;
+	for (int i = 0; i < 5; ++i)
+		variance += counts[i] * std::pow(i / 4.0 - mean, 2);
+	return { mean, variance / count };
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <array>
+#include <cmath>
+#include <string>
+#include <utility>
+
+// Statistics of a match between two engines (or one engine and a field of opponents),
+// updated incrementally as games finish. Scores are from the first engine's point of view
+class MatchStats
+{
+public:
+	// Parameters of sequential probability ratio test of H0: elo = elo0 against H1: elo = elo1
+	struct SPRTParams
+	{
+		double elo0 = 0.0;
+		double elo1 = 5.0;
+		double alpha = 0.05; // Probability to accept H1 when H0 is true
+		double beta = 0.05; // Probability to accept H0 when H1 is true
+		inline double lowerBound(void) const;
+		inline double upperBound(void) const;
+	};
+	enum class SPRTResult {
+		Continue, AcceptH0, AcceptH1
+	};
+	MatchStats(void);
+	// Score is 1, 0.5 or 0
+	void addGame(double score);
+	// Both games of one opening with reversed colors (which are also added with addGame).
+	// Pair statistics account for opening bias and correlation of paired games
+	void addPair(double firstScore, double secondScore);
+	inline int wins(void) const noexcept;
+	inline int draws(void) const noexcept;
+	inline int losses(void) const noexcept;
+	inline int games(void) const noexcept;
+	inline int pairs(void) const noexcept;
+	// Counts of pairs with total score 0, 0.5, 1, 1.5 and 2
+	inline const std::array<int, 5>& pentanomial(void) const noexcept;
+	// Mean score per game
+	double score(void) const;
+	double eloDiff(void) const;
+	// Elo difference interval for given confidence level (pair statistics are used if there are pairs)
+	std::pair<double, double> eloInterval(double confidence = 0.95) const;
+	// Likelihood of superiority, probability that the first engine is stronger
+	double los(void) const;
+	// Log-likelihood ratio of H1 to H0 (generalized SPRT, normal approximation)
+	double llr(const SPRTParams& params) const;
+	SPRTResult sprt(const SPRTParams& params) const;
+	// One-line summary of all statistics, including SPRT if params are given
+	std::string summary(const SPRTParams* params = nullptr) const;
+	// Conversions between expected score and logistic Elo difference
+	static double eloToScore(double elo);
+	static double scoreToElo(double score);
+private:
+	// Mean and variance of per-game score, by game or by pair results. Outcomes which
+	// haven't happened are counted as given fraction of a game (or pair)
+	std::pair<double, double> trinomialMoments(double regularization = 0.0) const;
+	std::pair<double, double> pentanomialMoments(double regularization = 0.0) const;
+	int m_wins, m_draws, m_losses;
+	std::array<int, 5> m_pentanomial;
+	int m_pairs;
+};
+
+inline double MatchStats::SPRTParams::lowerBound(void) const
+{
+	return std::log(beta / (1.0 - alpha));
+}
+
+inline double MatchStats::SPRTParams::upperBound(void) const
+{
+	return std::log((1.0 - beta) / alpha);
+}
+
+inline int MatchStats::wins(void) const noexcept
+{
+	return m_wins;
+}
+
+inline int MatchStats::draws(void) const noexcept
+{
+	return m_draws;
+}
+
+inline int MatchStats::losses(void) const noexcept
+{
+	return m_losses;
+}
+
+inline int MatchStats::games(void) const noexcept
+{
+	return m_wins + m_draws + m_losses;
+}
+
+inline int MatchStats::pairs(void) const noexcept
+{
+	return m_pairs;
+}
+
+inline const std::array<int, 5>& MatchStats::pentanomial(void) const noexcept
+{
+	return m_pentanomial;
+}
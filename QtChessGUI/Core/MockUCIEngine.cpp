@@ -0,0 +1,249 @@
+#include "MockUCIEngine.h"
+#include <sstream>
+#include <cstring>
+
+using namespace BlendXChess;
+
+bool MockUCIEngine::isMockPath(const QString& path)
+{
+	return path.startsWith("mock:");
+}
+
+MockUCIEngine::Config MockUCIEngine::parseConfig(const QString& path)
+{
+	Config config;
+	for (const QString& param : path.mid(5).split(';', QString::SkipEmptyParts))
+	{
+		const QString name = param.section('=', 0, 0).trimmed();
+		const QString value = param.section('=', 1).trimmed();
+		if (name == "name")
+			config.name = value.toStdString();
+		else if (name == "options")
+			config.options = value.toInt();
+		else if (name == "info")
+			config.infoLines = value.toInt();
+		else if (name == "delay")
+			config.delay = value.toInt();
+		else if (name == "latency")
+			config.latency = value.toInt();
+		else if (name == "seed")
+			config.seed = value.toUInt();
+		else if (name == "fault")
+		{ // kind[@searchNumber]
+			const QString kind = value.section('@', 0, 0);
+			if (value.contains('@'))
+				config.faultAt = value.section('@', 1).toInt();
+			if (kind == "crash")
+				config.fault = Fault::Crash;
+			else if (kind == "stall")
+				config.fault = Fault::Stall;
+			else if (kind == "garbage")
+				config.fault = Fault::Garbage;
+			else
+				throw std::runtime_error("Unknown mock engine fault " + kind.toStdString());
+		}
+		else
+			throw std::runtime_error("Unknown mock engine parameter " + name.toStdString());
+	}
+	return config;
+}
+
+MockUCIEngine::MockUCIEngine(const Config& config, QObject* parent)
+	: QIODevice(parent), m_config(config), m_rng(config.seed), m_goCount(0), m_infoSent(0),
+	m_searching(false), m_infinite(false), m_crashed(false)
+{
+	m_game.reset();
+	m_searchTimer.setInterval(std::max(1, std::min(10, m_config.delay)));
+	QObject::connect(&m_searchTimer, &QTimer::timeout, this, &MockUCIEngine::continueSearch);
+	open(QIODevice::ReadWrite | QIODevice::Unbuffered);
+}
+
+MockUCIEngine::~MockUCIEngine(void)
+{}
+
+bool MockUCIEngine::isSequential(void) const
+{
+	return true;
+}
+
+qint64 MockUCIEngine::bytesAvailable(void) const
+{
+	return m_output.size() + QIODevice::bytesAvailable();
+}
+
+bool MockUCIEngine::canReadLine(void) const
+{
+	return m_output.contains('\n') || QIODevice::canReadLine();
+}
+
+qint64 MockUCIEngine::readData(char* data, qint64 maxSize)
+{
+	const qint64 size = std::min(maxSize, qint64(m_output.size()));
+	memcpy(data, m_output.constData(), size_t(size));
+	m_output.remove(0, int(size));
+	return size;
+}
+
+qint64 MockUCIEngine::readLineData(char* data, qint64 maxSize)
+{
+	// Default implementation reads by one char, which would dominate info throughput measurements
+	const int newline = m_output.indexOf('\n');
+	return readData(data, newline < 0 ? maxSize : std::min(maxSize, qint64(newline) + 1));
+}
+
+qint64 MockUCIEngine::writeData(const char* data, qint64 size)
+{
+	if (m_crashed)
+		return -1;
+	m_input.append(data, int(size));
+	int newline;
+	while ((newline = m_input.indexOf('\n')) >= 0)
+	{
+		const std::string line = m_input.left(newline).toStdString();
+		m_input.remove(0, newline + 1);
+		processCommand(line);
+		if (m_crashed)
+			break;
+	}
+	return size;
+}
+
+void MockUCIEngine::processCommand(const std::string& line)
+{
+	std::istringstream iss(line);
+	std::string cmd;
+	iss >> cmd;
+	if (cmd == "uci")
+	{
+		std::string reply = "id name " + m_config.name + "\nid author BlendXGui\n"
+			"option name Hash type spin default 16 min 1 max 1024\n"
+			"option name Threads type spin default 1 min 1 max 64\n"
+			"option name Ponder type check default false\n";
+		for (int i = 1; i <= m_config.options; ++i)
+			reply += "option name Option" + std::to_string(i) + " type spin default 0 min 0 max 100\n";
+		send(reply + "uciok\n", m_config.latency);
+	}
+	else if (cmd == "isready")
+		send("readyok\n", m_config.latency);
+	else if (cmd == "ucinewgame")
+		m_game.reset();
+	else if (cmd == "position")
+		setPosition(iss);
+	else if (cmd == "go")
+	{
+		std::string token;
+		bool infinite = false;
+		while (iss >> token)
+			infinite |= token == "ponder" || token == "infinite";
+		startSearch(infinite);
+	}
+	else if (cmd == "ponderhit" && m_searching)
+	{
+		m_infinite = false;
+		m_searchTime.start();
+	}
+	else if (cmd == "stop" && m_searching && m_config.fault != Fault::Stall)
+		finishSearch();
+	else if (cmd == "quit")
+		crash();
+	// 'setoption' and unknown commands are silently accepted
+}
+
+void MockUCIEngine::setPosition(std::istream& iss)
+{
+	std::string token, fen;
+	iss >> token;
+	if (token == "startpos")
+		m_game.reset(), iss >> token;
+	else if (token == "fen")
+	{
+		while (iss >> token && token != "moves")
+			fen += token + ' ';
+		m_game.loadFEN(fen, true);
+	}
+	if (token == "moves")
+		while (iss >> token)
+			m_game.DoMove(token, FMT_UCI);
+}
+
+void MockUCIEngine::startSearch(bool infinite)
+{
+	++m_goCount;
+	const bool faulty = m_config.fault != Fault::None && m_goCount >= m_config.faultAt;
+	if (faulty && m_config.fault == Fault::Crash)
+	{
+		crash();
+		return;
+	}
+	// Move is chosen right away, search only imitates time spent
+	MoveList moves;
+	m_game.generateLegalMoves(moves);
+	if (moves.empty())
+		m_bestMove = "(none)";
+	else
+		m_bestMove = moves[m_config.seed ? int(m_rng() % moves.count()) : 0].toUCI();
+	m_searching = true;
+	m_infinite = infinite;
+	m_infoSent = 0;
+	m_searchTime.start();
+	if (faulty && m_config.fault == Fault::Stall)
+		return;
+	if (faulty && m_config.fault == Fault::Garbage)
+		send("info depth\n\x01\x02garbage\nbestmove\noption name\ninfo score cp\n", 0);
+	continueSearch();
+	if (m_searching)
+		m_searchTimer.start();
+}
+
+void MockUCIEngine::continueSearch(void)
+{
+	const qint64 elapsed = m_searchTime.elapsed();
+	const bool timeIsOver = !m_infinite && elapsed >= m_config.delay;
+	const int infoDue = timeIsOver || m_config.delay == 0 ? m_config.infoLines
+		: int(std::min<qint64>(m_config.infoLines, m_config.infoLines * elapsed / m_config.delay));
+	if (infoDue > m_infoSent)
+	{
+		std::string lines;
+		for (; m_infoSent < infoDue; ++m_infoSent)
+			lines += infoLine(m_infoSent);
+		send(lines, 0);
+	}
+	if (timeIsOver)
+		finishSearch();
+}
+
+void MockUCIEngine::finishSearch(void)
+{
+	m_searchTimer.stop();
+	m_searching = false;
+	send("bestmove " + m_bestMove + '\n', 0);
+}
+
+std::string MockUCIEngine::infoLine(int index) const
+{
+	const int depth = index + 1;
+	const long long nodes = 1000LL * depth * depth;
+	return "info depth " + std::to_string(depth) + " seldepth " + std::to_string(depth + 2)
+		+ " score cp " + std::to_string(index % 50 - 25) + " nodes " + std::to_string(nodes)
+		+ " nps 1000000 time " + std::to_string(nodes / 1000) + " pv " + m_bestMove + '\n';
+}
+
+void MockUCIEngine::send(const std::string& lines, int delay)
+{
+	QTimer::singleShot(delay, this, [this, lines]() {
+		if (m_crashed)
+			return;
+		m_output.append(lines.data(), int(lines.size()));
+		emit readyRead();
+	});
+}
+
+void MockUCIEngine::crash(void)
+{
+	m_crashed = true;
+	m_searching = false;
+	m_searchTimer.stop();
+	QTimer::singleShot(m_config.latency, this, [this]() {
+		emit readChannelFinished();
+	});
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <QtCore>
+#include <random>
+#include "../Engine/engine.h"
+
+// In-process stand-in for an engine process, used by UCIEngine instead of QProcess when engine
+// path starts with "mock:". Behaviour is given by parameters in the path, eg
+// "mock:name=Fast;options=20;info=500;delay=10;latency=1;fault=crash@3;seed=7".
+// Commands are answered asynchronously through the event loop, as a real process would do,
+// and legal moves are played, so the mock can take part in real games and tournaments
+class MockUCIEngine : public QIODevice
+{
+public:
+	enum class Fault {
+		None,
+		Crash, // Output is closed as if process died
+		Stall, // Search never finishes, 'stop' is ignored
+		Garbage // Malformed lines are sent along with search output
+	};
+	struct Config
+	{
+		std::string name = "Mock";
+		int options = 0; // Count of dummy spin options besides 'Hash', 'Threads' and 'Ponder'
+		int infoLines = 0; // Info lines sent during each search, spread over its delay
+		int delay = 0; // ms between 'go' and 'bestmove'
+		int latency = 0; // ms before answering any other command
+		Fault fault = Fault::None;
+		int faultAt = 1; // Number of 'go' command starting from which fault happens
+		unsigned seed = 0; // Seed for choosing moves, 0 to always play the first legal one
+	};
+	static bool isMockPath(const QString& path);
+	// Parameters are separated by ';'. Throws std::runtime_error for unknown ones
+	static Config parseConfig(const QString& path);
+	MockUCIEngine(const Config& config, QObject* parent = nullptr);
+	~MockUCIEngine(void);
+	bool isSequential(void) const override;
+	qint64 bytesAvailable(void) const override;
+	bool canReadLine(void) const override;
+	inline bool crashed(void) const noexcept;
+	inline int searchCount(void) const noexcept;
+protected:
+	qint64 readData(char* data, qint64 maxSize) override;
+	qint64 readLineData(char* data, qint64 maxSize) override;
+	qint64 writeData(const char* data, qint64 size) override;
+private:
+	void processCommand(const std::string& line);
+	void setPosition(std::istream& iss);
+	void startSearch(bool infinite);
+	// Send info lines due by now and, if search time is over, bestmove
+	void continueSearch(void);
+	void finishSearch(void);
+	std::string infoLine(int index) const;
+	// Append to output after given delay, notifying reader
+	void send(const std::string& lines, int delay);
+	void crash(void);
+	// Data
+	Config m_config;
+	QByteArray m_input; // Incomplete command line
+	QByteArray m_output; // Not yet read by UCIEngine
+	BlendXChess::Game m_game;
+	std::mt19937 m_rng;
+	QTimer m_searchTimer;
+	QElapsedTimer m_searchTime;
+	std::string m_bestMove;
+	int m_goCount;
+	int m_infoSent; // Info lines sent in current search
+	bool m_searching;
+	bool m_infinite; // 'go ponder' or 'go infinite', waits for 'ponderhit' or 'stop'
+	bool m_crashed;
+};
+
+inline bool MockUCIEngine::crashed(void) const noexcept
+{
+	return m_crashed;
+}
+
+inline int MockUCIEngine::searchCount(void) const noexcept
+{
+	return m_goCount;
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+#include "UCIEngine.h"
+
+// Statistics of engine search which produced a move (all -1 for moves not made by engine)
+struct MoveStats
+{
+	InfoDetails::ScoreType scoreType = InfoDetails::ScoreType::None;
+	int score = 0; // Centipawns or moves to mate (negative if white is mated), from white's side
+	int depth = -1;
+	long long nodes = -1;
+	long long nps = -1;
+	int time = -1; // ms spent on the move
+	inline bool empty(void) const noexcept;
+	// Take values present in info line of the search of given side (lines with
+	// secondary PVs are skipped, since score and depth belong to the best line)
+	inline void update(const InfoDetails& info, BlendXChess::Side side) noexcept;
+};
+
+// Statistics of moves of a game, indexed by ply
+using GameStats = std::vector<MoveStats>;
+
+inline bool MoveStats::empty(void) const noexcept
+{
+	return scoreType == InfoDetails::ScoreType::None && depth < 0 && nodes < 0 && time < 0;
+}
+
+inline void MoveStats::update(const InfoDetails& info, BlendXChess::Side side) noexcept
+{
+	if (info.multiPV > 1)
+		return;
+	if (info.scoreType != InfoDetails::ScoreType::None && info.bound == InfoDetails::Bound::Exact)
+	{
+		scoreType = info.scoreType;
+		score = side == BlendXChess::WHITE ? info.score : -info.score;
+	}
+	if (info.depth >= 0)
+		depth = info.depth;
+	if (info.nodes >= 0)
+		nodes = info.nodes;
+	if (info.nps >= 0)
+		nps = info.nps;
+}
@@ -0,0 +1,98 @@
+#include "OpeningBook.h"
+#include "PGN.h"
+#include "../Engine/engine.h"
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace BlendXChess;
+
+namespace
+{
+	// First four FEN fields (EPD operations and move counters are dropped)
+	std::string reducedFEN(const std::string& fen)
+	{
+		std::istringstream iss(fen);
+		std::string field, result;
+		for (int i = 0; i < 4 && iss >> field; ++i)
+			result += (i ? " " : "") + field;
+		return result;
+	}
+}
+
+void OpeningBook::load(const std::string& path)
+{
+	std::ifstream ifs(path);
+	if (!ifs)
+		throw std::runtime_error("Could not open opening book " + path);
+	m_openings.clear();
+	const auto dot = path.find_last_of('.');
+	std::string extension = dot == std::string::npos ? "" : path.substr(dot + 1);
+	std::transform(extension.begin(), extension.end(), extension.begin(),
+		[](unsigned char c) {return char(std::tolower(c)); });
+	if (extension == "pgn")
+		loadPGN(ifs);
+	else
+		loadEPD(ifs);
+	if (m_openings.empty())
+		throw std::runtime_error("Opening book " + path + " contains no openings");
+}
+
+void OpeningBook::shuffle(unsigned seed)
+{
+	std::shuffle(m_openings.begin(), m_openings.end(), std::mt19937(seed));
+}
+
+void OpeningBook::loadEPD(std::istream& istr)
+{
+	std::string line;
+	for (int lineNum = 1; std::getline(istr, line); ++lineNum)
+	{
+		const std::string fen = reducedFEN(line);
+		if (fen.empty() || fen[0] == '#')
+			continue;
+		addOpening(fen, {}, lineNum);
+	}
+}
+
+void OpeningBook::loadPGN(std::istream& istr)
+{
+	pgn::Record record;
+	for (int gameNum = 1; pgn::read(istr, record); ++gameNum)
+	{
+		std::vector<std::string> moves;
+		std::istringstream iss(record.movetext);
+		std::string token;
+		while (iss >> token)
+			if (token.find_first_not_of("0123456789.") != std::string::npos)
+				moves.push_back(token);
+		addOpening(reducedFEN(record.tag("FEN")), moves, gameNum);
+	}
+}
+
+void OpeningBook::addOpening(const std::string& fen, const std::vector<std::string>& sanMoves, int index)
+{
+	Game game;
+	Opening opening{ fen, {} };
+	try
+	{
+		if (!fen.empty())
+			game.loadFEN(fen, true);
+		for (const auto& san : sanMoves)
+		{
+			const Move move = game.moveFromStr(san, FMT_SAN);
+			if (!game.DoMove(move))
+				throw std::runtime_error("illegal move " + san);
+			opening.moves.push_back(move.toUCI());
+		}
+	}
+	catch (const std::runtime_error& err)
+	{
+		throw std::runtime_error("Opening " + std::to_string(index) + " is invalid: " + err.what());
+	}
+	if (game.getGameState() != GameState::ACTIVE)
+		throw std::runtime_error("Opening " + std::to_string(index) + " is already finished game");
+	m_openings.push_back(std::move(opening));
+}
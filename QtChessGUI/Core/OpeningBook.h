@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// Start position of a match game: position (empty FEN for the standard one) and moves made from it
+struct Opening
+{
+	std::string fen; // Without move counters
+	std::vector<std::string> moves; // UCI format
+};
+
+// Set of openings for engine matches read from EPD or PGN file. All openings
+// are validated while loading, so games can be started from them without checks
+class OpeningBook
+{
+public:
+	OpeningBook(void) = default;
+	// Load openings from file (PGN if it has .pgn extension, EPD otherwise).
+	// Throws std::runtime_error if file can't be read or contains illegal position or move
+	void load(const std::string& path);
+	void shuffle(unsigned seed);
+	inline bool empty(void) const noexcept;
+	inline size_t size(void) const noexcept;
+	inline const Opening& operator[](size_t idx) const;
+private:
+	void loadEPD(std::istream& istr);
+	void loadPGN(std::istream& istr);
+	// Check opening by replaying it and store it with moves converted from SAN to UCI
+	void addOpening(const std::string& fen, const std::vector<std::string>& sanMoves, int index);
+	std::vector<Opening> m_openings;
+};
+
+inline bool OpeningBook::empty(void) const noexcept
+{
+	return m_openings.empty();
+}
+
+inline size_t OpeningBook::size(void) const noexcept
+{
+	return m_openings.size();
+}
+
+inline const Opening& OpeningBook::operator[](size_t idx) const
+{
+	return m_openings[idx];
+}
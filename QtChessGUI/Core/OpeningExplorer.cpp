@@ -0,0 +1,215 @@
+#include "OpeningExplorer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+using namespace BlendXChess;
+
+namespace
+{
+	constexpr char FILE_MAGIC[8] = { 'B', 'X', 'E', 'X', 'P', 'L', '0', '1' };
+}
+
+OpeningExplorer::OpeningExplorer(void)
+{}
+
+void OpeningExplorer::Record::add(const Record& other)
+{
+	games += other.games;
+	whiteWins += other.whiteWins;
+	draws += other.draws;
+	blackWins += other.blackWins;
+	eloCount += other.eloCount;
+	eloSum += other.eloSum;
+}
+
+void OpeningExplorer::open(const std::string& path)
+{
+	m_path = path;
+	m_records.clear();
+	m_journal.clear();
+	readRecords(path, false);
+	readRecords(path + ".journal", true);
+	openJournal(false);
+}
+
+void OpeningExplorer::readRecords(const std::string& path, bool isJournal)
+{
+	std::ifstream ifs(path, std::ios::binary);
+	if (!ifs)
+		return; // Nothing stored yet
+	char magic[sizeof(FILE_MAGIC)];
+	if (!ifs.read(magic, sizeof(magic)) || std::memcmp(magic, FILE_MAGIC, sizeof(magic)) != 0)
+		throw std::runtime_error(path + " is not an opening explorer file");
+	Record record;
+	if (!isJournal)
+	{
+		ifs.seekg(0, std::ios::end);
+		const size_t count = (size_t(ifs.tellg()) - sizeof(FILE_MAGIC)) / sizeof(Record);
+		ifs.seekg(sizeof(FILE_MAGIC));
+		m_records.resize(count);
+		ifs.read(reinterpret_cast<char*>(m_records.data()), count * sizeof(Record));
+		return;
+	}
+	// Journal may end with a partially written record if program was terminated, which is ignored
+	while (ifs.read(reinterpret_cast<char*>(&record), sizeof(record)))
+	{
+		auto [it, inserted] = m_journal.try_emplace(RecordId(record.key, record.move), record);
+		if (!inserted)
+			it->second.add(record);
+	}
+}
+
+void OpeningExplorer::openJournal(bool truncate)
+{
+	const std::string journalPath = m_path + ".journal";
+	m_journalOut.close();
+	std::ifstream existing(journalPath, std::ios::binary);
+	const bool isNew = truncate || !existing || existing.peek() == std::ifstream::traits_type::eof();
+	existing.close();
+	m_journalOut.open(journalPath, std::ios::binary | (truncate ? std::ios::trunc : std::ios::app));
+	if (!m_journalOut)
+		throw std::runtime_error("Could not open " + journalPath);
+	if (isNew)
+		m_journalOut.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+}
+
+void OpeningExplorer::addGame(const Game& game, GameState result, int whiteElo, int blackElo)
+{
+	if (!isOpen())
+		return;
+	const std::vector<Key> keys = game.getPositionKeys();
+	const std::vector<Move> moves = game.getMoves();
+	// Side to move at the start is derived from side to move now
+	Side side = moves.size() % 2 == 0 ? game.getPosition().getTurn() : opposite(game.getPosition().getTurn());
+	for (size_t ply = 0; ply < moves.size(); ++ply, side = opposite(side))
+	{
+		const int elo = side == WHITE ? whiteElo : blackElo;
+		Record record{};
+		record.key = keys[ply];
+		record.move = moves[ply].raw();
+		record.games = 1;
+		record.whiteWins = result == GameState::WHITE_WIN;
+		record.draws = result == GameState::DRAW;
+		record.blackWins = result == GameState::BLACK_WIN;
+		record.eloCount = elo > 0;
+		record.eloSum = elo > 0 ? elo : 0;
+		m_journalOut.write(reinterpret_cast<const char*>(&record), sizeof(record));
+		auto [it, inserted] = m_journal.try_emplace(RecordId(record.key, record.move), record);
+		if (!inserted)
+			it->second.add(record);
+	}
+	m_journalOut.flush();
+	if (m_journal.size() >= MAX_JOURNAL)
+		compact();
+}
+
+std::vector<OpeningExplorer::MoveStats> OpeningExplorer::lookup(Key key) const
+{
+	std::vector<Record> found;
+	Record bound{};
+	bound.key = key;
+	for (auto it = std::lower_bound(m_records.begin(), m_records.end(), bound);
+		it != m_records.end() && it->key == key; ++it)
+		found.push_back(*it);
+	// Journal records are added to the ones from file with the same move
+	for (auto it = m_journal.lower_bound(RecordId(key, 0)); it != m_journal.end() && it->first.first == key; ++it)
+	{
+		auto same = std::find_if(found.begin(), found.end(),
+			[&it](const Record& record) {return record.move == it->second.move; });
+		if (same != found.end())
+			same->add(it->second);
+		else
+			found.push_back(it->second);
+	}
+	std::vector<MoveStats> stats;
+	stats.reserve(found.size());
+	for (const Record& record : found)
+		stats.push_back(MoveStats{ Move(record.move), record.games, record.whiteWins, record.draws,
+			record.blackWins, record.eloCount, record.eloSum });
+	std::sort(stats.begin(), stats.end(),
+		[](const MoveStats& lhs, const MoveStats& rhs) {return lhs.games > rhs.games; });
+	return stats;
+}
+
+void OpeningExplorer::clear(void)
+{
+	m_records.clear();
+	m_journal.clear();
+	if (isOpen())
+	{
+		writeSorted();
+		openJournal(true);
+	}
+}
+
+void OpeningExplorer::compact(void)
+{
+	if (!isOpen() || m_journal.empty())
+		return;
+	// Both sequences are sorted by (key, move), so they are merged in linear time
+	std::vector<Record> merged;
+	merged.reserve(m_records.size() + m_journal.size());
+	auto fileIt = m_records.begin();
+	for (const auto& [id, record] : m_journal)
+	{
+		while (fileIt != m_records.end() && *fileIt < record)
+			merged.push_back(*fileIt++);
+		if (fileIt != m_records.end() && fileIt->key == record.key && fileIt->move == record.move)
+		{
+			merged.push_back(*fileIt++);
+			merged.back().add(record);
+		}
+		else
+			merged.push_back(record);
+	}
+	merged.insert(merged.end(), fileIt, m_records.end());
+	m_records = std::move(merged);
+	m_journal.clear();
+	writeSorted();
+	openJournal(true);
+}
+
+void OpeningExplorer::replace(OpeningExplorer& other)
+{
+	other.compact(); // Whole data is in its sorted file then
+	other.m_journalOut.close();
+	m_journalOut.close();
+	std::remove(m_path.c_str());
+	if (std::rename(other.m_path.c_str(), m_path.c_str()) != 0)
+		throw std::runtime_error("Could not replace " + m_path);
+	std::remove((other.m_path + ".journal").c_str());
+	m_records = std::move(other.m_records);
+	m_journal.clear();
+	other.m_records.clear();
+	other.m_path.clear();
+	openJournal(true);
+}
+
+void OpeningExplorer::remove(void)
+{
+	if (!isOpen())
+		return;
+	m_journalOut.close();
+	std::remove(m_path.c_str());
+	std::remove((m_path + ".journal").c_str());
+	m_records.clear();
+	m_journal.clear();
+	m_path.clear();
+}
+
+void OpeningExplorer::writeSorted(void)
+{
+	// Written to temporary file first, so that crash in between doesn't lose data
+	const std::string tmpPath = m_path + ".tmp";
+	{
+		std::ofstream ofs(tmpPath, std::ios::binary | std::ios::trunc);
+		ofs.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+		ofs.write(reinterpret_cast<const char*>(m_records.data()), m_records.size() * sizeof(Record));
+		if (!ofs)
+			throw std::runtime_error("Could not write " + tmpPath);
+	}
+	std::remove(m_path.c_str());
+	if (std::rename(tmpPath.c_str(), m_path.c_str()) != 0)
+		throw std::runtime_error("Could not replace " + m_path);
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include "../Engine/engine.h"
+
+// Statistics of moves played from each position in stored games. Data is kept in a file of
+// fixed-size records sorted by (position key, move), which is loaded whole and binary searched,
+// and a journal of records added since then, merged into the file when it grows large
+class OpeningExplorer
+{
+public:
+	// Statistics of one move from one position
+	struct MoveStats
+	{
+		BlendXChess::Move move;
+		uint32_t games; // Including unfinished ones
+		uint32_t whiteWins, draws, blackWins;
+		uint32_t eloCount; // Games where Elo of the player making the move is known
+		uint64_t eloSum;
+		inline double averageElo(void) const noexcept;
+	};
+	OpeningExplorer(void);
+	// Open file (it's created if missing) along with its journal. Throws std::runtime_error on failure
+	void open(const std::string& path);
+	inline bool isOpen(void) const noexcept;
+	// Add moves of given game from the start up to its current position. Elo values of 0 are unknown
+	void addGame(const BlendXChess::Game& game, BlendXChess::GameState result,
+		int whiteElo = 0, int blackElo = 0);
+	// Moves played in position with given key (see Game::getPositionKey), most popular first
+	std::vector<MoveStats> lookup(BlendXChess::Key key) const;
+	// Remove all data
+	void clear(void);
+	// Write all data into sorted file and empty the journal
+	void compact(void);
+	// Take data of other explorer (rebuilt into other file, so that cancelled rebuild loses nothing),
+	// whose files are moved in place of these ones. Other explorer is left closed
+	void replace(OpeningExplorer& other);
+	// Close and delete files (of abandoned rebuild)
+	void remove(void);
+	inline const std::string& path(void) const noexcept;
+	inline size_t size(void) const noexcept;
+private:
+	// On-disk record, also used in memory
+	struct Record
+	{
+		uint64_t key;
+		uint64_t eloSum;
+		uint32_t games, whiteWins, draws, blackWins, eloCount;
+		uint16_t move;
+		uint16_t reserved;
+		void add(const Record& other);
+		inline bool operator<(const Record& other) const noexcept;
+	};
+	static_assert(sizeof(Record) == 40, "Record layout is a part of file format");
+	using RecordId = std::pair<uint64_t, uint16_t>;
+	// Journal is merged into file when it has this many distinct records
+	static constexpr size_t MAX_JOURNAL = 1 << 16;
+	void readRecords(const std::string& path, bool isJournal);
+	void writeSorted(void);
+	void openJournal(bool truncate);
+	// Data
+	std::string m_path;
+	std::vector<Record> m_records; // Sorted
+	std::map<RecordId, Record> m_journal; // Added after m_records were written
+	std::ofstream m_journalOut;
+};
+
+inline double OpeningExplorer::MoveStats::averageElo(void) const noexcept
+{
+	return eloCount == 0 ? 0.0 : double(eloSum) / eloCount;
+}
+
+inline bool OpeningExplorer::isOpen(void) const noexcept
+{
+	return !m_path.empty();
+}
+
+inline const std::string& OpeningExplorer::path(void) const noexcept
+{
+	return m_path;
+}
+
+inline size_t OpeningExplorer::size(void) const noexcept
+{
+	return m_records.size() + m_journal.size();
+}
+
+inline bool OpeningExplorer::Record::operator<(const Record& other) const noexcept
+{
+	return key != other.key ? key < other.key : move < other.move;
+}
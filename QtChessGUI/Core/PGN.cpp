@@ -0,0 +1,161 @@
+#include "PGN.h"
+#include "misc.h"
+#include <sstream>
+#include <cctype>
+
+std::string pgn::Record::tag(const std::string& name) const
+{
+	for (const auto& [tagName, value] : tags)
+		if (tagName == name)
+			return value;
+	return std::string();
+}
+
+void pgn::Record::setTag(const std::string& name, const std::string& value)
+{
+	for (auto& [tagName, tagValue] : tags)
+		if (tagName == name)
+		{
+			tagValue = value;
+			return;
+		}
+	tags.emplace_back(name, value);
+}
+
+bool pgn::read(std::istream& istr, Record& record)
+{
+	record = Record();
+	std::string line, movetext;
+	bool inMovetext = false;
+	while (std::getline(istr, line))
+	{
+		line = misc::trim(line);
+		if (line.empty())
+		{
+			if (inMovetext)
+				break; // Blank line terminates movetext
+			continue;
+		}
+		if (line[0] == '%')
+			continue; // Escape mechanism, line is ignored
+		if (line[0] == '[' && !inMovetext)
+		{ // [Name "Value"]
+			const size_t nameEnd = line.find(' ');
+			const size_t valueBeg = line.find('"'), valueEnd = line.rfind('"');
+			if (nameEnd == std::string::npos || valueBeg == valueEnd)
+				continue;
+			record.tags.emplace_back(line.substr(1, nameEnd - 1),
+				line.substr(valueBeg + 1, valueEnd - valueBeg - 1));
+			continue;
+		}
+		inMovetext = true;
+		movetext += line + '\n';
+	}
+	if (!inMovetext && record.tags.empty())
+		return false;
+	record.movetext = normalizeMovetext(movetext, &record.result);
+	if (record.result.empty())
+		record.result = record.tag("Result");
+	return true;
+}
+
+void pgn::write(std::ostream& ostr, const Record& record)
+{
+	for (const auto& [name, value] : record.tags)
+		ostr << '[' << name << " \"" << value << "\"]\n";
+	ostr << '\n' << record.movetext;
+	if (!record.movetext.empty() && record.movetext.back() != '\n')
+		ostr << ' ';
+	ostr << (record.result.empty() ? "*" : record.result) << "\n\n";
+}
+
+std::string pgn::normalizeSAN(std::string san)
+{
+	// Annotations and check marks
+	while (!san.empty() && (san.back() == '+' || san.back() == '#'
+		|| san.back() == '!' || san.back() == '?'))
+		san.pop_back();
+	// Promotion is written without '='
+	if (const size_t eq = san.find('='); eq != std::string::npos)
+		san.erase(eq, 1);
+	// Piece captures are written without 'x' (but pawn ones keep it)
+	if (!san.empty() && std::isupper(san[0]) && san[0] != 'O')
+		if (const size_t x = san.find('x'); x != std::string::npos)
+			san.erase(x, 1);
+	// Castling is sometimes written with zeros
+	if (san == "0-0")
+		san = "O-O";
+	else if (san == "0-0-0")
+		san = "O-O-O";
+	return san;
+}
+
+std::string pgn::normalizeMovetext(const std::string& movetext, std::string* result)
+{
+	// Remove comments and variations (which may be nested)
+	std::string plain;
+	int variationDepth = 0;
+	for (size_t i = 0; i < movetext.size(); ++i)
+	{
+		const char c = movetext[i];
+		if (c == '{')
+		{
+			const size_t end = movetext.find('}', i);
+			i = (end == std::string::npos ? movetext.size() : end);
+			plain.push_back(' ');
+		}
+		else if (c == ';')
+		{
+			const size_t end = movetext.find('\n', i);
+			i = (end == std::string::npos ? movetext.size() : end);
+			plain.push_back(' ');
+		}
+		else if (c == '(')
+			++variationDepth;
+		else if (c == ')')
+			variationDepth -= (variationDepth > 0), plain.push_back(' ');
+		else if (variationDepth == 0)
+			plain.push_back(c);
+	}
+	// Rebuild movetext token by token in the form Game::writeGame produces it
+	std::istringstream iss(plain);
+	std::ostringstream out;
+	std::string token;
+	bool whiteMoved = false;
+	int moveNumber = 1;
+	while (iss >> token)
+	{
+		if (token == "1-0" || token == "0-1" || token == "1/2-1/2" || token == "*")
+		{
+			if (result)
+				*result = token;
+			break;
+		}
+		if (token[0] == '$')
+			continue; // NAG
+		// Move number indicator, possibly glued to the move ("1.e4")
+		if (std::isdigit(token[0]))
+		{
+			const size_t moveBeg = token.find_first_not_of("0123456789.");
+			// Game starting with black's move ("5... e5"), as written from FEN position
+			if (out.tellp() == 0 && token.find("...") != std::string::npos)
+			{
+				moveNumber = std::stoi(token);
+				out << moveNumber << "...";
+				whiteMoved = true;
+			}
+			if (moveBeg == std::string::npos)
+				continue;
+			token.erase(0, moveBeg);
+		}
+		token = normalizeSAN(token);
+		if (!whiteMoved)
+			out << moveNumber << ". " << token;
+		else
+			out << ' ' << token << '\n', ++moveNumber;
+		whiteMoved = !whiteMoved;
+	}
+	if (whiteMoved)
+		out << '\n';
+	return out.str();
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <utility>
+#include <istream>
+#include <ostream>
+
+// Reading and writing of multi-game PGN files. Movetext is converted to the
+// subset understood by BlendXChess::Game::loadGame (move numbers and SAN moves
+// without comments, variations, annotations and check marks)
+namespace pgn
+{
+	struct Record
+	{
+		std::vector<std::pair<std::string, std::string>> tags; // In file order
+		std::string movetext; // Normalized, without result token
+		std::string result; // Game termination marker ("1-0", "0-1", "1/2-1/2" or "*")
+
+		std::string tag(const std::string& name) const;
+		void setTag(const std::string& name, const std::string& value);
+	};
+
+	// Read next game from the stream. Returns false if there are no more games
+	bool read(std::istream& istr, Record& record);
+	// Write game with tags in export format
+	void write(std::ostream& ostr, const Record& record);
+	// Convert a SAN token from arbitrary PGN to the form produced by Position::moveToSAN
+	std::string normalizeSAN(std::string san);
+	// Strip comments, variations, NAGs and result from movetext and normalize moves
+	std::string normalizeMovetext(const std::string& movetext, std::string* result = nullptr);
+}
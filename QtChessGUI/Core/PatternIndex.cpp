@@ -0,0 +1,248 @@
+#include "PatternIndex.h"
+#include <algorithm>
+#include <bitset>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+using namespace BlendXChess;
+
+namespace
+{
+	constexpr char FILE_MAGIC[8] = { 'B', 'X', 'P', 'A', 'T', 'T', '0', '1' };
+	// Bits of one piece count in PatternIndex::Material
+	constexpr int COUNT_BITS = 4;
+	constexpr int SIDE_BITS = COUNT_BITS * (QUEEN - PAWN + 1);
+	// Positions evaluated before their matches are collected. Evaluation loop has
+	// no branches and no data dependencies between iterations
+	constexpr size_t SCAN_BLOCK = 4096;
+
+	constexpr int countShift(Side side, PieceType pt)
+	{
+		return side * SIDE_BITS + (pt - PAWN) * COUNT_BITS;
+	}
+
+	template<typename T>
+	void readColumn(std::ifstream& ifs, std::vector<T>& column, size_t count)
+	{
+		column.resize(count);
+		ifs.read(reinterpret_cast<char*>(column.data()), count * sizeof(T));
+	}
+
+	template<typename T>
+	void writeColumn(std::ofstream& ofs, const std::vector<T>& column)
+	{
+		ofs.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T));
+	}
+}
+
+void PatternIndex::open(const std::string& path)
+{
+	m_path = path;
+	clear();
+	std::ifstream ifs(path, std::ios::binary);
+	if (!ifs)
+		return; // Nothing stored yet
+	char magic[sizeof(FILE_MAGIC)];
+	uint64_t count = 0;
+	if (!ifs.read(magic, sizeof(magic)) || std::memcmp(magic, FILE_MAGIC, sizeof(magic)) != 0
+		|| !ifs.read(reinterpret_cast<char*>(&count), sizeof(count)))
+		throw std::runtime_error(path + " is not a pattern index file");
+	readColumn(ifs, m_material, count);
+	for (Side side : { WHITE, BLACK })
+		readColumn(ifs, m_pawns[side], count);
+	readColumn(ifs, m_gameIds, count);
+	readColumn(ifs, m_plies, count);
+	if (!ifs)
+	{
+		clear();
+		throw std::runtime_error(path + " is truncated");
+	}
+}
+
+void PatternIndex::addGame(int gameId, const Game& game)
+{
+	int ply = 0;
+	game.forEachPosition([this, gameId, &ply](const Position& pos) {
+		m_material.push_back(material(pos));
+		for (Side side : { WHITE, BLACK })
+			m_pawns[side].push_back(pos.pieceBB(side, PAWN));
+		m_gameIds.push_back(uint32_t(gameId));
+		m_plies.push_back(uint16_t(ply++));
+	});
+}
+
+void PatternIndex::clear(void)
+{
+	m_material.clear();
+	for (auto& pawns : m_pawns)
+		pawns.clear();
+	m_gameIds.clear();
+	m_plies.clear();
+}
+
+void PatternIndex::replace(PatternIndex&& other)
+{
+	m_material = std::move(other.m_material);
+	for (Side side : { WHITE, BLACK })
+		m_pawns[side] = std::move(other.m_pawns[side]);
+	m_gameIds = std::move(other.m_gameIds);
+	m_plies = std::move(other.m_plies);
+	other.clear();
+}
+
+void PatternIndex::save(void) const
+{
+	// Written to temporary file first, so that crash in between doesn't lose data
+	const std::string tmpPath = m_path + ".tmp";
+	{
+		std::ofstream ofs(tmpPath, std::ios::binary | std::ios::trunc);
+		const uint64_t count = m_material.size();
+		ofs.write(FILE_MAGIC, sizeof(FILE_MAGIC));
+		ofs.write(reinterpret_cast<const char*>(&count), sizeof(count));
+		writeColumn(ofs, m_material);
+		for (Side side : { WHITE, BLACK })
+			writeColumn(ofs, m_pawns[side]);
+		writeColumn(ofs, m_gameIds);
+		writeColumn(ofs, m_plies);
+		if (!ofs)
+			throw std::runtime_error("Could not write " + tmpPath);
+	}
+	std::remove(m_path.c_str());
+	if (std::rename(tmpPath.c_str(), m_path.c_str()) != 0)
+		throw std::runtime_error("Could not replace " + m_path);
+}
+
+PatternIndex::Result PatternIndex::search(const Query& query, int threads) const
+{
+	const auto start = std::chrono::steady_clock::now();
+	const size_t count = size();
+	if (threads <= 0)
+		threads = int(std::max(1u, std::thread::hardware_concurrency()));
+	// Small index isn't worth starting threads
+	threads = int(std::min<size_t>(threads, (count + SCAN_BLOCK - 1) / SCAN_BLOCK));
+	Result result;
+	result.scanned = count;
+	if (threads <= 1)
+		scan(query, 0, count, result.matches);
+	else
+	{
+		// Contiguous ranges, so that concatenated matches stay ordered
+		std::vector<std::vector<Match>> partial(threads);
+		std::vector<std::thread> workers;
+		for (int i = 0; i < threads; ++i)
+			workers.emplace_back([this, &query, &partial, i, threads, count](void) {
+				scan(query, count * i / threads, count * (i + 1) / threads, partial[i]);
+			});
+		for (std::thread& worker : workers)
+			worker.join();
+		for (const std::vector<Match>& matches : partial)
+			for (const Match& match : matches)
+				// Game split between ranges may be matched by both of them
+				if (result.matches.empty() || result.matches.back().gameId != match.gameId)
+					result.matches.push_back(match);
+	}
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return result;
+}
+
+void PatternIndex::scan(const Query& query, size_t beg, size_t end, std::vector<Match>& matches) const
+{
+	const Material materialMask = query.materialMask, materialValue = query.material;
+	const PawnCondition& white = query.pawns[WHITE];
+	const PawnCondition& black = query.pawns[BLACK];
+	const bool whiteAny = white.anyOf == 0, blackAny = black.anyOf == 0;
+	const Material* material = m_material.data();
+	const Bitboard* whitePawns = m_pawns[WHITE].data();
+	const Bitboard* blackPawns = m_pawns[BLACK].data();
+	uint8_t hits[SCAN_BLOCK];
+	for (size_t blockBeg = beg; blockBeg < end; blockBeg += SCAN_BLOCK)
+	{
+		const size_t blockSize = std::min(SCAN_BLOCK, end - blockBeg);
+		// Conditions are combined with & rather than && to keep the loop branch-free
+		for (size_t i = 0; i < blockSize; ++i)
+		{
+			const size_t pos = blockBeg + i;
+			const Bitboard wp = whitePawns[pos], bp = blackPawns[pos];
+			hits[i] = uint8_t(((material[pos] & materialMask) == materialValue)
+				& (whiteAny | ((wp & white.anyOf) != 0)) & ((wp & white.allOf) == white.allOf)
+				& ((wp & white.noneOf) == 0)
+				& (blackAny | ((bp & black.anyOf) != 0)) & ((bp & black.allOf) == black.allOf)
+				& ((bp & black.noneOf) == 0));
+		}
+		for (size_t i = 0; i < blockSize; ++i)
+			if (hits[i])
+			{
+				const int gameId = int(m_gameIds[blockBeg + i]);
+				// Positions of a game are consecutive, only its first match is reported
+				if (matches.empty() || matches.back().gameId != gameId)
+					matches.push_back({ gameId, m_plies[blockBeg + i] });
+			}
+	}
+}
+
+PatternIndex::Material PatternIndex::material(const Position& pos)
+{
+	Material result = 0;
+	for (Side side : { WHITE, BLACK })
+		for (PieceType pt = PAWN; pt <= QUEEN; ++pt)
+		{
+			const Material count = std::bitset<64>(pos.pieceBB(side, pt)).count();
+			// Counts above 15 (impossible in legal game) are saturated
+			result |= std::min<Material>(count, (1 << COUNT_BITS) - 1) << countShift(side, pt);
+		}
+	return result;
+}
+
+PatternIndex::Query PatternIndex::parseMaterial(const std::string& description)
+{
+	const size_t separator = description.find_first_of("vV");
+	if (separator == std::string::npos)
+		throw std::runtime_error("Material should be given as pieces of both sides separated by 'v', e.g. KRPvKR");
+	Query query;
+	const std::string sides[COLOR_CNT] = { description.substr(0, separator), description.substr(separator + 1) };
+	for (Side side : { WHITE, BLACK })
+	{
+		if (sides[side] == "*")
+			continue;
+		int counts[QUEEN + 1] = {};
+		for (char c : sides[side])
+			switch (std::toupper(static_cast<unsigned char>(c)))
+			{
+			case 'P': ++counts[PAWN]; break;
+			case 'N': ++counts[KNIGHT]; break;
+			case 'B': ++counts[BISHOP]; break;
+			case 'R': ++counts[ROOK]; break;
+			case 'Q': ++counts[QUEEN]; break;
+			case 'K': case ' ': break;
+			default:
+				throw std::runtime_error(std::string("Unknown piece '") + c + "' in material description");
+			}
+		for (PieceType pt = PAWN; pt <= QUEEN; ++pt)
+		{
+			if (counts[pt] >= (1 << COUNT_BITS))
+				throw std::runtime_error("Too many pieces in material description");
+			query.materialMask |= Material((1 << COUNT_BITS) - 1) << countShift(side, pt);
+			query.material |= Material(counts[pt]) << countShift(side, pt);
+		}
+	}
+	return query;
+}
+
+PatternIndex::PawnCondition PatternIndex::isolatedQueenPawn(void)
+{
+	PawnCondition condition;
+	condition.anyOf = BB_FILE_D;
+	condition.noneOf = BB_FILE_C | BB_FILE_E;
+	return condition;
+}
+
+PatternIndex::PawnCondition PatternIndex::samePawns(const Position& pos, Side side)
+{
+	PawnCondition condition;
+	condition.allOf = pos.pieceBB(side, PAWN);
+	condition.noneOf = ~condition.allOf;
+	return condition;
+}
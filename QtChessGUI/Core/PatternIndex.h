@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "../Engine/engine.h"
+
+// Material and pawn structure of every position of stored games, for queries which can't be
+// answered by position keys ("rook and pawn against rook", "isolated queen pawn"). Data is kept
+// column by column, so that a query is a scan of plain arrays with branch-free predicates, which
+// compiler vectorizes, split between all cores. Saved into a file and rebuilt from database
+class PatternIndex
+{
+public:
+	// Counts of pawns, knights, bishops, rooks and queens of both sides, 4 bits each
+	// (white ones in lower 20 bits)
+	using Material = uint64_t;
+	// Condition on pawns of one side: at least one of anyOf squares (unless it's empty),
+	// all of allOf squares and none of noneOf squares are occupied
+	struct PawnCondition
+	{
+		BlendXChess::Bitboard anyOf = 0, allOf = 0, noneOf = 0;
+	};
+	struct Query
+	{
+		// Position matches if (material & materialMask) == material
+		Material materialMask = 0, material = 0;
+		PawnCondition pawns[BlendXChess::COLOR_CNT];
+	};
+	// First matching position of a game
+	struct Match
+	{
+		int gameId;
+		int ply;
+	};
+	struct Result
+	{
+		std::vector<Match> matches; // Ordered by game id
+		size_t scanned = 0; // Positions
+		double seconds = 0.0;
+		inline double positionsPerSecond(void) const noexcept;
+	};
+
+	// Open file and load its data (nothing if it's missing). Throws std::runtime_error on failure
+	void open(const std::string& path);
+	inline bool isOpen(void) const noexcept;
+	// Add positions of given game from the start up to its current one. Games should be
+	// added in order of their ids, which is the order of matches
+	void addGame(int gameId, const BlendXChess::Game& game);
+	// Remove all data
+	void clear(void);
+	// Take data of other index (rebuilt apart from this one, so that cancelled rebuild loses nothing)
+	void replace(PatternIndex&& other);
+	// Write all data into file. Throws std::runtime_error on failure
+	void save(void) const;
+	inline size_t size(void) const noexcept;
+	// Find games with positions matching query using given count of threads (0 means all cores)
+	Result search(const Query& query, int threads = 0) const;
+
+	static Material material(const BlendXChess::Position& pos);
+	// Query for exact material given as pieces of White and Black separated by 'v', e.g. "KRPvKR".
+	// Kings are optional and '*' in place of side's pieces matches any. Throws std::runtime_error if it's malformed
+	static Query parseMaterial(const std::string& description);
+	// Pawn on d-file without pawns of the same side on c- and e-files
+	static PawnCondition isolatedQueenPawn(void);
+	// Exactly the same pawns of given side as in position
+	static PawnCondition samePawns(const BlendXChess::Position& pos, BlendXChess::Side side);
+private:
+	// Matches in positions [beg, end)
+	void scan(const Query& query, size_t beg, size_t end, std::vector<Match>& matches) const;
+
+	std::string m_path;
+	// Columns, one element per position
+	std::vector<Material> m_material;
+	std::vector<BlendXChess::Bitboard> m_pawns[BlendXChess::COLOR_CNT];
+	std::vector<uint32_t> m_gameIds;
+	std::vector<uint16_t> m_plies;
+};
+
+inline double PatternIndex::Result::positionsPerSecond(void) const noexcept
+{
+	return seconds > 0.0 ? scanned / seconds : 0.0;
+}
+
+inline bool PatternIndex::isOpen(void) const noexcept
+{
+	return !m_path.empty();
+}
+
+inline size_t PatternIndex::size(void) const noexcept
+{
+	return m_material.size();
+}
@@ -0,0 +1,116 @@
+#include "PlayerRegistry.h"
+#include <algorithm>
+#include "Database.h"
+
+const PlayerRegistry::Engine* PlayerRegistry::Players::engine(int id) const
+{
+	const auto it = std::lower_bound(engines.begin(), engines.end(), id,
+		[](const Engine& engine, int id) { return engine.id < id; });
+	return it != engines.end() && it->id == id ? &*it : nullptr;
+}
+
+int PlayerRegistry::Players::elo(int playerId) const
+{
+	if (const Engine* found = engine(playerId))
+		return found->elo;
+	const auto it = std::lower_bound(humans.begin(), humans.end(), playerId,
+		[](const Human& human, int id) { return human.id < id; });
+	return it != humans.end() && it->id == playerId ? it->elo : 0;
+}
+
+PlayerRegistry::Snapshot PlayerRegistry::players(QSqlDatabase database)
+{
+	unsigned generation;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_players)
+			return m_players;
+		generation = m_generation;
+	}
+	// Loaded without lock, so that other threads may use registry meanwhile
+	Snapshot snapshot = load(database);
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (generation == m_generation)
+	{
+		m_players = snapshot;
+		m_ids.clear();
+		for (const Engine& engine : snapshot->engines)
+			m_ids.insert(engine.name, engine.id);
+		for (const Human& human : snapshot->humans)
+			if (!m_ids.contains(human.name))
+				m_ids.insert(human.name, human.id);
+		m_idsLoaded = true;
+	}
+	return snapshot;
+}
+
+PlayerRegistry::Snapshot PlayerRegistry::cached(void) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_players;
+}
+
+PlayerRegistry::Engine PlayerRegistry::engine(int id, QSqlDatabase database)
+{
+	const Snapshot snapshot = players(database);
+	if (const Engine* found = snapshot->engine(id))
+		return *found;
+	throw std::runtime_error("No engine with id " + std::to_string(id) + " in database");
+}
+
+int PlayerRegistry::findOrCreatePlayer(const QString& name, int elo, QSqlDatabase database)
+{
+	bool idsLoaded;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		idsLoaded = m_idsLoaded;
+	}
+	if (!idsLoaded)
+		players(database);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (const auto it = m_ids.constFind(name); it != m_ids.constEnd())
+			return it.value();
+	}
+	// Database is still asked, since player may have been added by another connection
+	const int id = db::findOrCreatePlayer(name, elo, database);
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_ids.insert(name, id);
+	// Snapshot lacks the new player, but names stay valid
+	m_players.reset();
+	++m_generation;
+	return id;
+}
+
+void PlayerRegistry::invalidate(void)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_players.reset();
+	m_ids.clear();
+	m_idsLoaded = false;
+	++m_generation;
+}
+
+PlayerRegistry::Snapshot PlayerRegistry::load(QSqlDatabase database)
+{
+	auto players = std::make_shared<Players>();
+	for (const QVariantList& row : db::selectRows(R"(
+		SELECT engine_players.id, engine_players.name, version, authorId, persons.name,
+			programmingLanguage, path, ELO
+		FROM engine_players
+		INNER JOIN players ON engine_players.id = players.id
+		LEFT JOIN persons ON authorId = persons.id
+		ORDER BY engine_players.id)", {}, database))
+		players->engines.push_back({ row[0].toInt(), row[1].toString(), row[2].toString(), row[3],
+			row[4].toString(), row[5].toString(), row[6].toString(), row[7].toInt() });
+	for (const QVariantList& row : db::selectRows(R"(
+		SELECT human_players.id, persons.name, ELO
+		FROM human_players
+		INNER JOIN persons ON personId = persons.id
+		LEFT JOIN players ON human_players.id = players.id
+		ORDER BY human_players.id)", {}, database))
+		players->humans.push_back({ row[0].toInt(), row[1].toString(), row[2].toInt() });
+	for (const QVariantList& row : db::selectRows("SELECT id, name FROM persons ORDER BY name", {}, database))
+		players->persons.push_back({ row[0].toInt(), row[1].toString() });
+	return players;
+}
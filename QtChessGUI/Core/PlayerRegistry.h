@@ -0,0 +1,87 @@
+#pragma once
+#include <QtCore>
+#include <QtSql>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "DBWorker.h"
+
+// Engine and human players (with persons, who may be engine authors) kept in memory, so that
+// starting a game or opening a dialog doesn't query the database. They are loaded on first use
+// and again after invalidate(), which should be called whenever players are added, modified or
+// removed. Loaded data is an immutable snapshot shared by all users. May be used from any thread
+class PlayerRegistry
+{
+public:
+	struct Engine
+	{
+		int id;
+		QString name;
+		QString version;
+		QVariant authorId; // Null if unknown
+		QString authorName;
+		QString programmingLanguage;
+		QString path;
+		int elo;
+	};
+	struct Human
+	{
+		int id;
+		QString name;
+		int elo;
+	};
+	struct Person
+	{
+		int id;
+		QString name;
+	};
+	struct Players
+	{
+		std::vector<Engine> engines; // Ordered by id
+		std::vector<Human> humans; // Ordered by id
+		std::vector<Person> persons; // Ordered by name
+		// Engine with given id or nullptr
+		const Engine* engine(int id) const;
+		// Rating of engine or human player (0 if it's unknown)
+		int elo(int playerId) const;
+	};
+	using Snapshot = std::shared_ptr<const Players>;
+
+	// Players, loaded using given connection unless they are cached. Throws std::runtime_error on failure
+	Snapshot players(QSqlDatabase database = QSqlDatabase::database());
+	// Cached players or nullptr if they have to be loaded first (never touches database)
+	Snapshot cached(void) const;
+	// Engine with given id. Throws std::runtime_error on failure or if it's not found
+	Engine engine(int id, QSqlDatabase database = QSqlDatabase::database());
+	// Same as db::findOrCreatePlayer, but known players are found without database
+	int findOrCreatePlayer(const QString& name, int elo = 0, QSqlDatabase database = QSqlDatabase::database());
+	// Drop cached players, so that they are reloaded on next use
+	void invalidate(void);
+	// Call onReady with players in the thread of context: at once if they are cached,
+	// otherwise after worker loads them (onError is called if that fails)
+	template<typename OnReady>
+	void withPlayers(DBWorker& worker, QObject* context, OnReady onReady,
+		DBWorker::ErrorCallback onError = {});
+private:
+	static Snapshot load(QSqlDatabase database);
+
+	mutable std::mutex m_mutex;
+	Snapshot m_players;
+	// Player ids by name (engines take precedence over humans of the same name). Unlike snapshot,
+	// they are kept when a player is created, so that import creating many players doesn't reload them
+	QHash<QString, int> m_ids;
+	bool m_idsLoaded = false;
+	// Incremented when players change, so that snapshot loaded before that isn't cached
+	unsigned m_generation = 0;
+};
+
+template<typename OnReady>
+void PlayerRegistry::withPlayers(DBWorker& worker, QObject* context, OnReady onReady,
+	DBWorker::ErrorCallback onError)
+{
+	if (Snapshot snapshot = cached())
+		onReady(std::move(snapshot));
+	else
+		worker.run(context, [this](QSqlDatabase database) { return players(database); },
+			std::move(onReady), std::move(onError));
+}
@@ -0,0 +1,235 @@
+#include "StorageBackend.h"
+
+namespace
+{
+	void execAll(QSqlDatabase& database, std::initializer_list<const char*> statements)
+	{
+		QSqlQuery query(database);
+		for (const char* sql : statements)
+			if (!query.exec(sql))
+				qWarning() << "Schema statement failed:" << sql << query.lastError().text();
+	}
+}
+
+std::unique_ptr<StorageBackend> StorageBackend::create(const QString& spec)
+{
+	const int colon = spec.indexOf(':');
+	const QString type = spec.left(colon).toLower();
+	const QString argument = colon < 0 ? QString() : spec.mid(colon + 1);
+	if (type == "mysql")
+		return std::make_unique<MySQLBackend>(argument.isEmpty() ? QString("chessdb") : argument);
+	if (type == "sqlite" && !argument.isEmpty())
+		return std::make_unique<SQLiteBackend>(argument);
+	throw std::runtime_error("Unknown storage '" + spec.toStdString()
+		+ "', expected mysql[:database] or sqlite:path");
+}
+
+//============================================================
+// MySQLBackend
+//============================================================
+
+MySQLBackend::MySQLBackend(const QString& databaseName)
+	: m_databaseName(databaseName)
+{}
+
+QString MySQLBackend::name(void) const
+{
+	return "mysql";
+}
+
+QSqlDatabase MySQLBackend::addConnection(const QString& connectionName) const
+{
+	QSqlDatabase database = QSqlDatabase::addDatabase("QMYSQL", connectionName);
+	database.setHostName("localhost");
+	database.setUserName("root");
+	database.setPassword("LamboV3n3n0");
+	return database;
+}
+
+QSqlDatabase MySQLBackend::connect(const QString& connectionName) const
+{
+	QSqlDatabase database = addConnection(connectionName);
+	database.setDatabaseName(m_databaseName);
+	database.open();
+	return database;
+}
+
+void MySQLBackend::ensureSchema(QSqlDatabase database) const
+{
+	// Tables of the original schema already exist in deployed databases
+	execAll(database, {
+		"CREATE TABLE IF NOT EXISTS persons (id INT AUTO_INCREMENT PRIMARY KEY, "
+			"name VARCHAR(255) NOT NULL, KEY name (name))",
+		"CREATE TABLE IF NOT EXISTS players (id INT AUTO_INCREMENT PRIMARY KEY, ELO INT NOT NULL DEFAULT 0)",
+		"CREATE TABLE IF NOT EXISTS human_players (id INT PRIMARY KEY, personId INT NOT NULL)",
+		"CREATE TABLE IF NOT EXISTS engine_players (id INT PRIMARY KEY, authorId INT, "
+			"programmingLanguage VARCHAR(64), name VARCHAR(255) NOT NULL, version VARCHAR(64), "
+			"path VARCHAR(1024), KEY name (name))",
+		"CREATE TABLE IF NOT EXISTS games (id INT AUTO_INCREMENT PRIMARY KEY, "
+			"whitePlayerId INT NOT NULL, blackPlayerId INT NOT NULL, PGN MEDIUMTEXT NOT NULL, "
+			"moves MEDIUMBLOB, startFEN VARCHAR(100), moveHash BIGINT, date DATE, result VARCHAR(16), "
+			"KEY whitePlayerId (whitePlayerId), KEY blackPlayerId (blackPlayerId), UNIQUE KEY moveHash (moveHash))",
+		// Keys are stored as signed 64-bit integers. Clustering by key makes
+		// position lookup a single range scan regardless of games count
+		"CREATE TABLE IF NOT EXISTS game_positions (zobrist BIGINT NOT NULL, gameId INT NOT NULL, "
+			"ply SMALLINT NOT NULL, PRIMARY KEY (zobrist, gameId), KEY gameId (gameId))",
+		// Search statistics of engine moves (see MoveStats), only for plies which have them
+		"CREATE TABLE IF NOT EXISTS move_stats (gameId INT NOT NULL, ply SMALLINT NOT NULL, "
+			"scoreType TINYINT NOT NULL, score INT NOT NULL, depth SMALLINT NOT NULL, nodes BIGINT NOT NULL, "
+			"nps BIGINT NOT NULL, time INT NOT NULL, PRIMARY KEY (gameId, ply))"
+	});
+	// Game browser pages through games ordered by date (see GamesTableModel)
+	QSqlQuery query(database);
+	query.prepare("SELECT COUNT(*) FROM information_schema.statistics WHERE "
+		"table_schema = DATABASE() AND table_name = 'games' AND index_name = 'date_id'");
+	if (query.exec() && query.first() && query.value(0).toInt() == 0)
+		query.exec("CREATE INDEX date_id ON games (date, id)");
+	// Columns added later than games table: packed moves (see db::encodeMoves) and game hash
+	const auto hasColumn = [&query](const char* column) {
+		query.prepare("SELECT COUNT(*) FROM information_schema.columns WHERE "
+			"table_schema = DATABASE() AND table_name = 'games' AND column_name = ?");
+		query.addBindValue(column);
+		return !query.exec() || !query.first() || query.value(0).toInt() > 0;
+	};
+	if (!hasColumn("moves"))
+		query.exec("ALTER TABLE games ADD COLUMN moves MEDIUMBLOB, ADD COLUMN startFEN VARCHAR(100)");
+	if (!hasColumn("moveHash"))
+		query.exec("ALTER TABLE games ADD COLUMN moveHash BIGINT, ADD UNIQUE KEY moveHash (moveHash)");
+}
+
+bool MySQLBackend::beginWrite(QSqlDatabase database) const
+{
+	return database.transaction();
+}
+
+QString MySQLBackend::lockForUpdate(void) const
+{
+	return " FOR UPDATE";
+}
+
+int MySQLBackend::maxBindValues(void) const
+{
+	return 65535;
+}
+
+void MySQLBackend::createDatabase(void) const
+{
+	const QString connectionName = "mysql_admin";
+	{
+		QSqlDatabase database = addConnection(connectionName);
+		if (!database.open())
+			throw std::runtime_error("Could not connect to MySQL: " + database.lastError().text().toStdString());
+		QSqlQuery query(database);
+		if (!query.exec("CREATE DATABASE IF NOT EXISTS `" + m_databaseName + '`'))
+			throw std::runtime_error("Could not create database: " + query.lastError().text().toStdString());
+	}
+	QSqlDatabase::removeDatabase(connectionName);
+}
+
+void MySQLBackend::dropDatabase(void) const
+{
+	const QString connectionName = "mysql_admin";
+	{
+		QSqlDatabase database = addConnection(connectionName);
+		if (!database.open())
+			throw std::runtime_error("Could not connect to MySQL: " + database.lastError().text().toStdString());
+		QSqlQuery query(database);
+		if (!query.exec("DROP DATABASE IF EXISTS `" + m_databaseName + '`'))
+			throw std::runtime_error("Could not drop database: " + query.lastError().text().toStdString());
+	}
+	QSqlDatabase::removeDatabase(connectionName);
+}
+
+//============================================================
+// SQLiteBackend
+//============================================================
+
+SQLiteBackend::SQLiteBackend(const QString& path)
+	: m_path(path)
+{}
+
+QString SQLiteBackend::name(void) const
+{
+	return "sqlite";
+}
+
+QSqlDatabase SQLiteBackend::connect(const QString& connectionName) const
+{
+	QSqlDatabase database = QSqlDatabase::addDatabase("QSQLITE", connectionName);
+	database.setDatabaseName(m_path);
+	// Wait for the other connection's write transaction instead of failing with SQLITE_BUSY
+	database.setConnectOptions("QSQLITE_BUSY_TIMEOUT=10000");
+	if (!database.open())
+		return database;
+	// WAL lets readers run alongside the writer, and with it synchronous=NORMAL
+	// is still safe against corruption (only the last commits may be lost on power failure)
+	execAll(database, {
+		"PRAGMA journal_mode = WAL",
+		"PRAGMA synchronous = NORMAL",
+		"PRAGMA cache_size = -65536", // KiB, i.e. 64 MiB of page cache
+		"PRAGMA temp_store = MEMORY",
+		"PRAGMA mmap_size = 268435456",
+		"PRAGMA wal_autocheckpoint = 4096"
+	});
+	return database;
+}
+
+void SQLiteBackend::ensureSchema(QSqlDatabase database) const
+{
+	// INTEGER PRIMARY KEY is the rowid, so it's assigned automatically like AUTO_INCREMENT
+	execAll(database, {
+		"CREATE TABLE IF NOT EXISTS persons (id INTEGER PRIMARY KEY, name TEXT NOT NULL)",
+		"CREATE INDEX IF NOT EXISTS persons_name ON persons (name)",
+		"CREATE TABLE IF NOT EXISTS players (id INTEGER PRIMARY KEY, ELO INTEGER NOT NULL DEFAULT 0)",
+		"CREATE TABLE IF NOT EXISTS human_players (id INTEGER PRIMARY KEY, personId INTEGER NOT NULL)",
+		"CREATE TABLE IF NOT EXISTS engine_players (id INTEGER PRIMARY KEY, authorId INTEGER, "
+			"programmingLanguage TEXT, name TEXT NOT NULL, version TEXT, path TEXT)",
+		"CREATE INDEX IF NOT EXISTS engine_players_name ON engine_players (name)",
+		"CREATE TABLE IF NOT EXISTS games (id INTEGER PRIMARY KEY, whitePlayerId INTEGER NOT NULL, "
+			"blackPlayerId INTEGER NOT NULL, PGN TEXT NOT NULL, moves BLOB, startFEN TEXT, moveHash INTEGER, date DATE, result TEXT)",
+		"CREATE INDEX IF NOT EXISTS date_id ON games (date, id)",
+		"CREATE INDEX IF NOT EXISTS games_white ON games (whitePlayerId)",
+		"CREATE INDEX IF NOT EXISTS games_black ON games (blackPlayerId)",
+		// Without rowid the table is clustered by key like InnoDB one
+		"CREATE TABLE IF NOT EXISTS game_positions (zobrist INTEGER NOT NULL, gameId INTEGER NOT NULL, "
+			"ply INTEGER NOT NULL, PRIMARY KEY (zobrist, gameId)) WITHOUT ROWID",
+		"CREATE INDEX IF NOT EXISTS game_positions_game ON game_positions (gameId)",
+		"CREATE TABLE IF NOT EXISTS move_stats (gameId INTEGER NOT NULL, ply INTEGER NOT NULL, "
+			"scoreType INTEGER NOT NULL, score INTEGER NOT NULL, depth INTEGER NOT NULL, nodes INTEGER NOT NULL, "
+			"nps INTEGER NOT NULL, time INTEGER NOT NULL, PRIMARY KEY (gameId, ply)) WITHOUT ROWID"
+	});
+	// Columns added later than games table: packed moves (see db::encodeMoves) and game hash
+	QStringList columns;
+	QSqlQuery query(database);
+	if (query.exec("PRAGMA table_info(games)"))
+		while (query.next())
+			columns << query.value("name").toString();
+	query.finish();
+	if (!columns.contains("moves"))
+		execAll(database, {
+			"ALTER TABLE games ADD COLUMN moves BLOB",
+			"ALTER TABLE games ADD COLUMN startFEN TEXT"
+		});
+	if (!columns.contains("moveHash"))
+		execAll(database, { "ALTER TABLE games ADD COLUMN moveHash INTEGER" });
+	execAll(database, { "CREATE UNIQUE INDEX IF NOT EXISTS games_move_hash ON games (moveHash)" });
+}
+
+bool SQLiteBackend::beginWrite(QSqlDatabase database) const
+{
+	// Deferred transaction would take the write lock only at the first write,
+	// after ids were already read by SELECT MAX(id)
+	QSqlQuery query(database);
+	return query.exec("BEGIN IMMEDIATE");
+}
+
+QString SQLiteBackend::lockForUpdate(void) const
+{
+	return QString(); // Whole database is locked by BEGIN IMMEDIATE
+}
+
+int SQLiteBackend::maxBindValues(void) const
+{
+	// SQLITE_MAX_VARIABLE_NUMBER default before 3.32, which is what Qt 5.12 bundles
+	return 999;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <QtSql>
+#include <memory>
+#include <stdexcept>
+
+// Database server (or embedded engine) the application stores its data in.
+// Everything which differs between SQL dialects and drivers is kept here,
+// queries elsewhere stick to SQL understood by all backends
+class StorageBackend
+{
+public:
+	virtual ~StorageBackend(void) = default;
+	// Short name for messages ("mysql", "sqlite")
+	virtual QString name(void) const = 0;
+	// Add connection with given name and open it. Result should be checked with isOpen()
+	virtual QSqlDatabase connect(const QString& connectionName) const = 0;
+	// Create missing tables and indices
+	virtual void ensureSchema(QSqlDatabase database) const = 0;
+	// Start transaction which is going to write, so that other writers wait
+	// for its end instead of failing on conflicts. Returns false on failure
+	virtual bool beginWrite(QSqlDatabase database) const = 0;
+	// Clause appended to SELECT to lock selected rows until the end of transaction
+	virtual QString lockForUpdate(void) const = 0;
+	// Maximum count of bound values in one statement
+	virtual int maxBindValues(void) const = 0;
+	// Backend by its specification: "mysql[:database]" or "sqlite:path".
+	// Throws std::runtime_error if it's malformed
+	static std::unique_ptr<StorageBackend> create(const QString& spec);
+};
+
+// MySQL server on localhost
+class MySQLBackend : public StorageBackend
+{
+public:
+	MySQLBackend(const QString& databaseName = "chessdb");
+	QString name(void) const override;
+	QSqlDatabase connect(const QString& connectionName) const override;
+	void ensureSchema(QSqlDatabase database) const override;
+	bool beginWrite(QSqlDatabase database) const override;
+	QString lockForUpdate(void) const override;
+	int maxBindValues(void) const override;
+	// Create and drop the database itself (used by benchmarks). Throw std::runtime_error on failure
+	void createDatabase(void) const;
+	void dropDatabase(void) const;
+private:
+	// Connection with server settings but without database selected
+	QSqlDatabase addConnection(const QString& connectionName) const;
+
+	QString m_databaseName;
+};
+
+// Embedded database in a single file, no server needed. Uses write-ahead
+// log so that readers (browser pages, position search) don't block the writer
+class SQLiteBackend : public StorageBackend
+{
+public:
+	SQLiteBackend(const QString& path);
+	QString name(void) const override;
+	QSqlDatabase connect(const QString& connectionName) const override;
+	void ensureSchema(QSqlDatabase database) const override;
+	bool beginWrite(QSqlDatabase database) const override;
+	QString lockForUpdate(void) const override;
+	int maxBindValues(void) const override;
+	inline const QString& path(void) const noexcept;
+private:
+	QString m_path;
+};
+
+inline const QString& SQLiteBackend::path(void) const noexcept
+{
+	return m_path;
+}
@@ -0,0 +1,418 @@
+#include "Tournament.h"
+#include "Database.h"
+#include "PlayerRegistry.h"
+#include "PGN.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <numeric>
+
+using namespace BlendXChess;
+
+namespace
+{
+	void printStandings(const TournamentRunner& runner, double seconds)
+	{
+		const std::vector<Score>& scores = runner.scores();
+		const std::vector<MatchEngine>& engines = runner.config().engines;
+		std::vector<int> order(scores.size());
+		std::iota(order.begin(), order.end(), 0);
+		std::stable_sort(order.begin(), order.end(),
+			[&scores](int lhs, int rhs) {return scores[lhs].points() > scores[rhs].points(); });
+		std::cout << "\nStandings after " << runner.gamesPlayed() << " games (" << seconds << " s):\n";
+		for (size_t place = 0; place < order.size(); ++place)
+		{
+			const Score& score = scores[order[place]];
+			std::cout << std::setw(3) << place + 1 << ". " << std::left << std::setw(24)
+				<< engines[order[place]].name.toStdString() << std::right
+				<< std::setw(7) << score.points() << '/' << score.games()
+				<< "  +" << score.wins << " =" << score.draws << " -" << score.losses << '\n';
+		}
+		if (runner.hasStats())
+			std::cout << engines[0].name.toStdString() << ": " << runner.stats().summary(
+				runner.config().sprt ? &runner.config().sprtParams : nullptr) << '\n';
+		std::cout << std::flush;
+	}
+}
+
+TournamentRunner::TournamentRunner(const TournamentConfig& config, QObject* parent)
+	: QObject(parent), m_config(config), m_total(0), m_played(0), m_running(0), m_stopped(false)
+{
+	qRegisterMetaType<MatchResult>("MatchResult");
+	m_scores.resize(m_config.engines.size());
+}
+
+int TournamentRunner::runFromCommandLine(QCoreApplication& app)
+{
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Headless engine tournament");
+	parser.addHelpOption();
+	parser.addOptions({
+		{ "tournament", "Run tournament instead of GUI." },
+		{ { "e", "engine" }, "Participant: id in engine_players table or path to executable.", "engine" },
+		{ "schedule", "roundrobin (default) or gauntlet (first engine against others).", "type", "roundrobin" },
+		{ "rounds", "Number of color-reversed game pairs per pairing.", "n", "1" },
+		{ "concurrency", "Games played simultaneously (default: cores / cores-per-game).", "n", "0" },
+		{ "cores", "CPUs available for engines (default: all).", "n", "0" },
+		{ "cores-per-game", "CPUs each game is pinned to, 0 disables pinning.", "n", "1" },
+		{ "threads", "Worker threads driving games (default: automatic).", "n", "0" },
+		{ "depth", "Search depth per move.", "plies", "0" },
+		{ "movetime", "Search time per move.", "ms", "0" },
+		{ "tc", "Clock time control, base+increment in seconds.", "base+inc" },
+		{ "book", "Opening book in EPD or PGN format.", "file" },
+		{ "book-random", "Use book openings in random order." },
+		{ "pgn", "Append finished games to this PGN file.", "file" },
+		{ "db", "Store games between database engines in games table." },
+		{ "option", "UCI option for all engines.", "name=value" },
+		{ "max-plies", "Adjudicate draw after this many plies.", "n", "0" },
+		{ "timeout", "Time after which engine not answering is considered stalled.", "ms", "30000" },
+		{ "sprt", "Stop when SPRT of first engine's Elo gain accepts H0 or H1.", "elo0,elo1[,alpha,beta]" }
+		});
+	parser.process(app);
+
+	TournamentConfig config;
+	std::vector<std::pair<std::string, std::string>> options;
+	for (const QString& option : parser.values("option"))
+	{
+		const int eq = option.indexOf('=');
+		if (eq <= 0)
+		{
+			std::cerr << "Option should be given as name=value: " << option.toStdString() << std::endl;
+			return 1;
+		}
+		options.emplace_back(option.left(eq).toStdString(), option.mid(eq + 1).toStdString());
+	}
+	bool needDB = parser.isSet("db");
+	for (const QString& engine : parser.values("engine"))
+	{
+		bool isId;
+		engine.toInt(&isId);
+		needDB |= isId;
+	}
+	if (needDB && !db::openDefault().isOpen())
+	{
+		std::cerr << "Could not connect to database: "
+			<< QSqlDatabase::database().lastError().text().toStdString() << std::endl;
+		return 1;
+	}
+	Game::initialize();
+	try
+	{
+		PlayerRegistry players; // All engines are loaded with one query
+		for (const QString& engine : parser.values("engine"))
+		{
+			MatchEngine participant;
+			bool isId;
+			const int id = engine.toInt(&isId);
+			if (isId)
+			{
+				const PlayerRegistry::Engine record = players.engine(id);
+				participant.name = record.name;
+				participant.path = record.path;
+				participant.playerId = id;
+			}
+			else
+			{
+				participant.name = QFileInfo(engine).completeBaseName();
+				participant.path = engine;
+			}
+			participant.options = options;
+			config.engines.push_back(participant);
+		}
+		// Same engine may take part several times, so tell such participants apart
+		for (size_t i = 0; i < config.engines.size(); ++i)
+			for (size_t j = i + 1, copy = 2; j < config.engines.size(); ++j)
+				if (config.engines[j].name == config.engines[i].name)
+					config.engines[j].name += QString(" (%1)").arg(copy++);
+		config.schedule = parser.value("schedule") == "gauntlet"
+			? TournamentConfig::Schedule::Gauntlet : TournamentConfig::Schedule::RoundRobin;
+		config.rounds = parser.value("rounds").toInt();
+		config.concurrency = parser.value("concurrency").toInt();
+		config.cores = parser.value("cores").toInt();
+		config.coresPerGame = parser.value("cores-per-game").toInt();
+		config.threads = parser.value("threads").toInt();
+		config.timeControl.depth = parser.value("depth").toInt();
+		config.timeControl.movetime = parser.value("movetime").toInt();
+		if (parser.isSet("tc"))
+		{
+			const QStringList parts = parser.value("tc").split('+');
+			config.timeControl.base = int(parts[0].toDouble() * 1000);
+			config.timeControl.increment = parts.size() > 1 ? int(parts[1].toDouble() * 1000) : 0;
+		}
+		if (config.timeControl.depth == 0 && config.timeControl.movetime == 0 && config.timeControl.base == 0)
+			config.timeControl.depth = 10; // Same default as for GUI games
+		config.bookPath = parser.value("book").toStdString();
+		config.bookRandom = parser.isSet("book-random");
+		config.pgnPath = parser.value("pgn").toStdString();
+		config.storeInDB = parser.isSet("db");
+		config.maxPlies = parser.value("max-plies").toInt();
+		config.moveTimeout = parser.value("timeout").toInt();
+		if (parser.isSet("sprt"))
+		{
+			const QStringList parts = parser.value("sprt").split(',');
+			if (parts.size() != 2 && parts.size() != 4)
+				throw std::runtime_error("SPRT should be given as elo0,elo1 or elo0,elo1,alpha,beta");
+			config.sprt = true;
+			config.sprtParams.elo0 = parts[0].toDouble();
+			config.sprtParams.elo1 = parts[1].toDouble();
+			if (parts.size() == 4)
+				config.sprtParams.alpha = parts[2].toDouble(), config.sprtParams.beta = parts[3].toDouble();
+		}
+
+		TournamentRunner runner(config);
+		QElapsedTimer elapsed;
+		connect(&runner, &TournamentRunner::gameFinished, [&runner](int, const MatchResult& result) {
+			const std::vector<MatchEngine>& engines = runner.config().engines;
+			std::cout << "Game " << result.gameIndex + 1 << '/' << runner.gamesTotal() << ": "
+				<< engines[result.white].name.toStdString() << " - "
+				<< engines[result.black].name.toStdString() << ' ' << result.result.toStdString()
+				<< " (" << result.termination.toStdString() << ", " << result.plies << " plies)" << std::endl;
+			if (runner.hasStats() && result.result != "*")
+				std::cout << "  " << runner.stats().summary(
+					runner.config().sprt ? &runner.config().sprtParams : nullptr) << std::endl;
+		});
+		connect(&runner, &TournamentRunner::sprtFinished, [&runner](MatchStats::SPRTResult result) {
+			const MatchStats::SPRTParams& params = runner.config().sprtParams;
+			if (result == MatchStats::SPRTResult::AcceptH0)
+				std::cout << "SPRT: H0 accepted (elo <= " << params.elo0 << "), stopping" << std::endl;
+			else
+				std::cout << "SPRT: H1 accepted (elo >= " << params.elo1 << "), stopping" << std::endl;
+		});
+		connect(&runner, &TournamentRunner::tournamentFinished, [&runner, &elapsed](void) {
+			if (runner.config().storeInDB)
+			{
+				const DBWriter::Stats& stats = runner.dbStats();
+				std::cout << stats.written << " games stored in database";
+				if (stats.duplicates > 0)
+					std::cout << " (" << stats.duplicates << " were already there)";
+				std::cout << std::endl;
+				if (stats.failed > 0)
+					std::cerr << stats.failed << " games couldn't be stored: "
+						<< stats.lastError.toStdString() << std::endl;
+			}
+			printStandings(runner, elapsed.elapsed() / 1000.0);
+		});
+		connect(&runner, &TournamentRunner::tournamentFinished, &app, &QCoreApplication::quit, Qt::QueuedConnection);
+		elapsed.start();
+		runner.start();
+		std::cout << "Tournament of " << config.engines.size() << " engines, " << runner.gamesTotal() << " games, "
+			<< runner.slotCount() << " concurrent on " << runner.threadCount() << " threads" << std::endl;
+		return app.exec();
+	}
+	catch (const std::runtime_error& err)
+	{
+		std::cerr << err.what() << std::endl;
+		return 1;
+	}
+}
+
+TournamentRunner::~TournamentRunner(void)
+{
+	// Games are deleted in their threads when those finish
+	for (QThread* thread : m_threads)
+	{
+		thread->quit();
+		thread->wait();
+		delete thread;
+	}
+}
+
+void TournamentRunner::start(void)
+{
+	if (m_config.engines.size() < 2)
+		throw std::runtime_error("At least two engines are needed for a tournament");
+	// Otherwise no game would start and tournamentFinished would never be emitted
+	if (m_config.rounds < 1)
+		throw std::runtime_error("At least one round is needed for a tournament");
+	if (!m_config.bookPath.empty())
+	{
+		m_book.load(m_config.bookPath);
+		if (m_config.bookRandom)
+			m_book.shuffle(unsigned(QDateTime::currentMSecsSinceEpoch()));
+	}
+	if (!m_config.pgnPath.empty())
+	{
+		m_pgnOut.open(m_config.pgnPath, std::ios::app);
+		if (!m_pgnOut)
+			throw std::runtime_error("Could not open PGN file " + m_config.pgnPath);
+	}
+	if (m_config.storeInDB)
+		m_dbWriter = std::make_unique<DBWriter>(DBWriter::Options(), "tournament_db_writer");
+	schedule();
+	// Split core budget between simultaneous games
+	const int cores = m_config.cores > 0 ? m_config.cores : QThread::idealThreadCount();
+	const int coresPerGame = m_config.coresPerGame;
+	int concurrency = m_config.concurrency > 0 ? m_config.concurrency
+		: std::max(1, cores / std::max(coresPerGame, 1));
+	concurrency = std::min(concurrency, m_total);
+	// Games mostly wait for engines, so one thread can drive several of them
+	const int threadCount = std::min(concurrency,
+		m_config.threads > 0 ? m_config.threads : (concurrency + 7) / 8);
+	for (int i = 0; i < threadCount; ++i)
+	{
+		m_threads.push_back(new QThread);
+		m_threads.back()->start();
+	}
+	m_slotEngines.assign(concurrency, { -1, -1 });
+	for (int slot = 0; slot < concurrency; ++slot)
+	{
+		quint64 cpuMask = 0;
+		if (coresPerGame > 0 && (slot + 1) * coresPerGame <= std::min(cores, 64))
+			cpuMask = ((coresPerGame == 64 ? 0 : quint64(1) << coresPerGame) - 1) << (slot * coresPerGame);
+		MatchGame* game = new MatchGame(slot, cpuMask);
+		QThread* thread = m_threads[slot % threadCount];
+		game->moveToThread(thread);
+		connect(thread, &QThread::finished, game, &QObject::deleteLater);
+		connect(game, &MatchGame::finished, this, &TournamentRunner::sGameFinished);
+		connect(game, &MatchGame::positionChanged, this, &TournamentRunner::positionChanged);
+		m_slots.push_back(game);
+	}
+	for (int slot = 0; slot < concurrency; ++slot)
+		startNext(slot);
+}
+
+void TournamentRunner::stop(void)
+{
+	m_stopped = true;
+	m_pending.clear();
+}
+
+void TournamentRunner::schedule(void)
+{
+	std::vector<std::pair<int, int>> pairings;
+	const int engineCount = int(m_config.engines.size());
+	for (int first = 0; first < engineCount; ++first)
+		for (int second = first + 1; second < engineCount; ++second)
+			if (m_config.schedule == TournamentConfig::Schedule::RoundRobin || first == 0)
+				pairings.emplace_back(first, second);
+	// Each opening is played twice with reversed colors, so that it doesn't favour any engine
+	int pairIndex = 0;
+	for (int round = 0; round < m_config.rounds; ++round)
+		for (const auto& [first, second] : pairings)
+		{
+			const Opening opening = m_book.empty() ? Opening() : m_book[pairIndex % m_book.size()];
+			for (const auto& [white, black] : { std::pair(first, second), std::pair(second, first) })
+			{
+				MatchSetup setup;
+				setup.gameIndex = m_total++;
+				setup.pairIndex = pairIndex;
+				setup.round = round;
+				setup.white = white;
+				setup.black = black;
+				setup.whiteEngine = m_config.engines[white];
+				setup.blackEngine = m_config.engines[black];
+				setup.opening = opening;
+				setup.timeControl = m_config.timeControl;
+				setup.maxPlies = m_config.maxPlies;
+				setup.moveTimeout = m_config.moveTimeout;
+				m_pending.push_back(setup);
+			}
+			++pairIndex;
+		}
+}
+
+void TournamentRunner::startNext(int slot)
+{
+	if (m_pending.empty())
+		return;
+	// Look a little ahead for a game with engines already running in this slot
+	const auto lastEngines = m_slotEngines[slot];
+	const size_t lookahead = std::min(m_pending.size(), 2 * m_slots.size());
+	size_t chosen = 0;
+	for (size_t i = 0; i < lookahead; ++i)
+		if (std::minmax(m_pending[i].white, m_pending[i].black)
+			== std::minmax(lastEngines.first, lastEngines.second))
+		{
+			chosen = i;
+			break;
+		}
+	const MatchSetup setup = m_pending[chosen];
+	m_pending.erase(m_pending.begin() + chosen);
+	m_slotEngines[slot] = { setup.white, setup.black };
+	++m_running;
+	MatchGame* game = m_slots[slot];
+	QMetaObject::invokeMethod(game, [game, setup]() {game->play(setup); }, Qt::QueuedConnection);
+	emit gameStarted(slot, setup.whiteEngine.name, setup.blackEngine.name);
+}
+
+void TournamentRunner::sGameFinished(int slot, const MatchResult& result)
+{
+	--m_running;
+	++m_played;
+	if (result.result == "1-0")
+		++m_scores[result.white].wins, ++m_scores[result.black].losses;
+	else if (result.result == "0-1")
+		++m_scores[result.black].wins, ++m_scores[result.white].losses;
+	else if (result.result == "1/2-1/2")
+		++m_scores[result.white].draws, ++m_scores[result.black].draws;
+	const MatchStats::SPRTResult sprt = updateStats(result);
+	writePGN(result);
+	storeResult(result);
+	emit gameFinished(slot, result);
+	if (sprt != MatchStats::SPRTResult::Continue)
+		emit sprtFinished(sprt);
+	if (!m_stopped)
+		startNext(slot);
+	if (m_running == 0 && m_pending.empty())
+	{
+		if (m_dbWriter)
+			m_dbStats = m_dbWriter->finish();
+		emit tournamentFinished();
+	}
+}
+
+MatchStats::SPRTResult TournamentRunner::updateStats(const MatchResult& result)
+{
+	if (!hasStats() || result.result == "*")
+		return MatchStats::SPRTResult::Continue;
+	const double whiteScore = result.result == "1-0" ? 1.0 : result.result == "0-1" ? 0.0 : 0.5;
+	const double score = result.white == 0 ? whiteScore : 1.0 - whiteScore;
+	m_stats.addGame(score);
+	if (const auto it = m_pairScores.find(result.pairIndex); it != m_pairScores.end())
+	{
+		m_stats.addPair(it->second, score);
+		m_pairScores.erase(it);
+	}
+	else
+		m_pairScores.emplace(result.pairIndex, score);
+	if (!m_config.sprt || m_stopped)
+		return MatchStats::SPRTResult::Continue;
+	const MatchStats::SPRTResult sprt = m_stats.sprt(m_config.sprtParams);
+	if (sprt != MatchStats::SPRTResult::Continue)
+		stop();
+	return sprt;
+}
+
+void TournamentRunner::writePGN(const MatchResult& result)
+{
+	if (!m_pgnOut.is_open())
+		return;
+	pgn::Record record;
+	record.setTag("Event", "BlendXGui tournament");
+	record.setTag("Site", QSysInfo::machineHostName().toStdString());
+	record.setTag("Date", QDate::currentDate().toString("yyyy.MM.dd").toStdString());
+	record.setTag("Round", std::to_string(result.round + 1));
+	record.setTag("White", m_config.engines[result.white].name.toStdString());
+	record.setTag("Black", m_config.engines[result.black].name.toStdString());
+	record.setTag("Result", result.result.toStdString());
+	if (!result.startFEN.isEmpty())
+	{
+		record.setTag("SetUp", "1");
+		record.setTag("FEN", result.startFEN.toStdString() + " 0 1");
+	}
+	record.setTag("PlyCount", std::to_string(result.plies));
+	record.setTag("Termination", result.termination.toStdString());
+	record.movetext = result.movetext.toStdString();
+	record.result = result.result.toStdString();
+	pgn::write(m_pgnOut, record);
+	m_pgnOut.flush();
+}
+
+void TournamentRunner::storeResult(const MatchResult& result)
+{
+	const int whiteId = m_config.engines[result.white].playerId;
+	const int blackId = m_config.engines[result.black].playerId;
+	if (!m_dbWriter || whiteId < 0 || blackId < 0 || result.result == "*")
+		return;
+	m_dbWriter->push({ whiteId, blackId, result.moves, result.startFEN, result.result, QDate::currentDate(), {} });
+}
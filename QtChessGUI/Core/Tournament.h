@@ -0,0 +1,156 @@
+#pragma once
+#include <QtCore>
+#include <deque>
+#include <map>
+#include <fstream>
+#include <vector>
+#include "MatchGame.h"
+#include "OpeningBook.h"
+#include "MatchStats.h"
+#include "DBWriter.h"
+
+struct TournamentConfig
+{
+	enum class Schedule {
+		RoundRobin, // Every engine plays every other
+		Gauntlet // First engine plays all others
+	};
+	std::vector<MatchEngine> engines;
+	Schedule schedule = Schedule::RoundRobin;
+	int rounds = 1; // Each round is a pair of games with reversed colors for every pairing
+	int concurrency = 0; // Games played simultaneously, 0 to derive from core budget
+	int cores = 0; // CPUs available for engines, 0 for all
+	int coresPerGame = 1; // Engines of a game are pinned to this many CPUs (0 disables pinning)
+	int threads = 0; // Worker threads driving games, 0 to choose automatically
+	TimeControl timeControl;
+	int maxPlies = 0;
+	int moveTimeout = 30000; // ms
+	std::string bookPath;
+	bool bookRandom = false;
+	std::string pgnPath; // Finished games are appended here if not empty
+	bool storeInDB = false; // Whether to store games between database players in games table
+	bool sprt = false; // Whether to stop as soon as SPRT accepts a hypothesis
+	MatchStats::SPRTParams sprtParams;
+};
+
+// Standing of a tournament participant
+struct Score
+{
+	int wins = 0, draws = 0, losses = 0;
+	inline int games(void) const noexcept
+	{
+		return wins + draws + losses;
+	}
+	inline double points(void) const noexcept
+	{
+		return wins + 0.5 * draws;
+	}
+};
+
+// Headless runner of engine tournaments. Games are played concurrently, each one by
+// a MatchGame living in one of worker threads, while results are collected here. Progress is
+// only reported by signals, runFromCommandLine prints it to console
+class TournamentRunner : public QObject
+{
+	Q_OBJECT
+
+public:
+	TournamentRunner(const TournamentConfig& config, QObject* parent = nullptr);
+	~TournamentRunner(void);
+	// Parse command line options of --tournament mode and play the tournament, returning exit code
+	static int runFromCommandLine(QCoreApplication& app);
+	// Load book, schedule games and start them. Throws std::runtime_error if book can't be loaded
+	void start(void);
+	void stop(void);
+	inline const TournamentConfig& config(void) const noexcept;
+	inline int gamesTotal(void) const noexcept;
+	inline int gamesPlayed(void) const noexcept;
+	inline const std::vector<Score>& scores(void) const noexcept;
+	// Statistics of the first engine against others, kept for matches and gauntlets
+	inline const MatchStats& stats(void) const noexcept;
+	inline bool hasStats(void) const noexcept;
+	// Count of games played simultaneously and of threads driving them (known after start)
+	inline int slotCount(void) const noexcept;
+	inline int threadCount(void) const noexcept;
+	// Statistics of storing games in database (known when tournament is finished, if config.storeInDB)
+	inline const DBWriter::Stats& dbStats(void) const noexcept;
+signals:
+	void gameStarted(int slot, const QString& white, const QString& black);
+	void gameFinished(int slot, const MatchResult& result);
+	// Emitted after every move of the game played in the slot (queued from worker threads)
+	void positionChanged(int slot, const QString& fen);
+	// Emitted when SPRT accepts a hypothesis (if config.sprt), remaining games aren't started then
+	void sprtFinished(MatchStats::SPRTResult result);
+	void tournamentFinished(void);
+private:
+	void schedule(void);
+	// Give next game to the idle slot, preferring one with the same engines to keep them warm
+	void startNext(int slot);
+	void sGameFinished(int slot, const MatchResult& result);
+	// Returns SPRT decision if it stops the tournament
+	MatchStats::SPRTResult updateStats(const MatchResult& result);
+	void writePGN(const MatchResult& result);
+	void storeResult(const MatchResult& result);
+	// Data
+	TournamentConfig m_config;
+	OpeningBook m_book;
+	std::deque<MatchSetup> m_pending;
+	std::vector<MatchGame*> m_slots;
+	std::vector<std::pair<int, int>> m_slotEngines; // Participants of last game in the slot
+	std::vector<QThread*> m_threads;
+	std::vector<Score> m_scores;
+	MatchStats m_stats;
+	std::map<int, double> m_pairScores; // First engine's score in pairs with one finished game
+	std::ofstream m_pgnOut;
+	std::unique_ptr<DBWriter> m_dbWriter; // Stores games in database without blocking the runner
+	DBWriter::Stats m_dbStats;
+	int m_total;
+	int m_played;
+	int m_running;
+	bool m_stopped;
+};
+
+inline const TournamentConfig& TournamentRunner::config(void) const noexcept
+{
+	return m_config;
+}
+
+inline int TournamentRunner::gamesTotal(void) const noexcept
+{
+	return m_total;
+}
+
+inline int TournamentRunner::gamesPlayed(void) const noexcept
+{
+	return m_played;
+}
+
+inline int TournamentRunner::slotCount(void) const noexcept
+{
+	return int(m_slots.size());
+}
+
+inline int TournamentRunner::threadCount(void) const noexcept
+{
+	return int(m_threads.size());
+}
+
+inline const DBWriter::Stats& TournamentRunner::dbStats(void) const noexcept
+{
+	return m_dbStats;
+}
+
+inline const std::vector<Score>& TournamentRunner::scores(void) const noexcept
+{
+	return m_scores;
+}
+
+inline const MatchStats& TournamentRunner::stats(void) const noexcept
+{
+	return m_stats;
+}
+
+inline bool TournamentRunner::hasStats(void) const noexcept
+{
+	return m_config.engines.size() == 2 || m_config.schedule == TournamentConfig::Schedule::Gauntlet;
+}
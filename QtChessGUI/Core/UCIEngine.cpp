@@ -1,14 +1,27 @@
 #include "UCIEngine.h"
 #include "misc.h"
 #include <sstream>
+#include <set>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <sched.h>
+#endif
 
 UCIEngine::UCIEngine(void)
-	: m_state(State::NotSet), m_eventCallback(EmptyCallback)
-{}
+	: m_state(State::NotSet), m_discardBestmoves(0), m_pendingPings(0), m_eventCallback(EmptyCallback),
+	m_io(&m_process)
+{
+	connectProcess();
+}
 
 UCIEngine::UCIEngine(QString path, Callback eventCallback)
-	: m_state(State::NotSet)
+	: m_state(State::NotSet), m_discardBestmoves(0), m_pendingPings(0), m_io(&m_process)
 {
+	connectProcess();
 	reset(path, eventCallback);
 }
 
@@ -17,16 +30,23 @@ UCIEngine::~UCIEngine(void)
 
 void UCIEngine::close(void)
 {
+	// State is reset first, so that process termination isn't reported as a crash
+	m_state = State::NotSet;
+	if (m_mock)
+	{
+		m_io = &m_process;
+		m_mock.reset();
+		return;
+	}
 	if (m_process.state() != QProcess::ProcessState::NotRunning)
 	{
-		m_process.write("stop\n"); // In case search is in process
+		m_io->write("stop\n"); // In case search is in process
 		m_process.closeWriteChannel();
 		if (!m_process.waitForFinished(2000))
 		{
 			m_process.kill();
 			throw std::runtime_error("Could not finish previous engine process, so killed it");
 		}
-		m_state = State::NotSet;
 		return;
 	}
 }
@@ -34,71 +54,258 @@ void UCIEngine::close(void)
 void UCIEngine::reset(QString path, Callback eventCallback)
 {
 	close();
-	m_process.start(path, QStringList());
-	if (!m_process.waitForStarted(5000))
-		throw std::runtime_error("Engine process could not have been started");
+	if (MockUCIEngine::isMockPath(path))
+	{
+		m_mock = std::make_unique<MockUCIEngine>(MockUCIEngine::parseConfig(path));
+		m_io = m_mock.get();
+		QObject::connect(m_mock.get(), &QIODevice::readyRead, [this]() {return sProcessInput(); });
+		QObject::connect(m_mock.get(), &QIODevice::readChannelFinished,
+			[this]() {return sProcessFinished(); });
+	}
+	else
+	{
+		m_process.start(path, QStringList());
+		if (!m_process.waitForStarted(5000))
+			throw std::runtime_error("Engine process could not have been started");
+	}
+	m_io->write("uci\n");
+	m_path = path;
+	m_options.clear();
+	m_state = State::WaitingUciOk;
+	m_eventCallback = eventCallback;
+	m_ponderStats = PonderStats();
+	m_discardBestmoves = 0;
+	m_pendingPings = 0;
+}
+
+void UCIEngine::reuse(Callback eventCallback)
+{
+	if (m_state != State::Ready)
+		throw std::runtime_error("Only idle engine can be reused");
+	m_state = State::SettingOptions;
+	m_eventCallback = eventCallback;
+	m_ponderStats = PonderStats();
+	// Notify asynchronously, as a freshly started engine would do
+	QTimer::singleShot(0, m_io, [this]() {
+		if (m_state != State::SettingOptions)
+			return;
+		m_eventInfo.type = UCIEventInfo::Type::UciOk;
+		m_eventCallback(this, &m_eventInfo);
+	});
+}
+
+void UCIEngine::detach(void)
+{
+	m_eventCallback = EmptyCallback;
+	if (m_state == State::Searching || m_state == State::Pondering)
+		sendStop(); // Engine will become Ready after sending (now ignored) bestmove
+}
+
+void UCIEngine::connectProcess(void)
+{
 	QObject::connect(&m_process, &QProcess::readyReadStandardOutput,
 		[this]() {return sProcessInput(); });
 	QObject::connect(&m_process, &QProcess::readyReadStandardError,
 		[this]() {return sProcessError(); });
-	m_process.write("uci\n");
-	m_state = State::WaitingUciOk;
-	m_eventCallback = eventCallback;
+	QObject::connect(&m_process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+		[this]() {return sProcessFinished(); });
+}
+
+bool UCIEngine::hasOptionValues(const OptionValues& values) const
+{
+	for (const auto& [name, value] : values)
+	{
+		auto it = m_options.find(name);
+		if (it == m_options.end())
+			return false;
+		// Value is normalized the same way as by setOptionFromString
+		UciOption wanted = it->second;
+		try
+		{
+			wanted.setValueFromString(value);
+		}
+		catch (const std::runtime_error&)
+		{
+			return false;
+		}
+		if (wanted.toString() != it->second.toString())
+			return false;
+	}
+	return true;
+}
+
+bool UCIEngine::isRunning(void) const
+{
+	if (m_mock)
+		return !m_mock->crashed();
+	return m_process.state() == QProcess::ProcessState::Running;
+}
+
+bool UCIEngine::isAlive(int timeout) const
+{
+	if (!isRunning())
+		return false;
+	return m_pendingPings == 0 || m_pingTimer.elapsed() < timeout;
+}
+
+bool UCIEngine::ponderEnabled(void) const
+{
+	auto it = m_options.find("Ponder");
+	return it != m_options.end() && it->second.getType() == UciOption::Type::Check
+		&& it->second.getBool();
 }
 
 void UCIEngine::setOptionFromString(const std::string& name, const std::string& value)
 {
 	UciOption& opt = getOption(name);
+	const std::string oldValue = opt.toString();
 	opt.setValueFromString(value);
-	writeSetOption(name, value);
+	if (opt.toString() != oldValue)
+		writeSetOption(name, opt.toString());
 }
 
 void UCIEngine::setOption(const std::string& name, const UciOption::ValueType& value)
 {
 	UciOption& opt = getOption(name);
+	const std::string oldValue = opt.toString();
 	opt.setValue(value);
-	writeSetOption(name, opt.toString());
+	// Engine already has this value, and resending (eg 'Hash') may cause costly reinitialization
+	if (opt.toString() != oldValue)
+		writeSetOption(name, opt.toString());
 }
 
 void UCIEngine::sendPosition(const std::string& positionFEN)
 {
-	if (positionFEN == "startpos")
-		m_process.write("startpos\n");
-	else
+	sendPosition(positionFEN, {});
+}
+
+void UCIEngine::sendPosition(const std::string& positionFEN, const std::vector<std::string>& moves)
+{
+	std::string line(positionFEN == "startpos" ? "position startpos" : "position fen " + positionFEN);
+	if (!moves.empty())
 	{
-		std::string line("position fen " + positionFEN + "\n");
-		m_process.write(line.data());
+		line += " moves";
+		for (const auto& move : moves)
+			line += ' ' + move;
 	}
+	line += '\n';
+	m_io->write(line.data());
 }
 
 void UCIEngine::sendNewGame(void)
 {
-	m_process.write("ucinewgame\n");
+	m_io->write("ucinewgame\n");
 }
 
 void UCIEngine::sendIsReady(void)
 {
 	if (m_state != State::SettingOptions)
 		return;
-	m_process.write("isready\n");
+	m_io->write("isready\n");
 	m_state = State::WaitingReadyOk;
 }
 
 void UCIEngine::sendGo(int depth)
 {
 	std::string line("go depth " + std::to_string(depth) + "\n");
-	m_process.write(line.data()); // TEMPORARILY
-	m_process.waitForBytesWritten(10000);
+	m_io->write(line.data()); // TEMPORARILY
+	m_io->waitForBytesWritten(10000);
+	m_state = State::Searching;
+}
+
+void UCIEngine::sendGo(const SearchLimits& limits)
+{
+	writeGo(limits, false);
+	m_state = State::Searching;
+}
+
+void UCIEngine::sendPonder(const SearchLimits& limits)
+{
+	writeGo(limits, true);
+	m_state = State::Pondering;
+}
+
+void UCIEngine::sendPonderHit(void)
+{
+	if (m_state != State::Pondering)
+		return;
+	m_io->write("ponderhit\n");
+	m_state = State::Searching;
+	++m_ponderStats.hits;
 }
 
 void UCIEngine::sendStop(void)
 {
-	m_process.write("stop\n");
+	m_io->write("stop\n");
+	if (m_state == State::Pondering)
+	{ // Result of search on mispredicted position is useless for the caller
+		++m_discardBestmoves;
+		++m_ponderStats.misses;
+		m_state = State::Ready;
+	}
+}
+
+void UCIEngine::sendPing(void)
+{
+	if (m_state != State::Ready)
+		return;
+	if (m_pendingPings++ == 0)
+		m_pingTimer.start();
+	m_io->write("isready\n");
+}
+
+void UCIEngine::sendSync(void)
+{
+	if (m_state != State::Ready)
+		return;
+	// Pings sent before are answered first, so this 'readyok' isn't taken for theirs
+	m_io->write("isready\n");
+	m_state = State::WaitingReadyOk;
+}
+
+bool UCIEngine::setAffinity(quint64 cpuMask)
+{
+	if (m_mock || !isRunning() || cpuMask == 0)
+		return false;
+#ifdef _WIN32
+	HANDLE handle = OpenProcess(PROCESS_SET_INFORMATION | PROCESS_QUERY_INFORMATION,
+		FALSE, DWORD(m_process.processId()));
+	if (!handle)
+		return false;
+	const bool ok = SetProcessAffinityMask(handle, DWORD_PTR(cpuMask));
+	CloseHandle(handle);
+	return ok;
+#elif defined(__linux__)
+	cpu_set_t cpuSet;
+	CPU_ZERO(&cpuSet);
+	for (int cpu = 0; cpu < 64; ++cpu)
+		if (cpuMask & (quint64(1) << cpu))
+			CPU_SET(cpu, &cpuSet);
+	return sched_setaffinity(pid_t(m_process.processId()), sizeof(cpuSet), &cpuSet) == 0;
+#else
+	return false;
+#endif
+}
+
+void UCIEngine::writeGo(const SearchLimits& limits, bool ponder)
+{
+	std::string line(ponder ? "go ponder" : "go");
+	const std::pair<const char*, int> params[] = {
+		{ "depth", limits.depth }, { "movetime", limits.movetime },
+		{ "wtime", limits.wtime }, { "btime", limits.btime },
+		{ "winc", limits.winc }, { "binc", limits.binc }
+	};
+	for (const auto& [name, value] : params)
+		if (value > 0)
+			line += std::string(" ") + name + ' ' + std::to_string(value);
+	line += '\n';
+	m_io->write(line.data());
 }
 
 void UCIEngine::readBestmove(std::istream& iss)
 {
 	std::string token;
+	m_eventInfo.ponderMove.clear();
 	iss >> m_eventInfo.bestMove;
 	if ((iss >> token) && token == "ponder")
 		iss >> m_eventInfo.ponderMove;
@@ -106,13 +313,67 @@ void UCIEngine::readBestmove(std::istream& iss)
 
 void UCIEngine::readInfo(std::istream& iss)
 {
-	// TEMPORARY EMPTY
+	InfoDetails& info = m_eventInfo.infoDetails;
+	info = InfoDetails();
+	static const std::set<std::string> keywords = { "depth", "seldepth", "time", "nodes", "pv", "multipv",
+		"score", "currmove", "currmovenumber", "hashfull", "nps", "tbhits", "sbhits", "cpuload", "string",
+		"refutation", "currline" };
+	std::string token;
+	bool pending = false; // Whether token was read by previous value and not handled yet
+	while (pending || iss >> token)
+	{
+		pending = false;
+		if (token == "depth")
+			iss >> info.depth;
+		else if (token == "seldepth")
+			iss >> info.selDepth;
+		else if (token == "multipv")
+			iss >> info.multiPV;
+		else if (token == "nodes")
+			iss >> info.nodes;
+		else if (token == "nps")
+			iss >> info.nps;
+		else if (token == "time")
+			iss >> info.time;
+		else if (token == "hashfull")
+			iss >> info.hashFull;
+		else if (token == "score")
+		{
+			iss >> token;
+			info.scoreType = token == "mate" ? InfoDetails::ScoreType::Mate : InfoDetails::ScoreType::Cp;
+			iss >> info.score;
+		}
+		else if (token == "lowerbound")
+			info.bound = InfoDetails::Bound::Lower;
+		else if (token == "upperbound")
+			info.bound = InfoDetails::Bound::Upper;
+		else if (token == "pv")
+			while (iss >> token)
+			{
+				if (keywords.count(token))
+				{
+					pending = true;
+					break;
+				}
+				if (!info.pv.empty())
+					info.pv += ' ';
+				info.pv += token;
+			}
+		else if (token == "string")
+		{ // Rest of the line
+			std::getline(iss, info.text);
+			info.text = misc::trim(info.text);
+		}
+		// Values of other keywords are skipped as unknown tokens
+		if (!iss && !iss.eof())
+			break; // Malformed number
+	}
 }
 
 void UCIEngine::writeSetOption(const std::string& name, const std::string& value)
 {
 	std::string line("setoption name " + name + " value " + value + "\n");
-	m_process.write(line.data());
+	m_io->write(line.data());
 }
 
 UciOption& UCIEngine::getOption(const std::string& name)
@@ -127,9 +388,9 @@ UciOption& UCIEngine::getOption(const std::string& name)
 
 void UCIEngine::sProcessInput(void)
 {
-	while (m_process.canReadLine())
+	while (m_io->canReadLine())
 	{
-		std::string line = m_process.readLine().toStdString(), cmd, token;
+		std::string line = m_io->readLine().toStdString(), cmd, token;
 		std::istringstream iss(line);
 		iss >> cmd;
 		if (cmd == "uciok")
@@ -157,12 +418,23 @@ void UCIEngine::sProcessInput(void)
 		}
 		else if (cmd == "readyok")
 		{
+			if (m_pendingPings > 0)
+			{ // Answers come in order, so this one is for the oldest ping
+				if (--m_pendingPings > 0)
+					m_pingTimer.start();
+				continue;
+			}
 			m_state = State::Ready;
 			m_eventInfo.type = UCIEventInfo::Type::ReadyOk;
 			m_eventCallback(this, &m_eventInfo);
 		}
 		else if (cmd == "bestmove")
 		{
+			if (m_discardBestmoves > 0)
+			{
+				--m_discardBestmoves;
+				continue;
+			}
 			readBestmove(iss);
 			m_state = State::Ready;
 			m_eventInfo.type = UCIEventInfo::Type::BestMove;
@@ -170,9 +442,10 @@ void UCIEngine::sProcessInput(void)
 		}
 		else if (cmd == "info")
 		{
-			readInfo(iss);
-			getline(iss, m_eventInfo.errorText); // TEMPORARY
+			getline(iss, m_eventInfo.errorText); // Raw line is kept for logs
 			m_eventInfo.errorText = misc::trim(m_eventInfo.errorText);
+			std::istringstream infoStream(m_eventInfo.errorText);
+			readInfo(infoStream);
 			m_eventInfo.type = UCIEventInfo::Type::Info;
 			m_eventCallback(this, &m_eventInfo);
 		}
@@ -185,3 +458,14 @@ void UCIEngine::sProcessError(void)
 	m_eventInfo.errorText = m_process.readAllStandardError().toStdString();
 	m_eventCallback(this, &m_eventInfo);
 }
+
+void UCIEngine::sProcessFinished(void)
+{
+	if (m_state == State::NotSet)
+		return; // Closed by us
+	sProcessInput(); // Last lines before exit
+	m_state = State::NotSet;
+	m_eventInfo.type = UCIEventInfo::Type::Error;
+	m_eventInfo.errorText = "Engine process terminated unexpectedly";
+	m_eventCallback(this, &m_eventInfo);
+}
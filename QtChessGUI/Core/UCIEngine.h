@@ -1,15 +1,31 @@
 #pragma once
 #include <QtCore>
+#include <memory>
+#include "MockUCIEngine.h"
 #include "../Engine/ucioption.h"
 #include "../Engine/engine.h"
 
+// Parsed 'info' line. Values which engine didn't send are -1 (or empty)
 struct InfoDetails
 {
 	enum class ScoreType {
-		Cp, Mate, LowerBound, UpperBound
+		None, Cp, Mate
 	};
-	int depth;
-	int score;
+	enum class Bound {
+		Exact, Lower, Upper
+	};
+	int depth = -1;
+	int selDepth = -1;
+	int multiPV = -1;
+	ScoreType scoreType = ScoreType::None;
+	int score = 0; // Centipawns or moves to mate (negative if engine is mated), from engine's side
+	Bound bound = Bound::Exact;
+	long long nodes = -1;
+	long long nps = -1;
+	int time = -1; // ms
+	int hashFull = -1; // Permill
+	std::string pv; // Moves (UCI) separated by spaces
+	std::string text; // Value of 'string'
 };
 
 struct UCIEventInfo
@@ -24,14 +40,39 @@ struct UCIEventInfo
 	std::string errorText;
 };
 
+// Statistics of how often the engine predicted the opponent's reply
+struct PonderStats
+{
+	int hits = 0; // Opponent played the expected move, 'ponderhit' was sent
+	int misses = 0; // Opponent deviated, ponder search was stopped
+	inline int total(void) const noexcept
+	{
+		return hits + misses;
+	}
+	inline double hitRate(void) const noexcept
+	{
+		return total() == 0 ? 0.0 : double(hits) / total();
+	}
+};
+
+// Limits of a single search sent with 'go' (zero values are not sent)
+struct SearchLimits
+{
+	int depth = 0;
+	int movetime = 0; // ms
+	int wtime = 0, btime = 0; // Remaining clock times, ms
+	int winc = 0, binc = 0; // Increments, ms
+};
+
 class UCIEngine
 {
 public:
 	using Callback = std::function<void(UCIEngine*, const UCIEventInfo*)>;
 	using Options = std::unordered_map<std::string, UciOption>;
+	using OptionValues = std::vector<std::pair<std::string, std::string>>; // Names and values as strings
 	static inline Callback EmptyCallback = [](UCIEngine*, const UCIEventInfo*) {};
 	enum class State {
-		NotSet, WaitingUciOk, SettingOptions, WaitingReadyOk, Ready, Searching
+		NotSet, WaitingUciOk, SettingOptions, WaitingReadyOk, Ready, Searching, Pondering
 	};
 	UCIEngine(void);
 	UCIEngine(QString path, Callback eventCallback = EmptyCallback);
@@ -40,16 +81,47 @@ public:
 	inline std::string getName(void) const noexcept;
 	inline std::string getAuthor(void) const noexcept;
 	inline const Options& getOptions(void) const noexcept;
+	inline const PonderStats& getPonderStats(void) const noexcept;
+	inline QString getPath(void) const;
+	// Whether engine's 'Ponder' option is present and turned on
+	bool ponderEnabled(void) const;
+	// Whether engine already has given option values, so that setting them wouldn't change anything
+	bool hasOptionValues(const OptionValues& values) const;
+	// Whether process (or mock engine) is running
+	bool isRunning(void) const;
+	// Whether process is running and answered the last ping in time
+	bool isAlive(int timeout = 5000) const;
 	void close(void);
+	// Start engine at given path. Paths starting with "mock:" create in-process MockUCIEngine
 	void reset(QString path, Callback eventCallback = EmptyCallback);
+	// Prepare already initialized (Ready) engine for a new game without restarting the process.
+	// Behaves like reset in that callback is notified with UciOk, after which options may be set
+	void reuse(Callback eventCallback = EmptyCallback);
+	// Stop reporting events and abort search (if any), leaving process running
+	void detach(void);
 	void setOptionFromString(const std::string& name, const std::string& value);
 	void setOption(const std::string& name, const UciOption::ValueType& value);
 	void sendPosition(const std::string& positionFEN);
+	// Position given by FEN (or "startpos") and moves (in UCI format) made from it
+	void sendPosition(const std::string& positionFEN, const std::vector<std::string>& moves);
 	void sendNewGame(void);
 	void sendIsReady(void);
 	void sendGo(int depth = 10);
+	void sendGo(const SearchLimits& limits);
+	// Search on the position after expected opponent's move, limits apply after 'ponderhit'
+	void sendPonder(const SearchLimits& limits);
+	void sendPonderHit(void);
 	void sendStop(void);
+	// Health check of idle engine, answer is not reported to callback
+	void sendPing(void);
+	// Synchronize with idle engine: its 'readyok' is reported to callback as ReadyOk
+	void sendSync(void);
+	// Restrict engine process to CPUs given by bit mask. Returns false if it's not supported or failed
+	bool setAffinity(quint64 cpuMask);
 private:
+	void connectProcess(void);
+	// Write 'go' command (with 'ponder' if it's set) and given limits
+	void writeGo(const SearchLimits& limits, bool ponder);
 	// Reading various event info from stream
 	void readBestmove(std::istream& iss);
 	void readInfo(std::istream& iss);
@@ -60,14 +132,23 @@ private:
 	void sProcessInput(void);
 	// Called when process sends some info into 
 	void sProcessError(void);
+	// Called when process exits or mock engine closes its output
+	void sProcessFinished(void);
 	// Data
 	std::string m_name; // from UCI 'id' command
 	std::string m_author; // from UCI 'id' command
 	State m_state;
 	Options m_options;
+	PonderStats m_ponderStats;
+	int m_discardBestmoves; // Count of 'bestmove's from stopped ponder searches which should be ignored
+	int m_pendingPings; // Count of 'readyok's expected for health check pings
+	QElapsedTimer m_pingTimer; // Time since the oldest unanswered ping
+	QString m_path;
 	Callback m_eventCallback; // Callback to signalize initial option setting
 	UCIEventInfo m_eventInfo; // Pointer to this will be sent to callback after filling needed info in sProcessInput
 	QProcess m_process;
+	std::unique_ptr<MockUCIEngine> m_mock;
+	QIODevice* m_io; // Either m_process or m_mock
 };
 
 inline UCIEngine::State UCIEngine::getState(void) const noexcept
@@ -88,4 +169,14 @@ inline std::string UCIEngine::getAuthor(void) const noexcept
 inline const UCIEngine::Options& UCIEngine::getOptions(void) const noexcept
 {
 	return m_options;
+}
+
+inline const PonderStats& UCIEngine::getPonderStats(void) const noexcept
+{
+	return m_ponderStats;
+}
+
+inline QString UCIEngine::getPath(void) const
+{
+	return m_path;
 }
\ No newline at end of file
@@ -39,7 +39,7 @@ void Game::clear(void)
 	gameState = GameState::UNDEFINED;
 	// Game and position history
 	gameHistory.clear();
-	positionRepeats.clear();
+	snapshots.clear();
 }
 
 //============================================================
@@ -51,6 +51,7 @@ void Game::reset(void)
 		return;
 	clear();
 	pos.reset(); // Position::clear will also be called from here but it's not crucial
+	snapshots.assign(1, pos);
 	gameState = GameState::ACTIVE;
 }
 
@@ -78,10 +79,16 @@ bool Game::drawByMaterial(void) const
 //============================================================
 bool Game::threefoldRepetitionDraw(void) const
 {
-	std::stringstream positionFEN;
-	pos.writeFEN(positionFEN, true); // Positions are considered equal iff reduced FENs are
-	const auto iter = positionRepeats.find(positionFEN.str());
-	return iter != positionRepeats.end() && iter->second >= 3;
+	// Positions are considered equal iff Zobrist keys (including en passant square, like
+	// reduced FEN) are. Only positions with the same side to move since the last capture
+	// or pawn move may repeat the current one
+	const int firstPly = std::max(pos.gamePly - int(pos.info.rule50), 0);
+	int repeats = 1;
+	for (int ply = pos.gamePly - 2; ply >= firstPly; ply -= 2)
+		if (ply < int(gameHistory.size()) && gameHistory[ply].prevState.keyZobrist == pos.info.keyZobrist
+			&& ++repeats >= 3)
+			return true;
+	return false;
 }
 
 //============================================================
@@ -91,9 +98,10 @@ void Game::updateGameState(void)
 {
 	MoveList moveList;
 	pos.generateLegalMoves(moveList);
-	if (moveList.empty())
-		gameState = pos.isInCheck() ? (pos.turn == WHITE ?
-			GameState::BLACK_WIN : GameState::WHITE_WIN) : GameState::DRAW;
+	if (moveList.empty() && pos.isInCheck())
+		gameState = pos.turn == WHITE ? GameState::BLACK_WIN : GameState::WHITE_WIN;
+	else if (moveList.empty())
+		gameState = GameState::DRAW, drawCause = DrawCause::STALEMATE;
 	else if (pos.info.rule50 >= 100)
 		gameState = GameState::DRAW, drawCause = DrawCause::RULE_50;
 	else if (drawByMaterial())
@@ -128,9 +136,13 @@ bool Game::DoMove(Move move)
 	}
 	// If it's legal, update game info and state
 	if (pos.gamePly - 1 != gameHistory.size())
+	{
 		gameHistory.erase(gameHistory.begin() + pos.gamePly - 1, gameHistory.end());
-	++positionRepeats[getPositionFEN(true)];
+		snapshots.resize((pos.gamePly - 1) / SNAPSHOT_INTERVAL + 1);
+	}
 	gameHistory.push_back(GHRecord{ move, prevState, moveStr });
+	if (pos.gamePly % SNAPSHOT_INTERVAL == 0)
+		snapshots.push_back(pos);
 	updateGameState();
 	return true;
 }
@@ -172,8 +184,7 @@ bool Game::UndoMove(void)
 	GHRecord& prevRec = gameHistory[pos.gamePly - 1];
 	if (!pos.UndoMove(prevRec.move, prevRec.prevState))
 		return false;
-	// If succeded, update game info and state
-	--positionRepeats[getPositionFEN(true)];
+	// If succeded, update game state
 	updateGameState();
 	return true;
 }
@@ -191,12 +202,72 @@ bool Game::RedoMove(void)
 	// Try to redo (there should be no errors there, but it's good to check if possible)
 	if (!pos.DoMove(gameHistory[pos.gamePly].move))
 		return false;
-	// If succeded, update game info and state
-	++positionRepeats[getPositionFEN(true)];
+	// If succeded, update game state
+	updateGameState();
+	return true;
+}
+
+//============================================================
+// Go to position after given count of moves of game history,
+// replaying them from the nearest snapshot
+//============================================================
+bool Game::jumpToPly(int ply)
+{
+	if (ply < 0 || ply > int(gameHistory.size()))
+		return false;
+	if (ply == pos.gamePly)
+		return true;
+	// Current position is used instead of snapshot if it's between them
+	const int snapshot = ply / SNAPSHOT_INTERVAL;
+	if (pos.gamePly > ply || pos.gamePly < snapshot * SNAPSHOT_INTERVAL)
+		pos = snapshots[snapshot];
+	// Moves of history are legal, so they are replayed without checks
+	PositionInfo prevState;
+	while (pos.gamePly < ply)
+		pos.doMove(gameHistory[pos.gamePly].move, prevState);
 	updateGameState();
 	return true;
 }
 
+//============================================================
+// Get moves of game history in given format
+//============================================================
+std::vector<std::string> Game::getHistoryMoves(MoveFormat fmt) const
+{
+	fillMoveStrings();
+	std::vector<std::string> moves;
+	moves.reserve(gameHistory.size());
+	for (const GHRecord& record : gameHistory)
+		moves.push_back(record.moveStr[fmt]);
+	return moves;
+}
+
+//============================================================
+// Get Zobrist keys of all positions from the start up to current one
+//============================================================
+std::vector<Key> Game::getPositionKeys(void) const
+{
+	// Key of position before each move is saved in its history record
+	std::vector<Key> keys;
+	keys.reserve(pos.gamePly + 1);
+	for (int ply = 0; ply < pos.gamePly; ++ply)
+		keys.push_back(positionKey(gameHistory[ply].prevState));
+	keys.push_back(getPositionKey());
+	return keys;
+}
+
+//============================================================
+// Get moves made from the start up to current position
+//============================================================
+std::vector<Move> Game::getMoves(void) const
+{
+	std::vector<Move> moves;
+	moves.reserve(pos.gamePly);
+	for (int ply = 0; ply < pos.gamePly; ++ply)
+		moves.push_back(gameHistory[ply].move);
+	return moves;
+}
+
 //============================================================
 // Load game from the given stream assuming given move format
 //============================================================
@@ -226,7 +297,7 @@ void Game::loadGame(std::istream& istr, MoveFormat fmt)
 		// Read a move and perform it if legal
 		std::string moveSAN;
 		istr >> moveSAN;
-		if (istr.eof())
+		if (moveSAN.empty() && istr.eof()) // Last move may be right before end of stream
 			break;
 		if (!istr || !DoMove(moveSAN, fmt))
 			throw std::runtime_error((pos.turn == WHITE ? "White " : "Black ")
@@ -236,20 +307,88 @@ void Game::loadGame(std::istream& istr, MoveFormat fmt)
 	}
 }
 
+//============================================================
+// Load game as sequence of moves from given FEN position
+//============================================================
+void Game::loadMoves(const std::vector<Move>& moves, const std::string& startFEN)
+{
+	if (startFEN.empty())
+		reset();
+	else
+		loadFEN(startFEN, true); // Game history is indexed by ply counted from the given position
+	gameHistory.reserve(moves.size());
+	PositionInfo prevState;
+	for (Move move : moves)
+	{
+		// Legality is still checked since stored moves may be corrupted,
+		// but there's no move notation and game state is updated only once
+		if (!pos.DoMove(move, &prevState))
+			throw std::runtime_error((pos.turn == WHITE ? "White " : "Black ")
+				+ std::string("move at position ") + std::to_string(pos.gamePly / 2 + 1) + " is illegal");
+		gameHistory.push_back(GHRecord{ move, prevState, {} });
+		if (pos.gamePly % SNAPSHOT_INTERVAL == 0)
+			snapshots.push_back(pos);
+	}
+	updateGameState();
+}
+
+//============================================================
+// Get FEN of the position game started from
+//============================================================
+std::string Game::getStartFEN(void) const
+{
+	return startPosition().getFEN(true);
+}
+
+//============================================================
+// Position the game started from
+//============================================================
+Position Game::startPosition(void) const
+{
+	Position start = pos;
+	for (int ply = pos.gamePly - 1; ply >= 0; --ply)
+		start.undoMove(gameHistory[ply].move, gameHistory[ply].prevState);
+	return start;
+}
+
+//============================================================
+// Compute string representations of moves loaded by loadMoves
+//============================================================
+void Game::fillMoveStrings(void) const
+{
+	if (gameHistory.empty() || !gameHistory.front().moveStr[FMT_UCI].empty())
+		return;
+	// Replay the game from its start
+	Position replay = startPosition();
+	PositionInfo prevState;
+	for (const GHRecord& record : gameHistory)
+	{
+		if (!record.moveStr[FMT_UCI].empty())
+			break;
+		for (auto fmt : { FMT_AN, FMT_SAN, FMT_UCI })
+			record.moveStr[fmt] = replay.moveToStr(record.move, fmt);
+		replay.doMove(record.move, prevState);
+	}
+}
+
 //============================================================
 // Write game to the given stream in SAN notation
 //============================================================
 void Game::writeGame(std::ostream& ostr, MoveFormat fmt) const
 {
-	// Write saved SAN representations of moves along with move number indicators
+	fillMoveStrings();
+	// Write saved SAN representations of moves along with move number indicators.
+	// If game started with black's move (position set from FEN), numbering is shifted by one ply
+	const int shift = (pos.gamePly & 1) == (pos.turn == WHITE);
 	for (int ply = 0; ply < gameHistory.size(); ++ply)
 	{
-		if (ply == 0 && (pos.gamePly & 1) == (pos.turn == WHITE))
+		const int numberPly = ply + shift;
+		if (ply == 0 && shift)
 			ostr << "1...";
-		else if ((ply & 1) == 0)
-			ostr << ply / 2 + 1 << '.';
+		else if ((numberPly & 1) == 0)
+			ostr << numberPly / 2 + 1 << '.';
 		ostr << ' ' << gameHistory[ply].moveStr[fmt];
-		if (ply & 1)
+		if (numberPly & 1)
 			ostr << '\n';
 	}
 }
@@ -262,9 +401,8 @@ void Game::loadFEN(std::istream& istr, bool omitCounters)
 {
 	clear();
 	pos.loadFEN(istr, omitCounters);
-	std::stringstream positionFEN;
-	pos.writeFEN(positionFEN, true);
-	++positionRepeats[positionFEN.str()];
+	snapshots.assign(1, pos);
+	updateGameState();
 }
 
 //============================================================
@@ -275,9 +413,8 @@ void Game::loadFEN(const std::string& str, bool omitCounters)
 {
 	clear();
 	pos.loadFEN(str, omitCounters);
-	std::stringstream positionFEN;
-	pos.writeFEN(positionFEN, true);
-	++positionRepeats[positionFEN.str()];
+	snapshots.assign(1, pos);
+	updateGameState();
 }
 
 //============================================================
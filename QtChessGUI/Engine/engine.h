@@ -33,7 +33,8 @@ namespace BlendXChess
 	enum class DrawCause : int8_t {
 		RULE_50,
 		MATERIAL,
-		THREEFOLD_REPETITION
+		THREEFOLD_REPETITION,
+		STALEMATE
 	};
 
 	//============================================================
@@ -72,8 +73,20 @@ namespace BlendXChess
 		bool DoMove(const std::string&, MoveFormat);
 		bool UndoMove(void);
 		bool RedoMove(void);
+		// Go to position after given count of moves of game history (which is kept, like with
+		// undo/redo). Position is restored from the nearest snapshot, so at most SNAPSHOT_INTERVAL - 1
+		// moves are replayed and game state is updated only once. Returns false if there's no such ply
+		bool jumpToPly(int ply);
+		// Count of moves in game history, including undone ones
+		inline int getHistoryLength(void) const;
+		// Moves of game history (including undone ones) in given format
+		std::vector<std::string> getHistoryMoves(MoveFormat fmt = FMT_SAN) const;
 		// Load game from the given stream in SAN notation
 		void loadGame(std::istream&, MoveFormat fmt = FMT_SAN);
+		// Load game as sequence of moves from given position in FEN notation without counters (standard
+		// starting position if it's empty). Unlike loadGame, string representations of moves are not
+		// computed here but only once writeGame needs them. Throws std::runtime_error on illegal move
+		void loadMoves(const std::vector<Move>&, const std::string& startFEN = std::string());
 		// Write game to the given stream in SAN notation
 		void writeGame(std::ostream&, MoveFormat fmt = FMT_SAN) const;
 		// Load position from a given stream in FEN notation (bool parameter says whether to omit move counters)
@@ -86,6 +99,20 @@ namespace BlendXChess
 		inline std::string getPositionFEN(bool = false) const;
 		// Get game moves in SAN notation
 		inline std::string getGame(void) const;
+		// Get FEN (without counters) of the position game started from
+		std::string getStartFEN(void) const;
+		// Get legal moves in current position
+		inline void generateLegalMoves(MoveList&) const;
+		// Get Zobrist keys of all positions from the start up to current one (indexed by ply).
+		// En passant square is excluded from these keys, so that transposed positions match
+		std::vector<Key> getPositionKeys(void) const;
+		// Same key of current position
+		inline Key getPositionKey(void) const;
+		// Get moves made from the start up to current position
+		std::vector<Move> getMoves(void) const;
+		// Call visitor with every position from the start up to current one, in order of plies
+		template<typename Visitor>
+		inline void forEachPosition(Visitor visitor) const;
 		// Redirections to Position class
 		template<bool MG_LEGAL = false>
 		inline int perft(Depth);
@@ -98,16 +125,24 @@ namespace BlendXChess
 			// State info of position from which 'move' was made
 			PositionInfo prevState;
 			// Move in various string formats (we store it here because it
-			// is easier than retrieve it when needed in writeGame method)
-			std::array<std::string, MOVE_FORMAT_CNT> moveStr;
+			// is easier than retrieve it when needed in writeGame method).
+			// Empty for moves loaded by loadMoves until fillMoveStrings is called
+			mutable std::array<std::string, MOVE_FORMAT_CNT> moveStr;
 		};
 		// Convert string to number
 		template<typename T>
 		static inline T convertTo(const std::string&);
+		// Position key without en passant component
+		static inline Key positionKey(const PositionInfo&);
 		// Whether position is draw by insufficient material
 		bool drawByMaterial(void) const;
 		// Whether position is threefold repeated
 		bool threefoldRepetitionDraw(void) const;
+		// Position the game started from
+		Position startPosition(void) const;
+		// Compute missing string representations of moves in game history (those of moves
+		// loaded by loadMoves, which always form its beginning) by replaying the game
+		void fillMoveStrings(void) const;
 		// Whether engine core is initialized
 		inline static bool initialized = false;
 		// Current game position (!! not the one changed in-search !!)
@@ -121,8 +156,10 @@ namespace BlendXChess
 		// int gameHistoryIdx; // Deprecated due to use of pos.gamePly
 		// Game history, which consists of all moves made from the starting position, including last undone ones
 		std::vector<GHRecord> gameHistory;
-		// Position (stored in reduced FEN) repetition count, for handling threefold repetition draw rule
-		std::unordered_map<std::string, int> positionRepeats;
+		// Plies between stored snapshots of game history positions
+		static constexpr int SNAPSHOT_INTERVAL = 16;
+		// Positions at plies 0, SNAPSHOT_INTERVAL, 2 * SNAPSHOT_INTERVAL, ... of game history, for jumpToPly
+		std::vector<Position> snapshots;
 	};
 
 	//============================================================
@@ -166,6 +203,20 @@ namespace BlendXChess
 		return pos.moveToStr(move, fmt);
 	}
 
+	template<typename Visitor>
+	inline void Game::forEachPosition(Visitor visitor) const
+	{
+		Position replay = startPosition();
+		const Position& current = replay;
+		visitor(current);
+		PositionInfo prevState;
+		for (int ply = 0; ply < pos.gamePly; ++ply)
+		{
+			replay.doMove(gameHistory[ply].move, prevState);
+			visitor(current);
+		}
+	}
+
 	inline std::string Game::getPositionFEN(bool omitCounters) const
 	{
 		return pos.getFEN(omitCounters);
@@ -178,6 +229,26 @@ namespace BlendXChess
 		return ss.str();
 	}
 
+	inline void Game::generateLegalMoves(MoveList& moves) const
+	{
+		pos.generateLegalMoves(moves);
+	}
+
+	inline Key Game::getPositionKey(void) const
+	{
+		return positionKey(pos.info);
+	}
+
+	inline int Game::getHistoryLength(void) const
+	{
+		return int(gameHistory.size());
+	}
+
+	inline Key Game::positionKey(const PositionInfo& info)
+	{
+		return info.epSquare == Sq::NONE ? info.keyZobrist : info.keyZobrist ^ ZobristEP[info.epSquare.file()];
+	}
+
 	template<bool MG_LEGAL>
 	inline int Game::perft(Depth depth)
 	{
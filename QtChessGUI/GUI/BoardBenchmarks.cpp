@@ -0,0 +1,91 @@
+#include "BoardBenchmarks.h"
+#include "BoardWidget.h"
+#include "Core/Benchmarks.h"
+#include <iostream>
+#include <sstream>
+
+using namespace BlendXChess;
+
+int bench::runPaint(QApplication& app)
+{
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Board painting benchmark");
+	parser.addHelpOption();
+	parser.addOptions({
+		{ "bench-paint", "Run painting benchmark instead of GUI." },
+		{ "frames", "Count of painted frames per mode.", "n", "500" }
+		});
+	parser.process(app);
+	Game::initialize();
+	const int frames = std::max(parser.value("frames").toInt(), 1);
+
+	BoardWidget board(nullptr, nullptr);
+	Game game;
+	std::istringstream moves("1. e4 e5 2. Nf3 Nc6 3. Bb5 a6 4. Ba4 Nf6 5. O-O Be7 6. Re1 b5 7. Bb3 d6");
+	game.loadGame(moves);
+	board.loadGame(game);
+	// Painted into an image, so that neither window system nor screen refresh is measured
+	QImage frame(board.size(), QImage::Format_ARGB32_Premultiplied);
+	for (bool caching : { false, true })
+	{
+		board.pieceSprites().setCaching(caching);
+		board.pieceSprites().invalidate();
+		board.render(&frame); // First frame rasterizes sprites
+		std::vector<double> samples;
+		QElapsedTimer timer;
+		for (int i = 0; i < frames; ++i)
+		{
+			timer.start();
+			board.render(&frame);
+			samples.push_back(timer.nsecsElapsed() / 1000.0);
+		}
+		printLatency(caching ? "paint (cached sprites)" : "paint (svg)", samples);
+	}
+	return 0;
+}
+
+int bench::runClick(QApplication& app)
+{
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Board click latency benchmark");
+	parser.addHelpOption();
+	parser.addOptions({
+		{ "bench-click", "Run click latency benchmark instead of GUI." },
+		{ "clicks", "Count of clicks per kind.", "n", "500" }
+		});
+	parser.process(app);
+	Game::initialize();
+	const int clicks = std::max(parser.value("clicks").toInt(), 1);
+
+	BoardWidget board(nullptr, nullptr);
+	Game game;
+	std::istringstream moves("1. e4 e5 2. Nf3 Nc6 3. Bb5 a6 4. Ba4 Nf6 5. O-O Be7 6. Re1 b5 7. Bb3 d6");
+	game.loadGame(moves);
+	board.loadGame(game);
+	// Shown, so that frames are painted (only dirty squares) and flushed as on screen
+	board.show();
+	QApplication::processEvents();
+	const auto click = [&board](Square sq) {
+		const QPoint point = board.tileRectBySquare(sq).center();
+		QMouseEvent press(QEvent::MouseButtonPress, point, Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+		QMouseEvent release(QEvent::MouseButtonRelease, point, Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+		QApplication::sendEvent(&board, &press);
+		QApplication::sendEvent(&board, &release);
+		// Paint the frame now instead of on next event loop iteration
+		QApplication::sendPostedEvents(&board, QEvent::UpdateRequest);
+	};
+	std::vector<double> selectSamples, deselectSamples;
+	QElapsedTimer timer;
+	for (int i = 0; i < clicks; ++i)
+	{
+		timer.start();
+		click(Sq::F3); // Knight with four targets
+		selectSamples.push_back(timer.nsecsElapsed() / 1000.0);
+		timer.start();
+		click(Sq::H5); // Empty square the knight can't reach
+		deselectSamples.push_back(timer.nsecsElapsed() / 1000.0);
+	}
+	printLatency("click to selected frame", selectSamples);
+	printLatency("click to deselected frame", deselectSamples);
+	return 0;
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <QtWidgets>
+
+// Benchmark modes of GUI widgets started from command line. Each returns process exit code
+namespace bench
+{
+	// --bench-paint: time of painting the board in a middlegame position, with
+	// piece sprites cached and with SVG rendered on every paint
+	int runPaint(QApplication& app);
+	// --bench-click: latency from mouse press to flushed frame showing the result: selection of
+	// a piece with its legal targets highlighted, and deselection by click on illegal target
+	int runClick(QApplication& app);
+}
@@ -0,0 +1,225 @@
+#include "BoardRenderer.h"
+#include "PieceSprites.h"
+#include <QtSvg>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace BlendXChess;
+
+BoardRenderer::BoardRenderer(const QString& pieceTheme)
+	: m_theme(pieceTheme), m_whiteTileImage(WHITE_TILE_IMAGE), m_blackTileImage(BLACK_TILE_IMAGE)
+{
+	const QDir dir(pieceTheme);
+	for (int side = WHITE; side <= BLACK; ++side)
+		for (int type = PAWN; type <= KING; ++type)
+		{
+			const Piece piece = makePiece(Side(side), PieceType(type));
+			QFile file(dir.filePath(PieceSprites::spriteFile(piece)));
+			if (file.open(QIODevice::ReadOnly))
+				m_svgPieces[piece] = file.readAll();
+		}
+}
+
+QImage BoardRenderer::render(const Position& pos, const Options& options) const
+{
+	const Sprites cached = sprites(options.tileSize);
+	const int border = borderWidth(options);
+	QImage image(FILE_CNT * options.tileSize + 2 * border, RANK_CNT * options.tileSize + 2 * border,
+		QImage::Format_ARGB32_Premultiplied);
+	image.fill(Qt::white);
+	QPainter painter(&image);
+	drawBoard(painter, cached.whiteTile, cached.blackTile, options);
+	for (Square sq = Sq::A1; sq < SQUARE_CNT; ++sq)
+		if (pos[sq] != PIECE_NULL)
+			painter.drawImage(tileRect(sq, options), cached.atlas, PieceSprites::spriteRect(pos[sq], options.tileSize));
+	painter.end();
+	return image;
+}
+
+bool BoardRenderer::renderSVG(const Position& pos, QIODevice* device, const Options& options) const
+{
+	const int border = borderWidth(options);
+	const QSize size(FILE_CNT * options.tileSize + 2 * border, RANK_CNT * options.tileSize + 2 * border);
+	QSvgGenerator generator;
+	generator.setOutputDevice(device);
+	generator.setSize(size);
+	generator.setViewBox(QRect(QPoint(0, 0), size));
+	QPainter painter;
+	if (!painter.begin(&generator))
+		return false;
+	painter.fillRect(QRect(QPoint(0, 0), size), Qt::white);
+	drawBoard(painter, m_whiteTileImage, m_blackTileImage, options);
+	// Renderers can't be shared between threads, so each call parses the cached files
+	std::map<Piece, QSvgRenderer> renderers;
+	for (Square sq = Sq::A1; sq < SQUARE_CNT; ++sq)
+	{
+		const Piece piece = pos[sq];
+		const auto svg = m_svgPieces.find(piece);
+		if (piece == PIECE_NULL || svg == m_svgPieces.end())
+			continue;
+		QSvgRenderer& renderer = renderers[piece];
+		if (!renderer.isValid())
+			renderer.load(svg->second);
+		renderer.render(&painter, QRectF(tileRect(sq, options)));
+	}
+	return painter.end();
+}
+
+BoardRenderer::Sprites BoardRenderer::sprites(int size) const
+{
+	{
+		std::shared_lock<std::shared_mutex> lock(m_mutex);
+		if (const auto it = m_sprites.find(size); it != m_sprites.end())
+			return it->second;
+	}
+	// Rasterized without lock, so that threads needing other sizes don't wait. If several threads
+	// need the same new size at once, each one renders it and the first result is kept
+	Sprites rendered{ PieceSprites::renderAtlas(m_theme, size),
+		m_whiteTileImage.scaled(size, size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation),
+		m_blackTileImage.scaled(size, size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation) };
+	std::unique_lock<std::shared_mutex> lock(m_mutex);
+	return m_sprites.emplace(size, std::move(rendered)).first->second;
+}
+
+QRect BoardRenderer::drawBoard(QPainter& painter, const QImage& whiteTile, const QImage& blackTile,
+	const Options& options) const
+{
+	const int border = borderWidth(options), tileSize = options.tileSize;
+	const QRect board(border, border, FILE_CNT * tileSize, RANK_CNT * tileSize);
+	for (Square sq = Sq::A1; sq < SQUARE_CNT; ++sq)
+		painter.drawImage(tileRect(sq, options), sq.color() == WHITE ? whiteTile : blackTile);
+	if (!options.coordinates)
+		return board;
+	QFont font = painter.font();
+	font.setPixelSize(std::max(border * 3 / 5, 1));
+	painter.setFont(font);
+	painter.setPen(Qt::black);
+	for (int col = 0; col < FILE_CNT; ++col)
+	{
+		const QString file(fileToAN(options.whiteDown ? col : FILE_CNT - 1 - col));
+		painter.drawText(QRect(board.left() + col * tileSize, 0, tileSize, border), Qt::AlignCenter, file);
+		painter.drawText(QRect(board.left() + col * tileSize, board.bottom() + 1, tileSize, border),
+			Qt::AlignCenter, file);
+	}
+	for (int row = 0; row < RANK_CNT; ++row)
+	{
+		const QString rank(rankToAN(options.whiteDown ? RANK_CNT - 1 - row : row));
+		painter.drawText(QRect(0, board.top() + row * tileSize, border, tileSize), Qt::AlignCenter, rank);
+		painter.drawText(QRect(board.right() + 1, board.top() + row * tileSize, border, tileSize),
+			Qt::AlignCenter, rank);
+	}
+	return board;
+}
+
+QRect BoardRenderer::tileRect(Square sq, const Options& options) const
+{
+	const int
+		row = options.whiteDown ? RANK_CNT - 1 - sq.rank() : sq.rank(),
+		col = options.whiteDown ? sq.file() : FILE_CNT - 1 - sq.file(),
+		border = borderWidth(options);
+	return QRect(border + col * options.tileSize, border + row * options.tileSize, options.tileSize, options.tileSize);
+}
+
+int BoardRenderer::borderWidth(const Options& options)
+{
+	return options.coordinates ? std::max(options.tileSize / 2, 8) : 0;
+}
+
+int BoardRenderer::runFromCommandLine(QGuiApplication& app)
+{
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Render diagrams of positions");
+	parser.addHelpOption();
+	parser.addOptions({
+		{ "render-diagrams", "Render diagrams instead of GUI." },
+		{ "input", "File with one FEN per line.", "file" },
+		{ "output", "Directory for diagrams (1.png, 2.png, ... in order of FENs).", "dir", "." },
+		{ "format", "png (default) or svg.", "format", "png" },
+		{ "tile-size", "Size of square in pixels.", "px", "48" },
+		{ "black-down", "Show board from black's side." },
+		{ "no-coordinates", "Omit border with files and ranks." },
+		{ "threads", "Rendering threads (default: all cores).", "n", "0" }
+		});
+	parser.process(app);
+
+	std::ifstream input(parser.value("input").toStdString());
+	if (!input)
+	{
+		std::cerr << "Could not open input file " << parser.value("input").toStdString() << std::endl;
+		return 1;
+	}
+	std::vector<std::string> fens;
+	for (std::string line; std::getline(input, line);)
+		if (line.find_first_not_of(" \t\r") != std::string::npos)
+			fens.push_back(line);
+	const QDir outputDir(parser.value("output"));
+	if (!outputDir.mkpath("."))
+	{
+		std::cerr << "Could not create output directory " << parser.value("output").toStdString() << std::endl;
+		return 1;
+	}
+	const bool svg = parser.value("format") == "svg";
+	Options options;
+	options.tileSize = std::max(parser.value("tile-size").toInt(), 1);
+	options.whiteDown = !parser.isSet("black-down");
+	options.coordinates = !parser.isSet("no-coordinates");
+	int threadCount = parser.value("threads").toInt();
+	if (threadCount <= 0)
+		threadCount = std::max<int>(std::thread::hardware_concurrency(), 1);
+	threadCount = std::min<int>(threadCount, std::max<size_t>(fens.size(), 1));
+
+	Game::initialize();
+	const BoardRenderer renderer;
+	// Threads take FENs by index, so that slow ones don't hold others back
+	std::atomic<size_t> next(0);
+	std::atomic<int> failed(0);
+	std::mutex errorMutex;
+	QElapsedTimer timer;
+	timer.start();
+	std::vector<std::thread> threads;
+	for (int i = 0; i < threadCount; ++i)
+		threads.emplace_back([&](void) {
+			Position pos;
+			for (size_t index; (index = next.fetch_add(1, std::memory_order_relaxed)) < fens.size();)
+			{
+				const QString path = outputDir.filePath(QString("%1.%2").arg(index + 1).arg(svg ? "svg" : "png"));
+				bool written;
+				try
+				{
+					pos.loadFEN(fens[index]);
+					if (svg)
+					{
+						QFile file(path);
+						written = file.open(QIODevice::WriteOnly) && renderer.renderSVG(pos, &file, options);
+					}
+					else
+						written = renderer.render(pos, options).save(path, "PNG");
+				}
+				catch (const std::exception& err)
+				{
+					std::lock_guard<std::mutex> lock(errorMutex);
+					std::cerr << "Line " << index + 1 << ": " << err.what() << std::endl;
+					written = true; // Already reported
+					failed.fetch_add(1, std::memory_order_relaxed);
+				}
+				if (!written)
+				{
+					std::lock_guard<std::mutex> lock(errorMutex);
+					std::cerr << "Could not write " << path.toStdString() << std::endl;
+					failed.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+		});
+	for (std::thread& thread : threads)
+		thread.join();
+	const qint64 elapsed = timer.elapsed();
+	const int rendered = int(fens.size()) - failed.load();
+	std::cout << rendered << " diagrams rendered in " << elapsed << " ms ("
+		<< (elapsed > 0 ? rendered * 1000.0 / elapsed : 0.0) << " per second)" << std::endl;
+	return failed.load() == 0 ? 0 : 1;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <QtGui>
+#include <map>
+#include <shared_mutex>
+#include "Engine/engine.h"
+
+// Draws positions into images without any widget, with the tiles and pieces of board. Sprites
+// (see PieceSprites::renderAtlas) and scaled tiles are rasterized once per size and shared by all
+// threads, so one renderer may be used by a pool of threads exporting diagrams. All methods are thread-safe
+class BoardRenderer
+{
+public:
+	struct Options
+	{
+		int tileSize = 48; // Pixels
+		bool whiteDown = true;
+		bool coordinates = true; // Border with files and ranks
+	};
+
+	// Images of tiles shared with BoardWidget
+	static constexpr const char* WHITE_TILE_IMAGE = ":/QtChessGUI/Images/Board/DefaultTileWhite.png";
+	static constexpr const char* BLACK_TILE_IMAGE = ":/QtChessGUI/Images/Board/DefaultTileBlack.png";
+
+	BoardRenderer(const QString& pieceTheme = ":/QtChessGUI/Images/Pieces/Cburnett");
+	QImage render(const BlendXChess::Position& pos, const Options& options = Options()) const;
+	// Same as vector image, with pieces drawn from SVG. Returns false if it couldn't be written
+	bool renderSVG(const BlendXChess::Position& pos, QIODevice* device, const Options& options = Options()) const;
+	// Parse command line options of --render-diagrams mode and render FENs from file, returning exit code
+	static int runFromCommandLine(QGuiApplication& app);
+private:
+	struct Sprites
+	{
+		QImage atlas;
+		QImage whiteTile, blackTile;
+	};
+	// Sprites and tiles of given size, rasterized by the first thread which needs them
+	Sprites sprites(int size) const;
+	// Draw everything except pieces, returning rectangle of the board
+	QRect drawBoard(QPainter& painter, const QImage& whiteTile, const QImage& blackTile,
+		const Options& options) const;
+	QRect tileRect(BlendXChess::Square sq, const Options& options) const;
+	static int borderWidth(const Options& options);
+
+	const QString m_theme;
+	QImage m_whiteTileImage, m_blackTileImage; // Original size
+	std::map<BlendXChess::Piece, QByteArray> m_svgPieces; // Contents of SVG files
+	mutable std::shared_mutex m_mutex;
+	mutable std::map<int, Sprites> m_sprites; // By size
+};
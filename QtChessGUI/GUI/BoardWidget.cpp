@@ -1,45 +1,54 @@
 #include "BoardWidget.h"
 #include "EngineInfoWidget.h"
+#include "BoardRenderer.h"
 #include "Dialogs/EngineParamsDialog.h"
+#include <algorithm>
+#include <cstdlib>
 
 using namespace BlendXChess;
 
+namespace
+{
+	constexpr int DEFAULT_TILE_SIZE = 64, MIN_TILE_SIZE = 16;
+	constexpr int DEFAULT_BORDER_WIDTH = 30, MIN_BORDER_WIDTH = 16;
+	constexpr int ANIMATION_DURATION = 150; // ms
+	constexpr int ANIMATION_FRAME = 16; // ms, about refresh period of usual displays
+	constexpr int MAX_SLIDING_PIECES = 4; // Enough for a couple of coalesced moves
+}
+
 BoardWidget::BoardWidget(QWidget* parent, EngineInfoWidget* eIW)
-	: QWidget(parent), m_tileSize(64), m_whiteDown(true), m_selSq(Sq::NONE),
-	m_borderWidth(30), m_userSide(NULL_COLOR), m_gameType(GameType::None),
-	m_engineInfoWidget(eIW)
+	: QWidget(parent), m_tileSize(DEFAULT_TILE_SIZE), m_whiteDown(true), m_selSq(Sq::NONE),
+	m_borderWidth(DEFAULT_BORDER_WIDTH), m_userSide(NULL_COLOR), m_gameType(GameType::None),
+	m_engineInfoWidget(eIW), m_engineProc{ nullptr, nullptr },
+	m_sprites(":/QtChessGUI/Images/Pieces/Cburnett"), m_shownTurn(NULL_COLOR), m_borderCacheWhiteDown(true),
+	m_tilePixelSize(0), m_pendingPixelSize(0), m_dragging(false), m_animationProgress(0.0),
+	m_animated(true), m_skipAnimation(false)
 {
-	m_boardLUCorner = QPoint(m_borderWidth, m_borderWidth);
-	m_tileQSize = QSizeF(m_tileSize, m_tileSize);
-	m_boardSize = QSize(FILE_CNT * m_tileSize, RANK_CNT * m_tileSize);
-	setFixedSize(
-		m_boardSize.width() + 2 * m_borderWidth,
-		m_boardSize.height() + 2 * m_borderWidth);
-	m_borderLength = m_boardSize.width();
+	m_searchLimits.depth = 10;
+	std::fill(std::begin(m_shownPieces), std::end(m_shownPieces), PIECE_NULL);
+	std::fill(std::begin(m_legalTargets), std::end(m_legalTargets), Bitboard(0));
+	setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+	resize(sizeHint());
+	layoutBoard();
 
-	m_whiteTileImage.load("Images/Board/DefaultTileWhite.png");
-	m_blackTileImage.load("Images/Board/DefaultTileBlack.png");
-	m_whiteTileImage = m_whiteTileImage.scaled(m_tileQSize.toSize());
-	m_blackTileImage = m_blackTileImage.scaled(m_tileQSize.toSize());
-
-	m_svgPieces[W_PAWN].load(QString("Images/Pieces/Cburnett/whitePawn.svg"));
-	m_svgPieces[W_KNIGHT].load(QString("Images/Pieces/Cburnett/whiteKnight.svg"));
-	m_svgPieces[W_BISHOP].load(QString("Images/Pieces/Cburnett/whiteBishop.svg"));
-	m_svgPieces[W_ROOK].load(QString("Images/Pieces/Cburnett/whiteRook.svg"));
-	m_svgPieces[W_QUEEN].load(QString("Images/Pieces/Cburnett/whiteQueen.svg"));
-	m_svgPieces[W_KING].load(QString("Images/Pieces/Cburnett/whiteKing.svg"));
-	m_svgPieces[B_PAWN].load(QString("Images/Pieces/Cburnett/blackPawn.svg"));
-	m_svgPieces[B_KNIGHT].load(QString("Images/Pieces/Cburnett/blackKnight.svg"));
-	m_svgPieces[B_BISHOP].load(QString("Images/Pieces/Cburnett/blackBishop.svg"));
-	m_svgPieces[B_ROOK].load(QString("Images/Pieces/Cburnett/blackRook.svg"));
-	m_svgPieces[B_QUEEN].load(QString("Images/Pieces/Cburnett/blackQueen.svg"));
-	m_svgPieces[B_KING].load(QString("Images/Pieces/Cburnett/blackKing.svg"));
+	m_whiteTileImage.load(BoardRenderer::WHITE_TILE_IMAGE);
+	m_blackTileImage.load(BoardRenderer::BLACK_TILE_IMAGE);
 
+	m_animationTimer.setTimerType(Qt::PreciseTimer);
+	m_animationTimer.setInterval(ANIMATION_FRAME);
+	connect(&m_animationTimer, &QTimer::timeout, this, &BoardWidget::animationStep);
+	// Every change of position repaints only affected squares
+	connect(this, &BoardWidget::positionChanged, this, &BoardWidget::updateChangedSquares);
+	connect(this, &BoardWidget::positionChanged, this, &BoardWidget::updateLegalMoves);
 	startPVP();
 }
 
 BoardWidget::~BoardWidget(void)
-{}
+{
+	// Its result is posted to this object, so it shouldn't outlive it
+	if (m_cacheThread.joinable())
+		m_cacheThread.join();
+}
 
 const BlendXChess::Game& BoardWidget::game(void) const
 {
@@ -49,19 +58,23 @@ const BlendXChess::Game& BoardWidget::game(void) const
 void BoardWidget::closeGame(void)
 {
 	m_game.clear();
-	if (m_gameType == GameType::PlayerVsEngine)
-		m_engineProc[opposite(m_userSide)].close();
-	else if (m_gameType == GameType::EngineVsEngine)
-		for (auto& engine : m_engineProc)
-			engine.close();
+	clearMoveStats();
+	// Engines are kept running in the pool, so that next game starts quickly
+	for (auto& engine : m_engineProc)
+		if (engine)
+		{
+			m_enginePool.release(engine);
+			engine = nullptr;
+		}
 	m_gameType = GameType::None;
+	emit positionChanged();
 }
 
 void BoardWidget::startPVP(void)
 {
 	closeGame();
 	m_gameType = GameType::PlayerVsPlayer;
-	m_whiteDown = true;
+	setWhiteDown(true);
 	startGame();
 }
 
@@ -72,7 +85,7 @@ void BoardWidget::startWithEngine(BlendXChess::Side userSide, QString enginePath
 		userSide = Side(QDateTime::currentDateTime().time().msec() & 1); // random
 	m_gameType = GameType::PlayerVsEngine;
 	m_userSide = userSide;
-	m_whiteDown = (userSide == WHITE);
+	setWhiteDown(userSide == WHITE);
 	launchEngine(opposite(userSide), enginePath);
 }
 
@@ -81,27 +94,47 @@ void BoardWidget::startEngineVsEngine(QString whiteEnginePath, QString blackEngi
 	closeGame();
 	m_gameType = GameType::EngineVsEngine;
 	m_userSide = NULL_COLOR;
-	m_whiteDown = true;
+	setWhiteDown(true);
 	launchEngine(WHITE, whiteEnginePath);
 	launchEngine(BLACK, blackEnginePath);
 }
 
 void BoardWidget::undo(void)
 {
+	if (userMoves())
+		stopPondering(); // Engine could ponder on the position we are leaving
 	if (!userMoves() || !m_game.UndoMove())
 		return;
 	if (!userMoves())
 		m_game.UndoMove();
-	update();
+	emit positionChanged();
 }
 
 void BoardWidget::redo(void)
 {
+	if (userMoves())
+		stopPondering();
 	if (!userMoves() || !m_game.RedoMove())
 		return;
 	if (!userMoves())
 		m_game.RedoMove();
-	update();
+	emit positionChanged();
+}
+
+bool BoardWidget::jumpToPly(int ply)
+{
+	for (Side side : {WHITE, BLACK})
+		if (engineSide(side) && m_engineProc[side]->getState() == UCIEngine::State::Searching)
+			return false;
+	const Position& pos = m_game.getPosition();
+	const Side turn = (pos.getGamePly() - ply) % 2 == 0 ? pos.getTurn() : opposite(pos.getTurn());
+	if (m_gameType == GameType::PlayerVsEngine && turn != m_userSide)
+		return false;
+	stopPondering();
+	if (!m_game.jumpToPly(ply))
+		return false;
+	emit positionChanged();
+	return true;
 }
 
 void BoardWidget::goEngine(BlendXChess::Side side)
@@ -109,32 +142,88 @@ void BoardWidget::goEngine(BlendXChess::Side side)
 	if (side == NULL_COLOR)
 		return;
 	m_engineInfoWidget->clear();
-	UCIEngine& engine = m_engineProc[side];
-	engine.sendPosition(m_game.getPositionFEN());
-	engine.sendGo();
+	UCIEngine& engine = *m_engineProc[side];
+	sendGame(engine);
+	engine.sendGo(m_searchLimits);
+	beginSearch(side);
 }
 
-bool BoardWidget::doMove(const std::string& move)
+void BoardWidget::startPonder(BlendXChess::Side side, const std::string& ponderMove)
 {
-	if (!m_game.DoMove(move, FMT_UCI))
+	UCIEngine& engine = *m_engineProc[side];
+	if (!engine.ponderEnabled() || ponderMove.empty())
+		return;
+	Position expected = m_game.getPosition();
+	try
+	{
+		if (!expected.DoMove(ponderMove, FMT_UCI))
+			return; // Engine suggested something illegal, don't bother
+	}
+	catch (const std::runtime_error&)
+	{
+		return;
+	}
+	m_ponderMove[side] = ponderMove;
+	sendGame(engine, ponderMove);
+	engine.sendPonder(m_searchLimits);
+}
+
+void BoardWidget::stopPondering(void)
+{
+	for (Side side : {WHITE, BLACK})
+		if (engineSide(side) && m_engineProc[side]->getState() == UCIEngine::State::Pondering)
+			m_engineProc[side]->sendStop();
+}
+
+bool BoardWidget::doMove(const std::string& move, const MoveStats& stats)
+{
+	Move parsed;
+	try
+	{
+		parsed = m_game.moveFromStr(move, FMT_UCI);
+	}
+	catch (const std::runtime_error&)
+	{
 		return false;
+	}
+	return doMove(parsed, stats);
+}
+
+bool BoardWidget::doMove(BlendXChess::Move move, const MoveStats& stats)
+{
+	if (!m_game.DoMove(move))
+		return false;
+	// Statistics of undone moves are dropped along with them
+	const int ply = m_game.getPosition().getGamePly() - 1;
+	m_moveStats.resize(ply);
+	m_moveStats.push_back(stats);
+	emit moveStatsAdded(ply);
+	emit positionChanged();
 	if (auto gs = m_game.getGameState(); gs != GameState::ACTIVE)
 	{
-		QMessageBox::information(this, "Game result",
+		stopPondering();
+		QString result =
 			gs == GameState::WHITE_WIN ? "White won" :
 			gs == GameState::BLACK_WIN ? "Black won" :
-			gs == GameState::DRAW ? "Draw" : "Undefined");
+			gs == GameState::DRAW ? "Draw" : "Undefined";
+		QMessageBox::information(this, "Game result", result + ponderStatsText());
 		return false;
 	}
 	const Side currentTurn = m_game.getPosition().getTurn();
-	if (m_gameType == GameType::PlayerVsEngine)
+	if (!engineSide(currentTurn))
+		return true;
+	UCIEngine& engine = *m_engineProc[currentTurn];
+	if (engine.getState() == UCIEngine::State::Pondering)
 	{
-		const Side engineSide = opposite(m_userSide);
-		if (engineSide == currentTurn)
-			goEngine(currentTurn);
+		if (move.toUCI() == m_ponderMove[currentTurn])
+		{ // Engine is already searching the right position
+			engine.sendPonderHit();
+			beginSearch(currentTurn);
+			return true;
+		}
+		engine.sendStop();
 	}
-	else if (m_gameType == GameType::EngineVsEngine)
-		goEngine(currentTurn);
+	goEngine(currentTurn);
 	return true;
 }
 
@@ -143,6 +232,8 @@ bool BoardWidget::loadPGN(std::istream& inGame)
 	try
 	{
 		m_game.loadGame(inGame);
+		clearMoveStats();
+		emit positionChanged();
 		return true;
 	}
 	catch (const std::exception & exc)
@@ -152,29 +243,251 @@ bool BoardWidget::loadPGN(std::istream& inGame)
 	}
 }
 
+void BoardWidget::loadGame(const BlendXChess::Game& game, GameStats stats)
+{
+	m_game = game;
+	m_moveStats = std::move(stats);
+	emit moveStatsReset();
+	emit positionChanged();
+}
+
 bool BoardWidget::userMoves(void) const noexcept
 {
 	return m_gameType == GameType::PlayerVsPlayer
 		|| m_game.getPosition().getTurn() == m_userSide;
 }
 
-void BoardWidget::paintEvent(QPaintEvent* eventInfo)
+void BoardWidget::setPieceTheme(const QString& themeDir)
+{
+	m_sprites.setTheme(themeDir);
+	m_tilePixelSize = 0; // Nothing to stretch, sprites of new theme are rasterized on next paint
+	update();
+}
+
+QSize BoardWidget::sizeHint(void) const
+{
+	return QSize(FILE_CNT * DEFAULT_TILE_SIZE + 2 * DEFAULT_BORDER_WIDTH,
+		RANK_CNT * DEFAULT_TILE_SIZE + 2 * DEFAULT_BORDER_WIDTH);
+}
+
+QSize BoardWidget::minimumSizeHint(void) const
 {
+	return QSize(FILE_CNT * MIN_TILE_SIZE + 2 * MIN_BORDER_WIDTH,
+		RANK_CNT * MIN_TILE_SIZE + 2 * MIN_BORDER_WIDTH);
+}
+
+bool BoardWidget::engineSide(BlendXChess::Side side) const noexcept
+{
+	return m_engineProc[side] && (m_gameType == GameType::EngineVsEngine
+		|| m_gameType == GameType::PlayerVsEngine && side == opposite(m_userSide));
+}
+
+QString BoardWidget::ponderStatsText(void) const
+{
+	QString text;
+	for (Side side : {WHITE, BLACK})
+	{
+		if (!engineSide(side))
+			continue;
+		const PonderStats& stats = m_engineProc[side]->getPonderStats();
+		if (stats.total() == 0)
+			continue;
+		text += QString("\n%1 engine ponder hit rate: %2% (%3 of %4)")
+			.arg(side == WHITE ? "White" : "Black")
+			.arg(100.0 * stats.hitRate(), 0, 'f', 1)
+			.arg(stats.hits).arg(stats.total());
+	}
+	return text;
+}
+
+void BoardWidget::updateChangedSquares(void)
+{
+	// Animation of previous change is cut short, pieces slide from where they are shown
+	finishAnimation();
+	const Position& board = m_game.getPosition();
+	std::vector<Square> left, arrived;
+	for (int i = 0; i < SQUARE_CNT; ++i)
+	{
+		const Square sq = SquareRaw(i);
+		// Covers castling rook and captured en passant pawn as well as undo and loaded games
+		if (board[sq] == m_shownPieces[i])
+			continue;
+		if (m_shownPieces[i] != PIECE_NULL)
+			left.push_back(sq);
+		if (board[sq] != PIECE_NULL)
+			arrived.push_back(sq);
+	}
+	// Each arrived piece slides from the nearest square which the same piece left
+	if (m_animated && !m_skipAnimation && arrived.size() <= MAX_SLIDING_PIECES)
+		for (Square to : arrived)
+		{
+			auto from = left.end();
+			int fromDistance = RANK_CNT;
+			for (auto it = left.begin(); it != left.end(); ++it)
+				if (const int distance = std::max(std::abs(it->rank() - to.rank()), std::abs(it->file() - to.file()));
+					m_shownPieces[*it] == board[to] && distance < fromDistance)
+				{
+					from = it;
+					fromDistance = distance;
+				}
+			if (from != left.end())
+			{
+				m_sliding.push_back({ board[to], *from, to });
+				left.erase(from);
+			}
+		}
+	for (int i = 0; i < SQUARE_CNT; ++i)
+	{
+		const Square sq = SquareRaw(i);
+		if (board[sq] != m_shownPieces[i])
+		{
+			m_shownPieces[i] = board[sq];
+			update(tileRectBySquare(sq));
+		}
+	}
+	if (!m_sliding.empty())
+	{
+		for (const SlidingPiece& sliding : m_sliding)
+			m_shownPieces[sliding.to] = PIECE_NULL;
+		m_animationProgress = 0.0;
+		m_animationClock.start();
+		m_animationTimer.start();
+	}
+	if (board.getTurn() != m_shownTurn)
+	{
+		m_shownTurn = board.getTurn();
+		update(turnIndicatorRect());
+	}
+}
+
+void BoardWidget::animationStep(void)
+{
+	for (const SlidingPiece& sliding : m_sliding)
+		update(slideRect(sliding));
+	m_animationProgress = std::min(1.0, double(m_animationClock.elapsed()) / ANIMATION_DURATION);
+	if (m_animationProgress >= 1.0)
+	{
+		finishAnimation();
+		return;
+	}
+	for (const SlidingPiece& sliding : m_sliding)
+		update(slideRect(sliding));
+}
+
+void BoardWidget::finishAnimation(void)
+{
+	m_animationTimer.stop();
+	for (const SlidingPiece& sliding : m_sliding)
+	{
+		update(slideRect(sliding));
+		m_shownPieces[sliding.to] = sliding.piece;
+		update(tileRectBySquare(sliding.to));
+	}
+	m_sliding.clear();
+}
+
+QRect BoardWidget::slideRect(const SlidingPiece& sliding) const
+{
+	// Eased out, so that piece slows down as it lands
+	const double t = 1.0 - (1.0 - m_animationProgress) * (1.0 - m_animationProgress);
+	const QPointF from = tilePointBySquare(sliding.from), to = tilePointBySquare(sliding.to);
+	return QRect((from + (to - from) * t).toPoint(), m_tileQSize.toSize());
+}
+
+void BoardWidget::setSelectedSquare(BlendXChess::Square sq)
+{
+	if (sq == m_selSq)
+		return;
+	if (m_selSq != Sq::NONE)
+	{
+		update(tileRectBySquare(m_selSq));
+		updateTargets(m_selSq);
+	}
+	m_selSq = sq;
+	if (m_selSq != Sq::NONE)
+	{
+		update(tileRectBySquare(m_selSq));
+		updateTargets(m_selSq);
+	}
+}
+
+void BoardWidget::updateLegalMoves(void)
+{
+	// Targets of selected piece change with position
+	updateTargets(m_selSq);
+	std::fill(std::begin(m_legalTargets), std::end(m_legalTargets), Bitboard(0));
+	m_legalMoves.clear();
+	if (m_game.getGameState() == GameState::ACTIVE)
+	{
+		MoveList moveList;
+		m_game.generateLegalMoves(moveList);
+		for (Move move : moveList)
+		{
+			m_legalMoves.push_back(move);
+			m_legalTargets[move.from()] |= bbSquare[move.to()];
+		}
+	}
+	updateTargets(m_selSq);
+}
+
+void BoardWidget::updateTargets(BlendXChess::Square sq)
+{
+	if (sq == Sq::NONE)
+		return;
+	for (Bitboard targets = m_legalTargets[sq]; targets;)
+		update(tileRectBySquare(popLSB(targets)));
+}
+
+Move BoardWidget::userMove(BlendXChess::Square from, BlendXChess::Square to) const
+{
+	if (!userMoves() || !(m_legalTargets[from] & bbSquare[to]))
+		return Move(MOVE_NONE);
+	for (Move move : m_legalMoves)
+		if (move.from() == from && move.to() == to && (move.type() != MT_PROMOTION || move.promotion() == QUEEN))
+			return move;
+	return Move(MOVE_NONE);
+}
+
+QRect BoardWidget::dragRect(void) const
+{
+	const QSize size = m_tileQSize.toSize();
+	return QRect(m_dragPoint - QPoint(size.width() / 2, size.height() / 2), size);
+}
+
+void BoardWidget::setWhiteDown(bool whiteDown)
+{
+	if (whiteDown == m_whiteDown)
+		return;
+	m_whiteDown = whiteDown;
+	update();
+}
+
+const QPixmap& BoardWidget::borderLayer(void)
+{
+	const qreal pixelRatio = devicePixelRatioF();
+	if (!m_borderCache.isNull() && m_borderCacheWhiteDown == m_whiteDown
+		&& m_borderCache.devicePixelRatioF() == pixelRatio)
+		return m_borderCache;
+	m_borderCache = QPixmap(size() * pixelRatio);
+	m_borderCache.setDevicePixelRatio(pixelRatio);
+	m_borderCache.fill(Qt::transparent);
+	m_borderCacheWhiteDown = m_whiteDown;
 	QStyleOption opt;
 	opt.init(this);
 	QPainter painter;
-	painter.begin(this);
-	painter.setRenderHint(QPainter::HighQualityAntialiasing);
+	painter.begin(&m_borderCache);
+	painter.setFont(font());
+	painter.setPen(palette().color(QPalette::WindowText));
 	style()->drawPrimitive(QStyle::PE_Widget, &opt, &painter, this);
-	// Draw the border
 	for (int col = 0; col < 8; ++col)
 	{
 		painter.drawText(QRect(
-			m_borderWidth + col * m_tileSize, 0, m_tileSize, m_borderWidth),
+			m_boardLUCorner.x() + col * m_tileSize, m_boardLUCorner.y() - m_borderWidth,
+			m_tileSize, m_borderWidth),
 			QString(fileToAN(fileFromCol(col))), QTextOption(Qt::AlignCenter)
 		);
 		painter.drawText(QRect(
-			m_borderWidth + col * m_tileSize, m_boardLUCorner.y() + m_boardSize.height(),
+			m_boardLUCorner.x() + col * m_tileSize, m_boardLUCorner.y() + m_boardSize.height(),
 			m_tileSize, m_borderWidth),
 			QString(fileToAN(fileFromCol(col))), QTextOption(Qt::AlignCenter)
 		);
@@ -182,92 +495,242 @@ void BoardWidget::paintEvent(QPaintEvent* eventInfo)
 	for (int row = 0; row < 8; ++row)
 	{
 		painter.drawText(QRect(
-			0, m_borderWidth + row * m_tileSize, m_borderWidth, m_tileSize),
+			m_boardLUCorner.x() - m_borderWidth, m_boardLUCorner.y() + row * m_tileSize,
+			m_borderWidth, m_tileSize),
 			QString(rankToAN(rankFromRow(row))), QTextOption(Qt::AlignCenter)
 		);
 		painter.drawText(QRect(
-			m_boardLUCorner.x() + m_boardSize.width(), m_borderWidth + row * m_tileSize,
+			m_boardLUCorner.x() + m_boardSize.width(), m_boardLUCorner.y() + row * m_tileSize,
 			m_borderWidth, m_tileSize),
 			QString(rankToAN(rankFromRow(row))), QTextOption(Qt::AlignCenter)
 		);
 	}
-	// Draw turn indicator
-	m_svgPieces[makePiece(m_game.getPosition().getTurn(), KING)].render(
-		&painter, QRect(0, 0, m_borderWidth, m_borderWidth));
-	// Draw the board
+	painter.end();
+	return m_borderCache;
+}
+
+void BoardWidget::layoutBoard(void)
+{
+	const int side = std::min(width(), height());
+	m_borderWidth = std::clamp(side / 18, MIN_BORDER_WIDTH, DEFAULT_BORDER_WIDTH);
+	m_tileSize = std::max((side - 2 * m_borderWidth) / FILE_CNT, 1);
+	m_tileQSize = QSizeF(m_tileSize, m_tileSize);
+	m_boardSize = QSize(FILE_CNT * m_tileSize, RANK_CNT * m_tileSize);
+	m_borderLength = m_boardSize.width();
+	// Board with borders is centered in the widget
+	m_boardLUCorner = QPoint(
+		(width() - m_boardSize.width()) / 2,
+		(height() - m_boardSize.height()) / 2);
+}
+
+void BoardWidget::requestCaches(void)
+{
+	const int pixelSize = qRound(m_tileSize * devicePixelRatioF());
+	if (m_tilePixelSize == 0)
+	{ // Nothing to stretch yet
+		cachesReady(pixelSize, m_sprites.theme(),
+			m_whiteTileImage.scaled(pixelSize, pixelSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation),
+			m_blackTileImage.scaled(pixelSize, pixelSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation),
+			PieceSprites::renderAtlas(m_sprites.theme(), pixelSize));
+		return;
+	}
+	// Size which changed while caches are prepared is requested again when they are ready
+	if (pixelSize == m_tilePixelSize || m_pendingPixelSize != 0)
+		return;
+	if (m_cacheThread.joinable())
+		m_cacheThread.join(); // It has already finished
+	m_pendingPixelSize = pixelSize;
+	// Images are implicitly shared, so they are copied cheaply and safely between threads
+	m_cacheThread = std::thread([this, pixelSize, theme = m_sprites.theme(),
+		whiteImage = m_whiteTileImage, blackImage = m_blackTileImage](void) {
+		QImage whiteTile = whiteImage.scaled(pixelSize, pixelSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+		QImage blackTile = blackImage.scaled(pixelSize, pixelSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+		QImage atlas = PieceSprites::renderAtlas(theme, pixelSize);
+		QMetaObject::invokeMethod(this, [this, pixelSize, theme, whiteTile, blackTile, atlas](void) {
+			m_pendingPixelSize = 0;
+			cachesReady(pixelSize, theme, whiteTile, blackTile, atlas);
+		}, Qt::QueuedConnection);
+	});
+}
+
+void BoardWidget::cachesReady(int pixelSize, const QString& theme, QImage whiteTile, QImage blackTile, QImage atlas)
+{
+	m_whiteTile = QPixmap::fromImage(std::move(whiteTile));
+	m_blackTile = QPixmap::fromImage(std::move(blackTile));
+	// Theme could change meanwhile, then sprites of the new one are rasterized here
+	if (theme == m_sprites.theme())
+		m_sprites.setAtlas(pixelSize, QPixmap::fromImage(std::move(atlas)), this);
+	else
+		m_sprites.prepare(pixelSize, this);
+	m_tilePixelSize = pixelSize;
+	update();
+	requestCaches();
+}
+
+void BoardWidget::paintEvent(QPaintEvent* eventInfo)
+{
+	requestCaches();
+	// Only dirty region is painted: usually a few squares changed by a move
+	const QRegion& dirty = eventInfo->region();
+	QPainter painter;
+	painter.begin(this);
+	// Draw the border
+	painter.drawPixmap(eventInfo->rect(), borderLayer(), QRectF(eventInfo->rect().topLeft() * devicePixelRatioF(),
+		eventInfo->rect().size() * devicePixelRatioF()));
+	// Draw the board. Tiles and pieces may be of old size until new ones are prepared, then they are stretched
 	const Position& board = m_game.getPosition();
 	for (int row = 0; row < 8; ++row) // NOT rank
 		for (int col = 0; col < 8; ++col) // NOT file
 		{
 			const Square sq = squareByTileCoord(row, col);
+			const QRect tileRect = tileRectBySquare(sq);
+			if (!dirty.intersects(tileRect))
+				continue;
 			// Draw a tile
-			QPoint tilePos(col * m_tileSize, row * m_tileSize);
-			tilePos += m_boardLUCorner;
-			painter.drawImage(tilePos, sq.color() == WHITE ? m_whiteTileImage : m_blackTileImage);
-			// Draw a piece
-			const Piece p = board[sq];
-			if (p != PIECE_NULL)
-				m_svgPieces[p].render(&painter, QRectF(tilePos, m_tileQSize));
+			painter.drawPixmap(tileRect, sq.color() == WHITE ? m_whiteTile : m_blackTile);
+			// Draw a piece (unless it's dragged or sliding)
+			const Piece p = m_shownPieces[sq];
+			if (p != PIECE_NULL && !(m_dragging && sq == m_selSq))
+				m_sprites.draw(painter, p, tileRect);
 		}
+	// Draw turn indicator (with the sprite of tile size scaled down)
+	if (dirty.intersects(turnIndicatorRect()))
+	{
+		painter.setRenderHint(QPainter::SmoothPixmapTransform);
+		m_sprites.draw(painter, makePiece(m_game.getPosition().getTurn(), KING), turnIndicatorRect());
+		painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+	}
 	// Highlight selected square if there is one
-	if (m_selSq != Sq::NONE)
+	if (m_selSq != Sq::NONE && dirty.intersects(tileRectBySquare(m_selSq)))
 	{
 		painter.setOpacity(0.25);
 		painter.setBrush(Qt::blue);
 		painter.setPen(Qt::blue);
-		painter.drawRect(QRect(tilePointBySquare(m_selSq), m_tileQSize.toSize()));
+		painter.drawRect(tileRectBySquare(m_selSq));
+		painter.setOpacity(1.0);
 	}
+	// Mark legal targets of selected piece, the one under dragged piece stronger
+	if (m_selSq != Sq::NONE && userMoves())
+	{
+		const Square hoverSq = m_dragging ? squareByPoint(m_dragPoint) : Sq::NONE;
+		painter.setRenderHint(QPainter::Antialiasing);
+		painter.setPen(Qt::NoPen);
+		painter.setBrush(Qt::darkGreen);
+		for (Bitboard targets = m_legalTargets[m_selSq]; targets;)
+		{
+			const Square sq = popLSB(targets);
+			const QRect tileRect = tileRectBySquare(sq);
+			if (!dirty.intersects(tileRect))
+				continue;
+			if (sq == hoverSq)
+			{
+				painter.setOpacity(0.4);
+				painter.drawRect(tileRect);
+			}
+			else
+			{
+				painter.setOpacity(0.3);
+				painter.drawEllipse(QRectF(tileRect).center(), tileRect.width() / 6.0, tileRect.height() / 6.0);
+			}
+		}
+		painter.setOpacity(1.0);
+		painter.setRenderHint(QPainter::Antialiasing, false);
+	}
+	// Sliding pieces
+	for (const SlidingPiece& sliding : m_sliding)
+		if (const QRect rect = slideRect(sliding); dirty.intersects(rect))
+			m_sprites.draw(painter, sliding.piece, rect);
+	// Dragged piece is drawn over everything
+	if (m_dragging && m_selSq != Sq::NONE && dirty.intersects(dragRect()))
+		m_sprites.draw(painter, board[m_selSq], dragRect());
 	painter.end();
 }
 
 void BoardWidget::resizeEvent(QResizeEvent* eventInfo)
 {
 	QWidget::resizeEvent(eventInfo);
+	layoutBoard();
+	m_borderCache = QPixmap();
+	requestCaches();
+}
+
+void BoardWidget::changeEvent(QEvent* eventInfo)
+{
+	QWidget::changeEvent(eventInfo);
+	// Background and coordinates depend on style sheet, palette and font
+	if (eventInfo->type() == QEvent::StyleChange || eventInfo->type() == QEvent::PaletteChange
+		|| eventInfo->type() == QEvent::FontChange)
+	{
+		m_borderCache = QPixmap();
+		update();
+	}
 }
 
 void BoardWidget::mousePressEvent(QMouseEvent* eventInfo)
 {
+	if (eventInfo->button() != Qt::MouseButton::LeftButton)
+		return;
 	const Square sq = squareByPoint(eventInfo->pos());
-	if (eventInfo->button() == Qt::MouseButton::LeftButton)
+	if (sq == Sq::NONE)
 	{
-		if (sq == m_selSq)
-			return;
-		if (sq == Sq::NONE)
+		setSelectedSquare(Sq::NONE);
+		return;
+	}
+	// Illegal targets are rejected by lookup, so only legal moves reach the game
+	if (m_selSq != Sq::NONE && sq != m_selSq)
+		if (const Move move = userMove(m_selSq, sq); move != Move(MOVE_NONE))
 		{
-			if (m_selSq != Sq::NONE)
-			{
-				m_selSq = Sq::NONE;
-				repaint();
-			}
+			setSelectedSquare(Sq::NONE);
+			doMove(move);
 			return;
 		}
-		const Position& board = m_game.getPosition();
-		if (m_selSq == Sq::NONE)
-		{
-			if (board[sq] != PIECE_NULL)
-			{
-				m_selSq = sq;
-				repaint();
-			}
-		}
-		else if (userMoves())
-		{
-			Move candidateMove = Move(m_selSq, sq);
-			// NOT just DoMove candidateMove, since it (NOW) expects correct
-			// move flags, which we haven't set
-			if (doMove(candidateMove.toUCI()))
-				m_selSq = Sq::NONE;
-			else if (board[sq] != PIECE_NULL)
-				m_selSq = sq;
-			else
-				m_selSq = Sq::NONE;
-			repaint();
-		}
-	}
-	else if (eventInfo->button() == Qt::MouseButton::RightButton)
+	if (m_game.getPosition()[sq] == PIECE_NULL)
 	{
-
+		setSelectedSquare(Sq::NONE);
+		return;
 	}
+	// Selected piece may also be dragged to its target
+	setSelectedSquare(sq);
+	m_dragging = true;
+	m_dragPoint = eventInfo->pos();
+	update(dragRect());
+}
+
+void BoardWidget::mouseMoveEvent(QMouseEvent* eventInfo)
+{
+	if (!m_dragging)
+		return;
+	const Square oldSq = squareByPoint(m_dragPoint), newSq = squareByPoint(eventInfo->pos());
+	update(dragRect());
+	m_dragPoint = eventInfo->pos();
+	update(dragRect());
+	// Target under cursor is highlighted
+	if (oldSq != newSq)
+		for (Square sq : { oldSq, newSq })
+			if (sq != Sq::NONE)
+				update(tileRectBySquare(sq));
+}
+
+void BoardWidget::mouseReleaseEvent(QMouseEvent* eventInfo)
+{
+	if (!m_dragging || eventInfo->button() != Qt::MouseButton::LeftButton)
+		return;
+	m_dragging = false;
+	update(dragRect());
+	update(tileRectBySquare(m_selSq));
+	const Square sq = squareByPoint(eventInfo->pos());
+	if (sq != Sq::NONE)
+		update(tileRectBySquare(sq));
+	// Dropped elsewhere, piece stays selected, so that its target may be clicked
+	if (sq != Sq::NONE && sq != m_selSq)
+		if (const Move move = userMove(m_selSq, sq); move != Move(MOVE_NONE))
+		{
+			setSelectedSquare(Sq::NONE);
+			// Piece is already where it's dropped
+			m_skipAnimation = true;
+			doMove(move);
+			m_skipAnimation = false;
+		}
 }
 
 int BoardWidget::fileFromCol(int col) const
@@ -282,33 +745,60 @@ int BoardWidget::rankFromRow(int row) const
 
 void BoardWidget::startGame(void)
 {
-	// TODO sendNewGame should be followed by isready-readyok as potentially long operation
+	// 'ucinewgame' was already sent (and confirmed by 'readyok') in loadEngineOptions
 	m_game.reset();
+	clearMoveStats();
+	emit positionChanged();
 	if (m_gameType == GameType::PlayerVsEngine)
 	{
-		m_engineProc[opposite(m_userSide)].sendNewGame();
 		if (m_userSide == BLACK)
 		{
-			m_engineProc[WHITE].sendPosition("startpos");
-			m_engineProc[WHITE].sendGo(7);
+			m_engineProc[WHITE]->sendPosition("startpos");
+			m_engineProc[WHITE]->sendGo(7);
+			beginSearch(WHITE);
 		}
 	}
 	else if (m_gameType == GameType::EngineVsEngine)
 	{
-		m_engineProc[WHITE].sendNewGame();
-		m_engineProc[BLACK].sendNewGame();
-		m_engineProc[WHITE].sendPosition("startpos");
-		m_engineProc[WHITE].sendGo();
+		m_engineProc[WHITE]->sendPosition("startpos");
+		m_engineProc[WHITE]->sendGo();
+		beginSearch(WHITE);
 	}
-	update();
 }
 
 void BoardWidget::launchEngine(BlendXChess::Side side, QString path)
 {
 	if (side != WHITE && side != BLACK)
 		return;
-	UCIEngine& engine = m_engineProc[side];
-	engine.reset(path, [this](auto&&... params) {eventCallback(params...); });
+	// Options chosen for this engine last time are likely to be chosen again
+	const auto lastOptions = m_engineOptions.find(path);
+	m_engineProc[side] = m_enginePool.acquire(path,
+		[this](auto&&... params) {eventCallback(params...); },
+		lastOptions == m_engineOptions.end() ? UCIEngine::OptionValues() : lastOptions->second);
+}
+
+void BoardWidget::beginSearch(BlendXChess::Side side)
+{
+	m_searchStats[side] = MoveStats();
+	m_searchTimer[side].start();
+}
+
+void BoardWidget::sendGame(UCIEngine& engine, const std::string& nextMove) const
+{
+	static const std::string standardFEN = Game().getPositionFEN(true);
+	const std::string startFEN = m_game.getStartFEN();
+	std::vector<std::string> moves;
+	for (const Move& move : m_game.getMoves())
+		moves.push_back(move.toUCI());
+	if (!nextMove.empty())
+		moves.push_back(nextMove);
+	engine.sendPosition(startFEN == standardFEN ? std::string("startpos") : startFEN, moves);
+}
+
+void BoardWidget::clearMoveStats(void)
+{
+	m_moveStats.clear();
+	emit moveStatsReset();
 }
 
 void BoardWidget::loadEngineOptions(UCIEngine* engine)
@@ -317,17 +807,24 @@ void BoardWidget::loadEngineOptions(UCIEngine* engine)
 		new EngineParamsDialog(this, engine->getOptions());
 	if (engineParamsDialog->exec() != QDialog::Accepted)
 		return;
-	for (const auto& [optName, _opt_unused] : engine->getOptions())
+	UCIEngine::OptionValues& chosen = m_engineOptions[engine->getPath()];
+	chosen.clear();
+	for (const auto& [optName, option] : engine->getOptions())
+	{
 		engine->setOption(optName, engineParamsDialog->getOptionValue(optName));
+		if (option.getType() != UciOption::Type::Button)
+			chosen.emplace_back(optName, option.toString());
+	}
+	engine->sendNewGame(); // Long operation, so isready-readyok follows
 	engine->sendIsReady();
 }
 
 void BoardWidget::eventCallback(UCIEngine* sender, const UCIEventInfo* eventInfo)
 {
 	Side senderSide;
-	if (sender == &m_engineProc[WHITE])
+	if (sender == m_engineProc[WHITE])
 		senderSide = WHITE;
-	else if (sender == &m_engineProc[BLACK])
+	else if (sender == m_engineProc[BLACK])
 		senderSide = BLACK;
 	else
 		return; // Unknown sender
@@ -343,21 +840,27 @@ void BoardWidget::eventCallback(UCIEngine* sender, const UCIEventInfo* eventInfo
 			startGame(); // Could be only one engine, so start immediately
 		else if (m_gameType == GameType::EngineVsEngine)
 		{ // Check that both engines are loaded before starting game
-			if (m_engineProc[WHITE].getState() == UCIEngine::State::Ready &&
-				m_engineProc[BLACK].getState() == UCIEngine::State::Ready)
+			if (m_engineProc[WHITE]->getState() == UCIEngine::State::Ready &&
+				m_engineProc[BLACK]->getState() == UCIEngine::State::Ready)
 				startGame();
 		}
 		break;
 	case UCIEventInfo::Type::BestMove:
+	{
 		if (senderSide != m_game.getPosition().getTurn())
 			return;
-		if (!doMove(eventInfo->bestMove))
+		MoveStats stats = m_searchStats[senderSide];
+		stats.time = int(m_searchTimer[senderSide].elapsed());
+		if (!doMove(eventInfo->bestMove, stats))
 			return;
-		update();
+		startPonder(senderSide, eventInfo->ponderMove);
 		break;
+	}
 	case UCIEventInfo::Type::Info:
-		m_engineInfoWidget->appendLine(eventInfo->errorText);
-		// TEMPORARY
+		// Lines of pondering search don't belong to any move yet
+		if (sender->getState() == UCIEngine::State::Searching)
+			m_searchStats[senderSide].update(eventInfo->infoDetails, senderSide);
+		m_engineInfoWidget->append(eventInfo->infoDetails);
 		break;
 	case UCIEventInfo::Type::Error:
 		QMessageBox::critical(this, "Engine error",
@@ -407,3 +910,13 @@ QPoint BoardWidget::tilePointBySquare(Square sq) const
 	const auto [row, col] = tileCoordBySquare(sq);
 	return QPoint(col * m_tileSize, row * m_tileSize) + m_boardLUCorner;
 }
+
+QRect BoardWidget::tileRectBySquare(Square sq) const
+{
+	return QRect(tilePointBySquare(sq), m_tileQSize.toSize());
+}
+
+QRect BoardWidget::turnIndicatorRect(void) const
+{
+	return QRect(m_boardLUCorner - QPoint(m_borderWidth, m_borderWidth), QSize(m_borderWidth, m_borderWidth));
+}
@@ -1,14 +1,24 @@
 #pragma once
 #include <QtWidgets>
-#include <QtSvg>
 #include <map>
 #include <memory>
+#include <thread>
 #include "Engine/engine.h"
 #include "Core/UCIEngine.h"
+#include "Core/MoveStats.h"
+#include "Core/EnginePool.h"
+#include "PieceSprites.h"
+
+namespace bench
+{
+	int runClick(QApplication& app);
+}
 
 class BoardWidget : public QWidget
 {
 	Q_OBJECT
+	// Clicks at squares by their coordinates
+	friend int bench::runClick(QApplication& app);
 
 public:
 	enum class GameType {
@@ -19,26 +29,94 @@ public:
 	~BoardWidget(void);
 
 	const BlendXChess::Game& game(void) const;
+	// Statistics of moves of the game (including undone ones), indexed by ply
+	inline const GameStats& moveStats(void) const noexcept;
 	void closeGame(void);
 	void startPVP(void);
 	void startWithEngine(BlendXChess::Side userSide, QString enginePath);
 	void startEngineVsEngine(QString whiteEnginePath, QString blackEnginePath);
 	void undo(void);
 	void redo(void);
+	// Go to position after given count of moves of the game (see Game::jumpToPly). Not allowed
+	// while an engine searches or, in game with engine, to position where engine is to move
+	bool jumpToPly(int ply);
 	void goEngine(BlendXChess::Side side);
-	bool doMove(const std::string& move);
+	// Let engine of given side think on opponent's time assuming he will reply with ponderMove
+	void startPonder(BlendXChess::Side side, const std::string& ponderMove);
+	void stopPondering(void);
+	bool doMove(const std::string& move, const MoveStats& stats = MoveStats());
+	bool doMove(BlendXChess::Move move, const MoveStats& stats = MoveStats());
 	bool loadPGN(std::istream& inGame);
+	void loadGame(const BlendXChess::Game& game, GameStats stats = GameStats());
 	bool userMoves(void) const noexcept;
+	// Use piece images from given directory
+	void setPieceTheme(const QString& themeDir);
+	// Whether moved pieces slide to their squares (game itself never waits for that)
+	inline void setAnimated(bool animated) noexcept;
+	inline bool animated(void) const noexcept;
+	inline PieceSprites& pieceSprites(void) noexcept;
+	QSize sizeHint(void) const override;
+	QSize minimumSizeHint(void) const override;
+signals:
+	// Position on board has changed (move, undo, redo, new or loaded game)
+	void positionChanged(void);
+	// Statistics of move at given ply were added (replacing those of undone moves from that ply)
+	void moveStatsAdded(int ply);
+	// Statistics of all moves were replaced (new or loaded game)
+	void moveStatsReset(void);
 protected:
 	void paintEvent(QPaintEvent* eventInfo) override;
 	void resizeEvent(QResizeEvent* eventInfo) override;
+	void changeEvent(QEvent* eventInfo) override;
 	void mousePressEvent(QMouseEvent* eventInfo) override;
+	void mouseMoveEvent(QMouseEvent* eventInfo) override;
+	void mouseReleaseEvent(QMouseEvent* eventInfo) override;
 
 	// Starting game when all necessary conditions (eg, engines are set up) are met
 	void startGame(void);
 	void launchEngine(BlendXChess::Side side, QString path);
+	// Reset statistics of search which the engine of given side starts (or continues after ponderhit)
+	void beginSearch(BlendXChess::Side side);
+	// Send start position and moves of the game (followed by nextMove, if any), so that
+	// engine knows the history and can detect repetitions
+	void sendGame(UCIEngine& engine, const std::string& nextMove = std::string()) const;
+	void clearMoveStats(void);
 	void loadEngineOptions(UCIEngine* engine);
 	void eventCallback(UCIEngine* sender, const UCIEventInfo* eventInfo);
+	bool engineSide(BlendXChess::Side side) const noexcept;
+	QString ponderStatsText(void) const;
+	// Schedule repaint of squares whose pieces differ from painted ones (and of turn indicator).
+	// Pieces which moved are animated from their painted squares, so that moves arriving
+	// during animation are coalesced into one. Many moved pieces (eg after jump) aren't animated
+	void updateChangedSquares(void);
+	// Move sliding pieces to their places at current time of animation
+	void animationStep(void);
+	// Put sliding pieces on their target squares at once
+	void finishAnimation(void);
+	void setSelectedSquare(BlendXChess::Square sq);
+	// Generate legal moves of the position on board once, so that clicks and drops are checked
+	// (and targets of selected piece highlighted) by a bitboard lookup
+	void updateLegalMoves(void);
+	// Schedule repaint of squares where piece on given square may move
+	void updateTargets(BlendXChess::Square sq);
+	// Legal move of user between given squares (promoting to queen) or MOVE_NONE
+	BlendXChess::Move userMove(BlendXChess::Square from, BlendXChess::Square to) const;
+	// Area of dragged piece (centered at cursor)
+	QRect dragRect(void) const;
+	// Area of sliding piece at current time of animation
+	struct SlidingPiece;
+	QRect slideRect(const SlidingPiece& sliding) const;
+	// Change orientation of the board, repainting it whole
+	void setWhiteDown(bool whiteDown);
+	// Background with coordinates for current orientation, painted once into cache
+	const QPixmap& borderLayer(void);
+	// Fit tiles and borders into current size of widget
+	void layoutBoard(void);
+	// Start preparing tiles and sprites for current tile size in background, unless they are ready
+	// or being prepared. Until then the old ones are stretched. If there are no old ones yet,
+	// they are prepared synchronously
+	void requestCaches(void);
+	void cachesReady(int pixelSize, const QString& theme, QImage whiteTile, QImage blackTile, QImage atlas);
 
 	int fileFromCol(int col) const;
 	int rankFromRow(int row) const;
@@ -46,16 +124,50 @@ protected:
 	BlendXChess::Square squareByTileCoord(int row, int col) const;
 	std::pair<int, int> tileCoordBySquare(BlendXChess::Square sq) const; // row, col
 	QPoint tilePointBySquare(BlendXChess::Square sq) const;
+	QRect tileRectBySquare(BlendXChess::Square sq) const;
+	QRect turnIndicatorRect(void) const;
 
 	class EngineInfoWidget* m_engineInfoWidget; // Widget for sending engine info
 	GameType m_gameType; // Type of current game
 	BlendXChess::Game m_game; // Game object
 	BlendXChess::Side m_userSide; // Side of user (if game type is PlayerVsEngine)
 	BlendXChess::Square m_selSq; // Selected square (NOT tile)
-	std::map<BlendXChess::Piece, QSvgRenderer> m_svgPieces; // Svg images of pieces
-	UCIEngine m_engineProc[BlendXChess::COLOR_CNT]; // Engines for sides
-	QImage m_whiteTileImage; // Image of white tile
-	QImage m_blackTileImage; // Image of black tile
+	std::vector<BlendXChess::Move> m_legalMoves; // Of the position on board
+	BlendXChess::Bitboard m_legalTargets[BlendXChess::SQUARE_CNT]; // Destinations of legal moves by origin
+	bool m_dragging; // Whether piece on selected square is being dragged
+	QPoint m_dragPoint; // Cursor position while dragging
+	PieceSprites m_sprites; // Images of pieces
+	struct SlidingPiece
+	{
+		BlendXChess::Piece piece;
+		BlendXChess::Square from, to;
+	};
+	// Pieces on board as scheduled for painting (sliding ones are on neither square)
+	BlendXChess::Piece m_shownPieces[BlendXChess::SQUARE_CNT];
+	std::vector<SlidingPiece> m_sliding; // Pieces animated to the position on board
+	QTimer m_animationTimer; // Steps animation at display frame rate
+	QElapsedTimer m_animationClock;
+	double m_animationProgress; // From 0 to 1
+	bool m_animated;
+	bool m_skipAnimation; // Set while doing move which user has dragged
+	BlendXChess::Side m_shownTurn; // Side to move as scheduled for painting
+	QPixmap m_borderCache; // Null if it should be repainted
+	bool m_borderCacheWhiteDown; // Orientation of coordinates in m_borderCache
+	EnginePool m_enginePool; // Warm engine processes reused between games
+	std::map<QString, UCIEngine::OptionValues> m_engineOptions; // Last chosen ones by engine path
+	UCIEngine* m_engineProc[BlendXChess::COLOR_CNT]; // Engines for sides (owned by m_enginePool)
+	std::string m_ponderMove[BlendXChess::COLOR_CNT]; // Move (UCI) on which engine of the side is pondering
+	SearchLimits m_searchLimits; // Of engine moves, pondering searches get the same ones
+	MoveStats m_searchStats[BlendXChess::COLOR_CNT]; // Of current search of engine of the side
+	QElapsedTimer m_searchTimer[BlendXChess::COLOR_CNT]; // Started when engine of the side is asked to move
+	GameStats m_moveStats; // Statistics of game moves by ply
+	QImage m_whiteTileImage; // Image of white tile (original size)
+	QImage m_blackTileImage; // Image of black tile (original size)
+	QPixmap m_whiteTile; // m_whiteTileImage scaled to m_tilePixelSize
+	QPixmap m_blackTile; // m_blackTileImage scaled to m_tilePixelSize
+	int m_tilePixelSize; // Size of tile caches in device pixels, 0 if there are none
+	int m_pendingPixelSize; // Size of caches prepared by m_cacheThread, 0 if it's idle
+	std::thread m_cacheThread; // Scales tiles and rasterizes sprites off GUI thread
 	QSizeF m_tileQSize; // Size of a tile
 	QSize m_boardSize; // Size of the board
 	QPoint m_boardLUCorner; // Left upper corner of the board itself (excluding border)
@@ -64,3 +176,23 @@ protected:
 	int m_borderLength; // Length (along board side) of each border
 	bool m_whiteDown; // Whether board is viewed with first rows in the bottom
 };
+
+inline const GameStats& BoardWidget::moveStats(void) const noexcept
+{
+	return m_moveStats;
+}
+
+inline void BoardWidget::setAnimated(bool animated) noexcept
+{
+	m_animated = animated;
+}
+
+inline bool BoardWidget::animated(void) const noexcept
+{
+	return m_animated;
+}
+
+inline PieceSprites& BoardWidget::pieceSprites(void) noexcept
+{
+	return m_sprites;
+}
@@ -23,6 +23,7 @@ EngineParamsDialog::EngineParamsDialog(QWidget *parent,
 	QSpinBox* spinEdit;
 	QLineEdit* stringEdit;
 	QWidget* editWidget;
+	// Current values are shown, so that engine reused from pool keeps its previous settings
 	for (const auto& [name, option] : options)
 	{
 		const QString qname = QString::fromStdString(name) + ":";
@@ -30,26 +31,26 @@ EngineParamsDialog::EngineParamsDialog(QWidget *parent,
 		{
 		case UciOption::Type::Check:
 			editWidget = checkEdit = new QCheckBox;
-			checkEdit->setChecked(option.getDefaultBool());
+			checkEdit->setChecked(option.getBool());
 			checkLayout->addRow(qname, checkEdit);
 			break;
 		case UciOption::Type::Combo:
 			editWidget = comboEdit = new QComboBox;
 			for (const auto& comboVar : option.getComboVars())
 				comboEdit->addItem(QString::fromStdString(comboVar));
-			comboEdit->setCurrentText(QString::fromStdString(option.getDefaultString()));
+			comboEdit->setCurrentText(QString::fromStdString(option.getString()));
 			comboLayout->addRow(qname, comboEdit);
 			break;
 		case UciOption::Type::Spin:
 			editWidget = spinEdit = new QSpinBox;
 			spinEdit->setMinimum(option.getMin());
 			spinEdit->setMaximum(option.getMax());
-			spinEdit->setValue(option.getDefaultInt());
+			spinEdit->setValue(option.getInt());
 			spinLayout->addRow(qname, spinEdit);
 			break;
 		case UciOption::Type::String:
 			editWidget = stringEdit = new QLineEdit;
-			stringEdit->setText(QString::fromStdString(option.getDefaultString()));
+			stringEdit->setText(QString::fromStdString(option.getString()));
 			stringLayout->addRow(qname, stringEdit);
 			break;
 		}
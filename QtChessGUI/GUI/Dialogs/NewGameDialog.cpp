@@ -1,9 +1,12 @@
 #include "NewGameDialog.h"
+#include "GUI/RowsModel.h"
+#include "Core/DBWorker.h"
+#include "Core/PlayerRegistry.h"
 
 using namespace BlendXChess;
 
-NewGameDialog::NewGameDialog(QWidget *parent)
-	: QDialog(parent)
+NewGameDialog::NewGameDialog(QWidget *parent, DBWorker& dbWorker, PlayerRegistry& players)
+	: QDialog(parent), m_dbWorker(dbWorker), m_players(players)
 {
 	QPushButton* okButton = new QPushButton("&Ok");
 	QPushButton* cancelButton = new QPushButton("&Cancel");
@@ -57,8 +60,7 @@ NewGameDialog::NewGameDialog(QWidget *parent)
 	m_whiteEngineCB->setSizeAdjustPolicy(QComboBox::SizeAdjustPolicy::AdjustToContents);
 	m_blackEngineCB->setSizeAdjustPolicy(QComboBox::SizeAdjustPolicy::AdjustToContents);
 
-	m_enginesModel = new QSqlQueryModel(this);
-	m_enginesModel->setQuery("SELECT id, name FROM engine_players");
+	m_enginesModel = new RowsModel(this);
 	m_engineCB->setModel(m_enginesModel);
 	m_engineCB->setModelColumn(1);
 	m_whiteEngineCB->setModel(m_enginesModel);
@@ -103,7 +105,23 @@ int NewGameDialog::getSelectedBlackEngineId(void) const
 
 void NewGameDialog::refresh(void)
 {
-	m_enginesModel->setQuery(m_enginesModel->query().executedQuery());
+	m_players.withPlayers(m_dbWorker, this, [this](const PlayerRegistry::Snapshot& players) {
+			db::Rows rows;
+			for (const PlayerRegistry::Engine& engine : players->engines)
+				rows.push_back({ engine.id, engine.name });
+			// Keep selection of engines by id, since their order may change
+			const int engineId = getSelectedEngineId(), whiteId = getSelectedWhiteEngineId(),
+				blackId = getSelectedBlackEngineId();
+			m_enginesModel->setRows(std::move(rows));
+			for (auto [comboBox, id] : { std::pair(m_engineCB, engineId),
+				std::pair(m_whiteEngineCB, whiteId), std::pair(m_blackEngineCB, blackId) })
+			{
+				const QModelIndexList found = m_enginesModel->match(m_enginesModel->index(0, 0),
+					Qt::DisplayRole, id, 1, Qt::MatchExactly);
+				comboBox->setCurrentIndex(found.isEmpty() ? 0 : found.front().row());
+			}
+		},
+		[this](const QString& error) { QMessageBox::warning(this, "Error", error); });
 }
 
 void NewGameDialog::sTypeToggled(bool checked)
@@ -4,17 +4,22 @@
 #include <QtSql>
 #include "Engine/basic_types.h"
 
+class DBWorker;
+class PlayerRegistry;
+class RowsModel;
+
 class NewGameDialog : public QDialog
 {
 	Q_OBJECT
 
 public:
-	NewGameDialog(QWidget *parent);
+	NewGameDialog(QWidget *parent, DBWorker& dbWorker, PlayerRegistry& players);
 	~NewGameDialog();
 	BlendXChess::Side getSelectedSide(void) const; // Valid only for Pvp
 	int getSelectedEngineId(void) const; // Valid only for withEngine
 	int getSelectedWhiteEngineId(void) const; // Valid only for engineVsEngine
 	int getSelectedBlackEngineId(void) const; // Valid only for engineVsEngine
+	// Reload engines list (from database in background unless players are cached)
 	void refresh(void);
 	inline bool pvp(void) const;
 	inline bool withEngine(void) const;
@@ -22,7 +27,9 @@ public:
 private:
 	void sTypeToggled(bool checked);
 
-	QSqlQueryModel* m_enginesModel;
+	DBWorker& m_dbWorker;
+	PlayerRegistry& m_players;
+	RowsModel* m_enginesModel;
 	QWidget* pvpW;
 	QWidget* withEngineW;
 	QWidget* engineVsEngineW;
@@ -0,0 +1,67 @@
+#include "PatternSearchDialog.h"
+
+using namespace BlendXChess;
+
+PatternSearchDialog::PatternSearchDialog(QWidget* parent, const Position& current)
+	: QDialog(parent), m_current(current)
+{
+	setWindowTitle("Search by material and pawns");
+	QPushButton* searchButton = new QPushButton("&Search");
+	QPushButton* cancelButton = new QPushButton("&Cancel");
+	m_materialEdit = new QLineEdit;
+	m_materialEdit->setPlaceholderText("e.g. KRPvKR or KQv*, empty for any");
+	for (Side side : { WHITE, BLACK })
+		m_pawnsCB[side] = createPawnsCB();
+
+	QFormLayout* queryLayout = new QFormLayout;
+	queryLayout->addRow("Material: ", m_materialEdit);
+	queryLayout->addRow("White pawns: ", m_pawnsCB[WHITE]);
+	queryLayout->addRow("Black pawns: ", m_pawnsCB[BLACK]);
+
+	QHBoxLayout* buttonsLayout = new QHBoxLayout;
+	buttonsLayout->addWidget(searchButton);
+	buttonsLayout->addWidget(cancelButton);
+
+	QVBoxLayout* mainLayout = new QVBoxLayout;
+	mainLayout->addLayout(queryLayout);
+	mainLayout->addLayout(buttonsLayout);
+	setLayout(mainLayout);
+
+	searchButton->setDefault(true);
+	connect(searchButton, &QPushButton::clicked, this, &PatternSearchDialog::sSearch);
+	connect(cancelButton, &QPushButton::clicked, this, &QDialog::reject);
+}
+
+PatternSearchDialog::~PatternSearchDialog()
+{}
+
+QComboBox* PatternSearchDialog::createPawnsCB(void)
+{
+	QComboBox* comboBox = new QComboBox;
+	comboBox->addItem("Any", ANY);
+	comboBox->addItem("Isolated queen pawn", ISOLATED_QUEEN_PAWN);
+	comboBox->addItem("Same as on board", SAME_AS_ON_BOARD);
+	comboBox->setSizeAdjustPolicy(QComboBox::SizeAdjustPolicy::AdjustToContents);
+	return comboBox;
+}
+
+void PatternSearchDialog::sSearch(void)
+{
+	const QString material = m_materialEdit->text().trimmed();
+	try
+	{
+		m_query = material.isEmpty() ? PatternIndex::Query() : PatternIndex::parseMaterial(material.toStdString());
+	}
+	catch (const std::runtime_error& err)
+	{
+		QMessageBox::critical(this, "Error", err.what());
+		return;
+	}
+	for (Side side : { WHITE, BLACK })
+		switch (m_pawnsCB[side]->currentData().toInt())
+		{
+		case ISOLATED_QUEEN_PAWN: m_query.pawns[side] = PatternIndex::isolatedQueenPawn(); break;
+		case SAME_AS_ON_BOARD: m_query.pawns[side] = PatternIndex::samePawns(m_current, side); break;
+		}
+	accept();
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <QtWidgets>
+#include <QDialog>
+#include "Core/PatternIndex.h"
+
+// Input of material and pawn structure to search for in stored games (see PatternIndex)
+class PatternSearchDialog : public QDialog
+{
+	Q_OBJECT
+
+public:
+	// Pawn structures may be taken from current position on board
+	PatternSearchDialog(QWidget* parent, const BlendXChess::Position& current);
+	~PatternSearchDialog();
+	// Valid after dialog is accepted
+	inline const PatternIndex::Query& query(void) const noexcept;
+private:
+	enum PawnStructure {
+		ANY, ISOLATED_QUEEN_PAWN, SAME_AS_ON_BOARD
+	};
+	void sSearch(void);
+	QComboBox* createPawnsCB(void);
+
+	const BlendXChess::Position& m_current;
+	PatternIndex::Query m_query;
+	QLineEdit* m_materialEdit;
+	QComboBox* m_pawnsCB[BlendXChess::COLOR_CNT];
+};
+
+inline const PatternIndex::Query& PatternSearchDialog::query(void) const noexcept
+{
+	return m_query;
+}
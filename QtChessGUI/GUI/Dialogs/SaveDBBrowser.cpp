@@ -3,6 +3,10 @@
 #include "GUI/BoardWidget.h"
 #include "GUI/QtChessGUI.h"
 #include "Engine/engine.h"
+#include "Core/Database.h"
+#include "Core/DBWorker.h"
+#include "Core/PlayerRegistry.h"
+#include "GUI/RowsModel.h"
 
 using namespace BlendXChess;
 
@@ -23,10 +27,20 @@ SaveDBBrowser::SaveDBBrowser(QtChessGUI* parent)
 	m_whiteName->setSizeAdjustPolicy(QComboBox::SizeAdjustPolicy::AdjustToContents);
 	m_blackName->setSizeAdjustPolicy(QComboBox::SizeAdjustPolicy::AdjustToContents);
 
-	m_enginesModel = new QSqlQueryModel(this);
-	m_humansModel = new QSqlQueryModel(this);
-	m_enginesModel->setQuery("SELECT id, name FROM engine_players");
-	m_humansModel->setQuery("SELECT human_players.id, name FROM human_players INNER JOIN persons ON personId = persons.id");
+	m_enginesModel = new RowsModel(this);
+	m_humansModel = new RowsModel(this);
+	m_parent->playerRegistry().withPlayers(m_parent->dbWorker(), this,
+		[this](const PlayerRegistry::Snapshot& players) {
+			db::Rows engines, humans;
+			for (const PlayerRegistry::Engine& engine : players->engines)
+				engines.push_back({ engine.id, engine.name });
+			for (const PlayerRegistry::Human& human : players->humans)
+				humans.push_back({ human.id, human.name });
+			m_players = players;
+			m_enginesModel->setRows(std::move(engines));
+			m_humansModel->setRows(std::move(humans));
+		},
+		[this](const QString& error) { QMessageBox::warning(this, "Error", error); });
 
 	QVBoxLayout* whiteTypeLayout = new QVBoxLayout;
 	whiteTypeLayout->addWidget(m_whiteHuman);
@@ -59,33 +73,35 @@ SaveDBBrowser::~SaveDBBrowser()
 
 void SaveDBBrowser::sSave(void)
 {
-	const Game& game = m_parent->getBoardWidget()->game();
-	QString PGN = game.getGame().data(), result;
-	switch (game.getGameState())
-	{
-	case GameState::DRAW: result = "1/2-1/2"; break;
-	case GameState::WHITE_WIN: result = "1-0"; break;
-	case GameState::BLACK_WIN: result = "0-1"; break;
-	default: result = "Active"; break;
-	}
+	const Game game = m_parent->getBoardWidget()->game();
+	const GameStats stats = m_parent->getBoardWidget()->moveStats();
 	int whiteId = m_whiteName->model()->data(
 		m_whiteName->model()->index(m_whiteName->currentIndex(), 0)).toInt();
 	int blackId = m_blackName->model()->data(
-		m_whiteName->model()->index(m_blackName->currentIndex(), 0)).toInt();
-	QDate date = QDate::currentDate();
-	QSqlQuery query;
-	query.prepare("INSERT INTO games(whitePlayerId, blackPlayerId, PGN, date, result) VALUES(?, ?, ?, ?, ?)");
-	query.addBindValue(whiteId);
-	query.addBindValue(blackId);
-	query.addBindValue(PGN);
-	query.addBindValue(date);
-	query.addBindValue(result);
-	if (!query.exec())
-	{
-		QMessageBox::critical(this, "Error storing game in database: ", query.lastError().text());
-		return;
-	}
-	accept();
+		m_blackName->model()->index(m_blackName->currentIndex(), 0)).toInt();
+	// Dialog stays open (but inactive) until the game is stored
+	m_okButton->setEnabled(false);
+	const QString result = db::resultString(game.getGameState());
+	m_parent->dbWorker().run(this, [whiteId, blackId, game, stats, result](QSqlDatabase database) {
+		return db::insertGame(whiteId, blackId, game, result, QDate::currentDate(), stats, database); },
+		[this, game, whiteId, blackId](int gameId) {
+			m_parent->addToPatternIndex(gameId, game);
+			if (OpeningExplorer& explorer = m_parent->openingExplorer(); explorer.isOpen())
+				try
+				{
+					explorer.addGame(game, game.getGameState(),
+						m_players ? m_players->elo(whiteId) : 0, m_players ? m_players->elo(blackId) : 0);
+				}
+				catch (const std::runtime_error& err)
+				{ // Game itself is saved, statistics can be recollected later
+					QMessageBox::warning(this, "Error", QString("Opening explorer wasn't updated: ") + err.what());
+				}
+			accept();
+		},
+		[this](const QString& error) {
+			m_okButton->setEnabled(true);
+			QMessageBox::critical(this, "Error", error);
+		});
 }
 
 void SaveDBBrowser::sWhiteTypeSel(bool checked)
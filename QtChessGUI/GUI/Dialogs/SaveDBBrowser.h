@@ -2,9 +2,10 @@
 
 #include <QDialog>
 #include <QtWidgets>
+#include "Core/PlayerRegistry.h"
 
 class QtChessGUI;
-class QSqlQueryModel;
+class RowsModel;
 
 class SaveDBBrowser : public QDialog
 {
@@ -19,8 +20,9 @@ protected:
 	void sBlackTypeSel(bool checked);
 
 	QtChessGUI* m_parent;
-	QSqlQueryModel* m_enginesModel;
-	QSqlQueryModel* m_humansModel;
+	RowsModel* m_enginesModel;
+	RowsModel* m_humansModel;
+	PlayerRegistry::Snapshot m_players; // Listed players, for their ratings
 	QRadioButton* m_whiteHuman;
 	QRadioButton* m_blackHuman;
 	QRadioButton* m_whiteEngine;
@@ -0,0 +1,83 @@
+#include "TournamentDialog.h"
+#include "Core/DBWorker.h"
+
+TournamentDialog::TournamentDialog(QWidget* parent, DBWorker& dbWorker, PlayerRegistry& players)
+	: QDialog(parent)
+{
+	QPushButton* okButton = new QPushButton("&Start");
+	QPushButton* cancelButton = new QPushButton("&Cancel");
+	m_enginesList = new QListWidget;
+	m_concurrencySB = new QSpinBox;
+	m_roundsSB = new QSpinBox;
+	m_movetimeSB = new QSpinBox;
+
+	m_concurrencySB->setRange(1, 64);
+	m_concurrencySB->setValue(8);
+	m_concurrencySB->setToolTip("Games played and shown simultaneously");
+	m_roundsSB->setRange(1, 1000);
+	m_movetimeSB->setRange(10, 600000);
+	m_movetimeSB->setValue(1000);
+	m_movetimeSB->setSuffix(" ms");
+
+	QGroupBox* optionsGB = new QGroupBox("Tournament options");
+	QFormLayout* optionsLayout = new QFormLayout;
+	optionsLayout->addRow("Simultaneous games: ", m_concurrencySB);
+	optionsLayout->addRow("Rounds: ", m_roundsSB);
+	optionsLayout->addRow("Time per move: ", m_movetimeSB);
+	optionsGB->setLayout(optionsLayout);
+
+	QHBoxLayout* okCancelLayout = new QHBoxLayout;
+	okCancelLayout->addWidget(okButton);
+	okCancelLayout->addWidget(cancelButton);
+
+	QVBoxLayout* mainLayout = new QVBoxLayout;
+	mainLayout->addWidget(new QLabel("Engines:"));
+	mainLayout->addWidget(m_enginesList);
+	mainLayout->addWidget(optionsGB);
+	mainLayout->addLayout(okCancelLayout);
+	setLayout(mainLayout);
+	setWindowTitle("Watch tournament");
+
+	connect(okButton, &QPushButton::clicked, this, &TournamentDialog::sAccept);
+	connect(cancelButton, &QPushButton::clicked, this, &TournamentDialog::reject);
+
+	players.withPlayers(dbWorker, this, [this](const PlayerRegistry::Snapshot& players) {
+			m_players = players;
+			for (const PlayerRegistry::Engine& engine : players->engines)
+			{
+				QListWidgetItem* item = new QListWidgetItem(engine.name, m_enginesList);
+				item->setData(Qt::UserRole, engine.id);
+				item->setFlags(item->flags() | Qt::ItemIsUserCheckable);
+				item->setCheckState(Qt::Unchecked);
+			}
+		},
+		[this](const QString& error) { QMessageBox::warning(this, "Error", error); });
+}
+
+TournamentConfig TournamentDialog::config(void) const
+{
+	TournamentConfig config;
+	for (int i = 0; i < m_enginesList->count(); ++i)
+	{
+		const QListWidgetItem* item = m_enginesList->item(i);
+		if (item->checkState() != Qt::Checked)
+			continue;
+		if (const PlayerRegistry::Engine* engine = m_players->engine(item->data(Qt::UserRole).toInt()))
+			config.engines.push_back({ engine->name, engine->path, engine->id });
+	}
+	config.concurrency = m_concurrencySB->value();
+	config.rounds = m_roundsSB->value();
+	config.timeControl.movetime = m_movetimeSB->value();
+	return config;
+}
+
+void TournamentDialog::sAccept(void)
+{
+	int checked = 0;
+	for (int i = 0; i < m_enginesList->count(); ++i)
+		checked += m_enginesList->item(i)->checkState() == Qt::Checked;
+	if (checked < 2)
+		QMessageBox::warning(this, "Error", "Choose at least two engines");
+	else
+		accept();
+}
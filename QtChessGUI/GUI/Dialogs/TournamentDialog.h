@@ -0,0 +1,26 @@
+#pragma once
+#include <QtWidgets>
+#include <QDialog>
+#include "Core/Tournament.h"
+#include "Core/PlayerRegistry.h"
+
+class DBWorker;
+
+// Choice of database engines and settings of a tournament watched in GUI
+class TournamentDialog : public QDialog
+{
+	Q_OBJECT
+
+public:
+	TournamentDialog(QWidget* parent, DBWorker& dbWorker, PlayerRegistry& players);
+	// Tournament of checked engines (valid after dialog is accepted)
+	TournamentConfig config(void) const;
+private:
+	void sAccept(void);
+
+	PlayerRegistry::Snapshot m_players;
+	QListWidget* m_enginesList; // Checkable, with engine ids as user data
+	QSpinBox* m_concurrencySB;
+	QSpinBox* m_roundsSB;
+	QSpinBox* m_movetimeSB;
+};
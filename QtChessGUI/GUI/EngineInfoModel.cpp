@@ -0,0 +1,126 @@
+#include "EngineInfoModel.h"
+#include <algorithm>
+
+EngineInfoModel::EngineInfoModel(QObject* parent, int capacity)
+	: QAbstractTableModel(parent), m_first(0), m_count(0), m_capacity(std::max(capacity, 1))
+{
+	m_records.resize(m_capacity);
+	m_flushTimer.setSingleShot(true);
+	m_flushTimer.setInterval(FLUSH_INTERVAL);
+	connect(&m_flushTimer, &QTimer::timeout, this, &EngineInfoModel::flush);
+}
+
+void EngineInfoModel::append(const InfoDetails& info)
+{
+	// Progress lines (current move, hash usage...) without evaluation aren't worth a row
+	if (info.scoreType == InfoDetails::ScoreType::None && info.pv.empty() && info.text.empty())
+		return;
+	if (m_pending.size() == size_t(m_capacity))
+		m_pending.erase(m_pending.begin()); // Would be dropped on flush anyway
+	m_pending.push_back(info);
+	if (!m_flushTimer.isActive())
+		m_flushTimer.start();
+}
+
+void EngineInfoModel::flush(void)
+{
+	m_flushTimer.stop();
+	if (m_pending.empty())
+		return;
+	const int incoming = int(m_pending.size());
+	// Oldest records are dropped to make space, their slots are reused
+	const int dropped = std::max(0, m_count + incoming - m_capacity);
+	if (dropped > 0)
+	{
+		beginRemoveRows(QModelIndex(), 0, dropped - 1);
+		m_first = (m_first + dropped) % m_capacity;
+		m_count -= dropped;
+		endRemoveRows();
+	}
+	beginInsertRows(QModelIndex(), m_count, m_count + incoming - 1);
+	for (InfoDetails& info : m_pending)
+		m_records[(m_first + m_count++) % m_capacity] = std::move(info);
+	endInsertRows();
+	m_pending.clear();
+}
+
+void EngineInfoModel::clear(void)
+{
+	m_flushTimer.stop();
+	m_pending.clear();
+	beginResetModel();
+	m_first = 0;
+	m_count = 0;
+	endResetModel();
+}
+
+int EngineInfoModel::rowCount(const QModelIndex& parent) const
+{
+	return parent.isValid() ? 0 : m_count;
+}
+
+int EngineInfoModel::columnCount(const QModelIndex& parent) const
+{
+	return parent.isValid() ? 0 : COLUMN_COUNT;
+}
+
+QVariant EngineInfoModel::data(const QModelIndex& index, int role) const
+{
+	if (!index.isValid() || index.row() >= m_count)
+		return QVariant();
+	const InfoDetails& info = record(index.row());
+	if (role == Qt::TextAlignmentRole)
+		return int(index.column() == PV ? Qt::AlignLeft | Qt::AlignVCenter : Qt::AlignRight | Qt::AlignVCenter);
+	if (role == Qt::ToolTipRole && index.column() == PV)
+		return QString::fromStdString(info.pv.empty() ? info.text : info.pv); // Long variations are elided
+	if (role != Qt::DisplayRole)
+		return QVariant();
+	const QLocale locale;
+	switch (index.column())
+	{
+	case DEPTH:
+		if (info.depth < 0)
+			return QVariant();
+		return info.selDepth < 0 ? QString::number(info.depth)
+			: QString("%1/%2").arg(info.depth).arg(info.selDepth);
+	case SCORE:
+		return scoreText(info);
+	case NODES:
+		return info.nodes < 0 ? QVariant() : locale.toString(info.nodes);
+	case NPS:
+		return info.nps < 0 ? QVariant() : locale.toString(info.nps);
+	case PV:
+		// Engine's message is shown in place of variation
+		return QString::fromStdString(info.pv.empty() ? info.text : info.pv);
+	}
+	return QVariant();
+}
+
+QVariant EngineInfoModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+	static const char* const HEADERS[COLUMN_COUNT] = { "Depth", "Score", "Nodes", "NPS", "PV" };
+	if (orientation == Qt::Horizontal && role == Qt::DisplayRole && section >= 0 && section < COLUMN_COUNT)
+		return QString(HEADERS[section]);
+	return QAbstractTableModel::headerData(section, orientation, role);
+}
+
+QString EngineInfoModel::scoreText(const InfoDetails& info)
+{
+	QString text;
+	switch (info.scoreType)
+	{
+	case InfoDetails::ScoreType::None:
+		return text;
+	case InfoDetails::ScoreType::Cp:
+		text = QString("%1%2").arg(info.score >= 0 ? "+" : "").arg(info.score / 100.0, 0, 'f', 2);
+		break;
+	case InfoDetails::ScoreType::Mate:
+		text = QString("#%1").arg(info.score);
+		break;
+	}
+	if (info.bound == InfoDetails::Bound::Lower)
+		text.prepend(">= ");
+	else if (info.bound == InfoDetails::Bound::Upper)
+		text.prepend("<= ");
+	return text;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QTimer>
+#include <vector>
+#include "Core/UCIEngine.h"
+
+// Last info records of engine kept in a ring buffer of fixed capacity, so that memory
+// doesn't grow during long analysis. Records are appended in batches (at most once
+// per flush interval), so that the view doesn't process every single info line
+class EngineInfoModel : public QAbstractTableModel
+{
+public:
+	enum Column {
+		DEPTH, SCORE, NODES, NPS, PV, COLUMN_COUNT
+	};
+	static constexpr int DEFAULT_CAPACITY = 1000;
+	static constexpr int FLUSH_INTERVAL = 50; // ms
+
+	EngineInfoModel(QObject* parent, int capacity = DEFAULT_CAPACITY);
+	// Queue record, it's shown on next flush
+	void append(const InfoDetails& info);
+	// Show queued records now
+	void flush(void);
+	void clear(void);
+	inline int capacity(void) const noexcept;
+	int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+	int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+	QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+	QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+	static QString scoreText(const InfoDetails& info);
+private:
+	// Record shown in given row (0 is the oldest one)
+	inline const InfoDetails& record(int row) const;
+
+	std::vector<InfoDetails> m_records; // Ring buffer of capacity slots
+	int m_first; // Slot of the oldest record
+	int m_count; // Records in buffer
+	std::vector<InfoDetails> m_pending; // Appended since last flush (at most capacity newest ones)
+	const int m_capacity;
+	QTimer m_flushTimer;
+};
+
+inline int EngineInfoModel::capacity(void) const noexcept
+{
+	return m_capacity;
+}
+
+inline const InfoDetails& EngineInfoModel::record(int row) const
+{
+	return m_records[(m_first + row) % m_capacity];
+}
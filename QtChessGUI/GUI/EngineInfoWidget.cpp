@@ -1,9 +1,36 @@
 #include "EngineInfoWidget.h"
+#include <QHeaderView>
+#include <QScrollBar>
+#include "EngineInfoModel.h"
 
 EngineInfoWidget::EngineInfoWidget(QWidget *parent)
-	: QTextEdit(parent)
+	: QTableView(parent), m_followTail(true)
 {
-	setReadOnly(true);
+	m_model = new EngineInfoModel(this);
+	setModel(m_model);
+	setEditTriggers(QAbstractItemView::NoEditTriggers);
+	setSelectionMode(QAbstractItemView::NoSelection);
+	setWordWrap(false);
+	setShowGrid(false);
+	// Fixed row height lets the view lay out only visible rows
+	verticalHeader()->hide();
+	verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+	verticalHeader()->setDefaultSectionSize(fontMetrics().height() + 4);
+	// Columns aren't resized to contents, which would measure every row
+	horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
+	horizontalHeader()->setStretchLastSection(true);
+	const int digitWidth = fontMetrics().horizontalAdvance('0');
+	setColumnWidth(EngineInfoModel::DEPTH, 6 * digitWidth);
+	setColumnWidth(EngineInfoModel::SCORE, 9 * digitWidth);
+	setColumnWidth(EngineInfoModel::NODES, 13 * digitWidth);
+	setColumnWidth(EngineInfoModel::NPS, 11 * digitWidth);
+
+	connect(verticalScrollBar(), &QScrollBar::actionTriggered, [this](int) {
+		m_followTail = verticalScrollBar()->sliderPosition() >= verticalScrollBar()->maximum(); });
+	connect(m_model, &QAbstractItemModel::rowsInserted, [this](void) {
+		if (m_followTail)
+			scrollToBottom();
+	});
 }
 
 EngineInfoWidget::~EngineInfoWidget(void)
@@ -11,10 +38,11 @@ EngineInfoWidget::~EngineInfoWidget(void)
 
 void EngineInfoWidget::clear(void)
 {
-	QTextEdit::clear();
+	m_model->clear();
+	m_followTail = true;
 }
 
-void EngineInfoWidget::appendLine(const std::string& str)
+void EngineInfoWidget::append(const InfoDetails& info)
 {
-	QTextEdit::append(QString::fromStdString(str));
+	m_model->append(info);
 }
@@ -1,8 +1,13 @@
 #pragma once
 
-#include <QTextEdit>
+#include <QTableView>
+#include "Core/UCIEngine.h"
 
-class EngineInfoWidget : public QTextEdit
+class EngineInfoModel;
+
+// Table of engine's search progress. Only visible rows are laid out and the number of
+// kept records is bounded (see EngineInfoModel). Follows new records while scrolled to the bottom
+class EngineInfoWidget : public QTableView
 {
 	Q_OBJECT
 
@@ -10,5 +15,8 @@ public:
 	EngineInfoWidget(QWidget *parent);
 	~EngineInfoWidget(void);
 	void clear(void);
-	void appendLine(const std::string& str);
+	void append(const InfoDetails& info);
+private:
+	EngineInfoModel* m_model;
+	bool m_followTail; // Whether view is scrolled to the bottom by user
 };
@@ -1,38 +1,16 @@
 #include "EnginesBrowser.h"
 #include <QtWidgets>
+#include "RowsModel.h"
+#include "Core/Database.h"
+#include "Core/DBWorker.h"
+#include "Core/PlayerRegistry.h"
 
-EnginesBrowser::EnginesBrowser(QWidget *parent)
-	: QDialog(parent), m_selectedEngineId(-1)
+EnginesBrowser::EnginesBrowser(QWidget *parent, DBWorker& dbWorker, PlayerRegistry& players)
+	: QDialog(parent), m_dbWorker(dbWorker), m_players(players), m_selectedEngineId(-1)
 {
-	enginesModel = new QSqlQueryModel;
-	enginesModel->setQuery(R"(
-		SELECT
-			players.id AS id,
-			engine_players.name AS name,
-			version,
-			persons.name AS authorName,
-			programmingLanguage,
-			ELO,
-			path
-		FROM engine_players
-		INNER JOIN players ON engine_players.id = players.id
-		INNER JOIN persons ON authorId = persons.Id)"
-	);
-	enginesModel->setHeaderData(enginesModel->record().indexOf("name"), Qt::Horizontal, "Name");
-	enginesModel->setHeaderData(enginesModel->record().indexOf("version"), Qt::Horizontal, "Version");
-	enginesModel->setHeaderData(enginesModel->record().indexOf("authorName"), Qt::Horizontal, "Author");
-	enginesModel->setHeaderData(enginesModel->record().indexOf("programmingLanguage"), Qt::Horizontal, "Language");
-	enginesModel->setHeaderData(enginesModel->record().indexOf("path"), Qt::Horizontal, "UCI Executable Path");
-	if (enginesModel->lastError().isValid())
-	{
-		QMessageBox::warning(this, "Error", "Could not fetch data from table: "
-			+ enginesModel->lastError().text());
-		reject();
-		return;
-	}
-
-	authorsModel = new QSqlQueryModel;
-	authorsModel->setQuery("SELECT id, name FROM persons");
+	enginesModel = new RowsModel(this,
+		{ "Id", "Name", "Version", "Author", "Language", "ELO", "UCI Executable Path" });
+	authorsModel = new RowsModel(this);
 
 	view = new QTableView;
 	view->setModel(enginesModel);
@@ -98,6 +76,8 @@ EnginesBrowser::EnginesBrowser(QWidget *parent)
 	connect(modifyButton, &QPushButton::clicked, this, &EnginesBrowser::sModify);
 	connect(removeButton, &QPushButton::clicked, this, &EnginesBrowser::sRemove);
 	connect(closeButton, &QPushButton::clicked, this, &EnginesBrowser::reject);
+
+	refreshTable();
 }
 
 EnginesBrowser::~EnginesBrowser(void)
@@ -114,9 +94,40 @@ bool EnginesBrowser::checkValues(void)
 	return false;
 }
 
+db::EngineData EnginesBrowser::enteredData(void) const
+{
+	QVariant authorId = (authorCB->currentIndex() == -1 ?
+		QVariant() : authorsModel->data(authorsModel->index(authorCB->currentIndex(), 0)).toInt());
+	return { nameEdit->text(), versionEdit->text(), authorId, langEdit->text(),
+		pathEdit->text(), eloSB->value() };
+}
+
 void EnginesBrowser::refreshTable(void)
 {
-	enginesModel->setQuery(enginesModel->query().executedQuery());
+	m_players.withPlayers(m_dbWorker, this, [this](const PlayerRegistry::Snapshot& players) {
+			db::Rows engines, authors;
+			for (const PlayerRegistry::Engine& engine : players->engines)
+				engines.push_back({ engine.id, engine.name, engine.version, engine.authorName,
+					engine.programmingLanguage, engine.elo, engine.path });
+			for (const PlayerRegistry::Person& person : players->persons)
+				authors.push_back({ person.id, person.name });
+			// Author combo box would lose its text on model reset
+			const QString author = authorCB->currentText();
+			authorsModel->setRows(std::move(authors));
+			authorCB->setCurrentIndex(authorCB->findText(author));
+			view->clearSelection();
+			enginesModel->setRows(std::move(engines));
+			view->resizeColumnsToContents();
+		},
+		[this](const QString& error) {
+			QMessageBox::warning(this, "Error", "Could not fetch data from table: " + error); });
+}
+
+void EnginesBrowser::setBusy(bool busy)
+{
+	addButton->setDisabled(busy);
+	modifyButton->setDisabled(busy || m_selectedEngineId == -1);
+	removeButton->setDisabled(busy || m_selectedEngineId == -1);
 }
 
 void EnginesBrowser::sSelectionChanged(const QItemSelection& selected, const QItemSelection&)
@@ -164,38 +175,20 @@ void EnginesBrowser::sAdd(void)
 	if (!checkValues())
 		return;
 
-	QSqlDatabase::database().transaction();
-	QSqlQuery query;
-	query.prepare("INSERT INTO players(ELO) VALUES(?)");
-	query.addBindValue(eloSB->value());
-	if (!query.exec())
-	{
-		QSqlDatabase::database().rollback();
-		QMessageBox::critical(this, "Operation result",
-			"Error storing engine in database: " + query.lastError().text());
-		return;
-	}
-	
-	int playerId = query.lastInsertId().toInt();
-	QVariant authorId = (authorCB->currentIndex() == -1 ?
-		QVariant() : authorsModel->data(authorsModel->index(authorCB->currentIndex(), 0)).toInt());
-	query.prepare("INSERT INTO engine_players(id,authorId,programmingLanguage,name,version,path) VALUES(?,?,?,?,?,?)");
-	query.addBindValue(playerId);
-	query.addBindValue(authorId);
-	query.addBindValue(langEdit->text());
-	query.addBindValue(nameEdit->text());
-	query.addBindValue(versionEdit->text());
-	query.addBindValue(pathEdit->text());
-	if (!query.exec())
-	{
-		QSqlDatabase::database().rollback();
-		QMessageBox::critical(this, "Operation result",
-			"Error storing engine in database: " + query.lastError().text());
-		return;
-	}
-	QSqlDatabase::database().commit();
-	QMessageBox::information(this, "Operation result", "Insert completed successfully");
-	refreshTable();
+	setBusy(true);
+	m_dbWorker.run(this, [engine = enteredData(), players = &m_players](QSqlDatabase database) {
+		db::addEngine(engine, database);
+		players->invalidate();
+	},
+		[this](void) {
+			setBusy(false);
+			QMessageBox::information(this, "Operation result", "Insert completed successfully");
+			refreshTable();
+		},
+		[this](const QString& error) {
+			setBusy(false);
+			QMessageBox::critical(this, "Operation result", error);
+		});
 }
 
 void EnginesBrowser::sModify(void)
@@ -205,38 +198,20 @@ void EnginesBrowser::sModify(void)
 	if (!checkValues())
 		return;
 
-	//QSqlDatabase::database().transaction();
-	QSqlQuery query;
-	query.prepare("UPDATE players SET ELO = ? WHERE id = ?");
-	query.addBindValue(eloSB->value());
-	query.addBindValue(m_selectedEngineId);
-	if (!query.exec())
-	{
-		//QSqlDatabase::database().rollback();
-		QMessageBox::critical(this, "Operation result",
-			"Error update engine database: " + query.lastError().text());
-		return;
-	}
-
-	QVariant authorId = (authorCB->currentIndex() == -1 ?
-		QVariant() : authorsModel->data(authorsModel->index(authorCB->currentIndex(), 0)).toInt());
-	query.prepare("UPDATE engine_players SET authorId = ?, programmingLanguage = ?, name = ?, version = ?, path = ? WHERE id = ?");
-	query.addBindValue(authorId);
-	query.addBindValue(langEdit->text());
-	query.addBindValue(nameEdit->text());
-	query.addBindValue(versionEdit->text());
-	query.addBindValue(pathEdit->text());
-	query.addBindValue(m_selectedEngineId);
-	if (!query.exec())
-	{
-		//QSqlDatabase::database().rollback();
-		QMessageBox::critical(this, "Operation result",
-			"Error update engine database: " + query.lastError().text());
-		return;
-	}
-	//QSqlDatabase::database().commit();
-	QMessageBox::information(this, "Operation result", "Update completed successfully");
-	refreshTable();
+	setBusy(true);
+	m_dbWorker.run(this, [id = m_selectedEngineId, engine = enteredData(), players = &m_players](QSqlDatabase database) {
+		db::updateEngine(id, engine, database);
+		players->invalidate();
+	},
+		[this](void) {
+			setBusy(false);
+			QMessageBox::information(this, "Operation result", "Update completed successfully");
+			refreshTable();
+		},
+		[this](const QString& error) {
+			setBusy(false);
+			QMessageBox::critical(this, "Operation result", error);
+		});
 }
 
 void EnginesBrowser::sRemove(void)
@@ -244,28 +219,18 @@ void EnginesBrowser::sRemove(void)
 	if (m_selectedEngineId == -1)
 		return;
 
-	QSqlDatabase::database().transaction();
-	QSqlQuery query;
-	query.prepare("DELETE FROM engine_players WHERE id = ?");
-	query.addBindValue(m_selectedEngineId);
-	if (!query.exec())
-	{
-		QSqlDatabase::database().rollback();
-		QMessageBox::critical(this, "Operation result",
-			"Error deleting from engine database: " + query.lastError().text());
-		return;
-	}
-	
-	query.prepare("DELETE FROM players WHERE id = ?");
-	query.addBindValue(m_selectedEngineId);
-	if (!query.exec())
-	{
-		QSqlDatabase::database().rollback();
-		QMessageBox::critical(this, "Operation result",
-			"Error deleting from engine database: " + query.lastError().text());
-		return;
-	}
-	QSqlDatabase::database().commit();
-	QMessageBox::information(this, "Operation result", "Delete completed successfully");
-	refreshTable();
+	setBusy(true);
+	m_dbWorker.run(this, [id = m_selectedEngineId, players = &m_players](QSqlDatabase database) {
+		db::removeEngine(id, database);
+		players->invalidate();
+	},
+		[this](void) {
+			setBusy(false);
+			QMessageBox::information(this, "Operation result", "Delete completed successfully");
+			refreshTable();
+		},
+		[this](const QString& error) {
+			setBusy(false);
+			QMessageBox::critical(this, "Operation result", error);
+		});
 }
@@ -3,16 +3,25 @@
 #include <QDialog>
 #include <QtSql>
 
+class DBWorker;
+class PlayerRegistry;
+class RowsModel;
+namespace db { struct EngineData; }
+
 class EnginesBrowser : public QDialog
 {
 	Q_OBJECT
 
 public:
-	EnginesBrowser(QWidget *parent);
+	EnginesBrowser(QWidget *parent, DBWorker& dbWorker, PlayerRegistry& players);
 	~EnginesBrowser(void);
 private:
 	bool checkValues(void);
+	db::EngineData enteredData(void) const;
+	// Reload engines and authors (from database in background unless players are cached)
 	void refreshTable(void);
+	// Enable or disable editing while operation is in progress
+	void setBusy(bool busy);
 
 	void sSelectionChanged(const QItemSelection& selected, const QItemSelection&);
 	void sBrowsePath(void);
@@ -20,9 +29,11 @@ private:
 	void sModify(void);
 	void sRemove(void);
 
+	DBWorker& m_dbWorker;
+	PlayerRegistry& m_players; // Invalidated after every change
 	int m_selectedEngineId;
-	QSqlQueryModel* enginesModel;
-	QSqlQueryModel* authorsModel;
+	RowsModel* enginesModel;
+	RowsModel* authorsModel;
 	class QLineEdit* nameEdit;
 	class QLineEdit* versionEdit;
 	class QComboBox* authorCB;
@@ -0,0 +1,51 @@
+#include "ExplorerWidget.h"
+#include "Core/OpeningExplorer.h"
+#include <QHeaderView>
+
+using namespace BlendXChess;
+
+ExplorerWidget::ExplorerWidget(QWidget* parent, const OpeningExplorer& explorer)
+	: QTableWidget(parent), m_explorer(explorer)
+{
+	setColumnCount(6);
+	setHorizontalHeaderLabels({ "Move", "Games", "White", "Draw", "Black", "Avg Elo" });
+	setEditTriggers(QAbstractItemView::NoEditTriggers);
+	setSelectionBehavior(QAbstractItemView::SelectRows);
+	verticalHeader()->hide();
+	horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+	connect(this, &QTableWidget::cellDoubleClicked, [this](int row, int) {
+		emit moveActivated(item(row, 0)->data(Qt::UserRole).toString()); });
+}
+
+ExplorerWidget::~ExplorerWidget(void)
+{}
+
+void ExplorerWidget::showPosition(const Game& game)
+{
+	const auto stats = m_explorer.lookup(game.getPositionKey());
+	setRowCount(int(stats.size()));
+	for (int row = 0; row < int(stats.size()); ++row)
+	{
+		const OpeningExplorer::MoveStats& moveStats = stats[row];
+		QString moveText;
+		try
+		{
+			moveText = QString::fromStdString(game.getPosition().moveToSAN(moveStats.move));
+		}
+		catch (const std::runtime_error&)
+		{ // Key collision may give move which is illegal here
+			moveText = QString::fromStdString(moveStats.move.toUCI());
+		}
+		const auto percent = [&moveStats](uint32_t count) {
+			return QString::number(100.0 * count / moveStats.games, 'f', 1) + '%'; };
+		QTableWidgetItem* moveItem = new QTableWidgetItem(moveText);
+		moveItem->setData(Qt::UserRole, QString::fromStdString(moveStats.move.toUCI()));
+		setItem(row, 0, moveItem);
+		setItem(row, 1, new QTableWidgetItem(QString::number(moveStats.games)));
+		setItem(row, 2, new QTableWidgetItem(percent(moveStats.whiteWins)));
+		setItem(row, 3, new QTableWidgetItem(percent(moveStats.draws)));
+		setItem(row, 4, new QTableWidgetItem(percent(moveStats.blackWins)));
+		setItem(row, 5, new QTableWidgetItem(moveStats.eloCount == 0 ? QString("-")
+			: QString::number(qRound(moveStats.averageElo()))));
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <QTableWidget>
+#include "Engine/engine.h"
+
+class OpeningExplorer;
+
+// Table of moves played from the position on board with their results in stored games
+class ExplorerWidget : public QTableWidget
+{
+	Q_OBJECT
+
+public:
+	ExplorerWidget(QWidget* parent, const OpeningExplorer& explorer);
+	~ExplorerWidget(void);
+	void showPosition(const BlendXChess::Game& game);
+signals:
+	// Move (UCI) was double clicked
+	void moveActivated(const QString& move);
+private:
+	const OpeningExplorer& m_explorer;
+};
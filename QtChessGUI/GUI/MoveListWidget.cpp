@@ -0,0 +1,65 @@
+#include "MoveListWidget.h"
+#include <QHeaderView>
+
+using namespace BlendXChess;
+
+MoveListWidget::MoveListWidget(QWidget* parent)
+	: QTableWidget(parent), m_shift(0)
+{
+	setColumnCount(2);
+	setHorizontalHeaderLabels({ "White", "Black" });
+	setEditTriggers(QAbstractItemView::NoEditTriggers);
+	setSelectionMode(QAbstractItemView::SingleSelection);
+	horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+	verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+	connect(this, &QTableWidget::cellClicked, [this](int row, int column) {
+		const int ply = row * 2 + column - m_shift;
+		if (0 <= ply && ply < int(m_moves.size()))
+			emit plyActivated(ply + 1);
+	});
+}
+
+MoveListWidget::~MoveListWidget(void)
+{}
+
+void MoveListWidget::showGame(const BlendXChess::Game& game)
+{
+	const Position& pos = game.getPosition();
+	const int shift = (pos.getGamePly() & 1) == (pos.getTurn() == WHITE);
+	if (shift != m_shift)
+	{ // Moves are moved to other cells
+		clearContents();
+		m_moves.clear();
+		m_shift = shift;
+	}
+	std::vector<std::string> moves = game.getHistoryMoves();
+	// Moves before the first changed one are kept
+	size_t same = 0;
+	while (same < moves.size() && same < m_moves.size() && moves[same] == m_moves[same])
+		++same;
+	for (int ply = int(same); ply < int(m_moves.size()); ++ply)
+	{
+		const auto [row, column] = cellByPly(ply);
+		delete takeItem(row, column);
+	}
+	// Rows are numbered by moves, as vertical header does by default
+	setRowCount((int(moves.size()) + m_shift + 1) / 2);
+	for (int ply = int(same); ply < int(moves.size()); ++ply)
+	{
+		const auto [row, column] = cellByPly(ply);
+		setItem(row, column, new QTableWidgetItem(QString::fromStdString(moves[ply])));
+	}
+	m_moves = std::move(moves);
+	if (pos.getGamePly() == 0)
+		clearSelection();
+	else
+	{
+		const auto [row, column] = cellByPly(pos.getGamePly() - 1);
+		setCurrentCell(row, column);
+	}
+}
+
+std::pair<int, int> MoveListWidget::cellByPly(int ply) const
+{
+	return { (ply + m_shift) / 2, (ply + m_shift) % 2 };
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <QTableWidget>
+#include <string>
+#include <vector>
+#include "Engine/engine.h"
+
+// Moves of the game on board (including undone ones) with the current one selected.
+// Only cells of moves which changed are refilled when the game is shown again
+class MoveListWidget : public QTableWidget
+{
+	Q_OBJECT
+
+public:
+	MoveListWidget(QWidget* parent);
+	~MoveListWidget(void);
+	void showGame(const BlendXChess::Game& game);
+signals:
+	// Move was clicked, ply is the count of moves up to and including it
+	void plyActivated(int ply);
+private:
+	// Cell of the move made at given ply (counted from 0)
+	std::pair<int, int> cellByPly(int ply) const; // row, column
+
+	std::vector<std::string> m_moves; // Shown moves
+	int m_shift; // 1 if game started with black's move, 0 otherwise
+};
@@ -0,0 +1,159 @@
+#include "MoveStatsGraph.h"
+#include <algorithm>
+
+namespace
+{
+	constexpr int MARGIN = 4;
+	constexpr int MIN_PLY_RANGE = 40;
+	constexpr double SCORE_RANGE = 1000.0; // Centipawns, higher scores and mates are clipped
+	const QColor WHITE_LINE_COLOR(90, 90, 90), BLACK_LINE_COLOR(30, 30, 200), SCORE_LINE_COLOR(200, 60, 30);
+}
+
+MoveStatsGraph::MoveStatsGraph(QWidget* parent)
+	: QWidget(parent), m_series(Series::Score), m_plyRange(MIN_PLY_RANGE), m_valueRange(SCORE_RANGE)
+{
+	setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Fixed);
+}
+
+void MoveStatsGraph::setSeries(Series series)
+{
+	m_series = series;
+	fitScales();
+	replot();
+}
+
+void MoveStatsGraph::setStats(const GameStats& stats)
+{
+	m_stats = stats;
+	fitScales();
+	replot();
+}
+
+void MoveStatsGraph::append(const MoveStats& stats)
+{
+	m_stats.push_back(stats);
+	const int ply = int(m_stats.size()) - 1;
+	const std::optional<double> newValue = value(stats);
+	if (!newValue || m_plot.isNull()) // Not shown yet
+		return;
+	if (exceedsScales(ply, *newValue))
+	{
+		fitScales();
+		replot();
+		return;
+	}
+	QPainter painter(&m_plot);
+	update(plotSegment(painter, ply));
+}
+
+QSize MoveStatsGraph::sizeHint(void) const
+{
+	return QSize(300, 120);
+}
+
+void MoveStatsGraph::paintEvent(QPaintEvent* eventInfo)
+{
+	QPainter painter(this);
+	painter.drawPixmap(0, 0, m_plot);
+}
+
+void MoveStatsGraph::resizeEvent(QResizeEvent* eventInfo)
+{
+	QWidget::resizeEvent(eventInfo);
+	replot();
+}
+
+std::optional<double> MoveStatsGraph::value(const MoveStats& stats) const
+{
+	switch (m_series)
+	{
+	case Series::Score:
+		if (stats.scoreType == InfoDetails::ScoreType::Mate)
+			return stats.score >= 0 ? SCORE_RANGE : -SCORE_RANGE;
+		if (stats.scoreType == InfoDetails::ScoreType::Cp)
+			return std::clamp(double(stats.score), -SCORE_RANGE, SCORE_RANGE);
+		return std::nullopt;
+	case Series::Depth:
+		return stats.depth >= 0 ? std::optional<double>(stats.depth) : std::nullopt;
+	case Series::Nodes:
+		return stats.nodes >= 0 ? std::optional<double>(double(stats.nodes)) : std::nullopt;
+	case Series::Time:
+		return stats.time >= 0 ? std::optional<double>(stats.time) : std::nullopt;
+	}
+	return std::nullopt;
+}
+
+int MoveStatsGraph::previousPoint(int ply) const
+{
+	// Score is one line for both sides, other series have a line per engine
+	const int step = m_series == Series::Score ? 1 : 2;
+	for (int prev = ply - step; prev >= 0; prev -= step)
+		if (value(m_stats[prev]))
+			return prev;
+	return -1;
+}
+
+QPointF MoveStatsGraph::pointAt(int ply, double value) const
+{
+	const double width = std::max(1, this->width() - 2 * MARGIN), height = std::max(1, this->height() - 2 * MARGIN);
+	const double low = m_series == Series::Score ? -m_valueRange : 0.0;
+	return QPointF(MARGIN + width * ply / m_plyRange,
+		MARGIN + height * (m_valueRange - value) / (m_valueRange - low));
+}
+
+bool MoveStatsGraph::exceedsScales(int ply, double value) const
+{
+	return ply > m_plyRange || m_series != Series::Score && value > m_valueRange;
+}
+
+void MoveStatsGraph::fitScales(void)
+{
+	m_plyRange = MIN_PLY_RANGE;
+	while (m_plyRange < int(m_stats.size()) - 1)
+		m_plyRange *= 2;
+	if (m_series == Series::Score)
+	{
+		m_valueRange = SCORE_RANGE;
+		return;
+	}
+	double maxValue = 0.0;
+	for (const MoveStats& stats : m_stats)
+		maxValue = std::max(maxValue, value(stats).value_or(0.0));
+	m_valueRange = 1.0;
+	while (m_valueRange < maxValue)
+		m_valueRange *= 2;
+}
+
+void MoveStatsGraph::replot(void)
+{
+	const qreal pixelRatio = devicePixelRatioF();
+	m_plot = QPixmap(size() * pixelRatio);
+	m_plot.setDevicePixelRatio(pixelRatio);
+	m_plot.fill(palette().color(QPalette::Base));
+	QPainter painter(&m_plot);
+	painter.setPen(palette().color(QPalette::Mid));
+	const double axisY = pointAt(0, 0.0).y();
+	painter.drawLine(QPointF(MARGIN, axisY), QPointF(width() - MARGIN, axisY));
+	for (int ply = 0; ply < int(m_stats.size()); ++ply)
+		plotSegment(painter, ply);
+	painter.end();
+	update();
+}
+
+QRect MoveStatsGraph::plotSegment(QPainter& painter, int ply) const
+{
+	const std::optional<double> endValue = value(m_stats[ply]);
+	if (!endValue)
+		return QRect();
+	const QPointF end = pointAt(ply, *endValue);
+	const int prev = previousPoint(ply);
+	const QPointF begin = prev >= 0 ? pointAt(prev, *value(m_stats[prev])) : end;
+	painter.setRenderHint(QPainter::Antialiasing);
+	painter.setPen(QPen(m_series == Series::Score ? SCORE_LINE_COLOR
+		: ply % 2 == 0 ? WHITE_LINE_COLOR : BLACK_LINE_COLOR, 1.5));
+	if (prev >= 0)
+		painter.drawLine(begin, end);
+	else
+		painter.drawPoint(end);
+	return QRectF(begin, end).normalized().toAlignedRect().adjusted(-2, -2, 2, 2);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <QtWidgets>
+#include <optional>
+#include "Core/MoveStats.h"
+
+// Plot of one statistic of game moves over plies. The plot is kept in a pixmap, and a move
+// appended during the game only draws its segment there, unless it doesn't fit the current
+// scales. Those are doubled then, so that whole plot is redrawn only a few times per game
+class MoveStatsGraph : public QWidget
+{
+	Q_OBJECT
+
+public:
+	enum class Series {
+		Score, Depth, Nodes, Time
+	};
+
+	MoveStatsGraph(QWidget* parent);
+	void setSeries(Series series);
+	inline Series series(void) const noexcept;
+	void setStats(const GameStats& stats);
+	// Count of plotted moves
+	inline int plies(void) const noexcept;
+	void append(const MoveStats& stats);
+	QSize sizeHint(void) const override;
+protected:
+	void paintEvent(QPaintEvent* eventInfo) override;
+	void resizeEvent(QResizeEvent* eventInfo) override;
+private:
+	// Value of the series for the move, none if engine didn't report it
+	std::optional<double> value(const MoveStats& stats) const;
+	// Ply of previous point of the line ending at given ply, -1 if there's none
+	int previousPoint(int ply) const;
+	QPointF pointAt(int ply, double value) const;
+	// Whether scales are to be widened to show the point
+	bool exceedsScales(int ply, double value) const;
+	void fitScales(void);
+	// Draw whole plot into m_plot
+	void replot(void);
+	// Draw segment ending at given ply into m_plot, returning its bounding rectangle
+	QRect plotSegment(QPainter& painter, int ply) const;
+
+	GameStats m_stats;
+	Series m_series;
+	QPixmap m_plot;
+	int m_plyRange; // Plies across the width
+	double m_valueRange; // Value at the top (and negated at the bottom for score)
+};
+
+inline MoveStatsGraph::Series MoveStatsGraph::series(void) const noexcept
+{
+	return m_series;
+}
+
+inline int MoveStatsGraph::plies(void) const noexcept
+{
+	return int(m_stats.size());
+}
@@ -0,0 +1,175 @@
+#include "MultiBoardView.h"
+#include "PieceSprites.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace BlendXChess;
+
+namespace
+{
+	constexpr int CELL_MARGIN = 6;
+	constexpr int MIN_TILE_SIZE = 6;
+	const QColor WHITE_TILE_COLOR(240, 217, 181), BLACK_TILE_COLOR(181, 136, 99);
+}
+
+MultiBoardView::MultiBoardView(QWidget* parent, PieceSprites& sprites)
+	: QWidget(parent), m_sprites(sprites), m_columns(1), m_tileSize(MIN_TILE_SIZE),
+	m_titleHeight(fontMetrics().height() + 2), m_spritePixelSize(0)
+{
+	setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+	m_refreshTimer.setSingleShot(true);
+	m_refreshTimer.setInterval(REFRESH_INTERVAL);
+	connect(&m_refreshTimer, &QTimer::timeout, this, &MultiBoardView::refresh);
+}
+
+void MultiBoardView::setBoardCount(int count)
+{
+	Board empty;
+	std::fill(std::begin(empty.pieces), std::end(empty.pieces), PIECE_NULL);
+	m_boards.assign(std::max(count, 0), empty);
+	layoutGrid();
+	update();
+}
+
+void MultiBoardView::setPosition(int board, const QString& fen)
+{
+	if (board < 0 || board >= boardCount())
+		return;
+	// Only the last position before refresh is parsed
+	m_boards[board].pendingFEN = fen;
+	if (!m_refreshTimer.isActive())
+		m_refreshTimer.start();
+}
+
+void MultiBoardView::setTitle(int board, const QString& title)
+{
+	if (board < 0 || board >= boardCount())
+		return;
+	m_boards[board].title = title;
+	update(cellRect(board));
+}
+
+QSize MultiBoardView::sizeHint(void) const
+{
+	return QSize(900, 700);
+}
+
+void MultiBoardView::paintEvent(QPaintEvent* eventInfo)
+{
+	const int pixelSize = qRound(m_tileSize * devicePixelRatioF());
+	if (pixelSize != m_spritePixelSize || !m_sprites.hasAtlas(pixelSize))
+	{ // Small sprites are cheap to rasterize, so they aren't prepared in background
+		m_sprites.prepare(pixelSize, this);
+		m_spritePixelSize = pixelSize;
+	}
+	const QRegion& dirty = eventInfo->region();
+	QPainter painter;
+	painter.begin(this);
+	painter.fillRect(eventInfo->rect(), palette().color(QPalette::Window));
+	for (int i = 0; i < boardCount(); ++i)
+	{
+		const QRect cell = cellRect(i);
+		if (!dirty.intersects(cell))
+			continue;
+		const Board& board = m_boards[i];
+		painter.drawText(QRect(cell.topLeft(), QSize(cell.width(), m_titleHeight)),
+			Qt::AlignLeft | Qt::AlignVCenter, fontMetrics().elidedText(board.title, Qt::ElideRight, cell.width()));
+		const QPoint origin = boardRect(i).topLeft();
+		for (int row = 0; row < RANK_CNT; ++row)
+			for (int col = 0; col < FILE_CNT; ++col)
+			{
+				const Square sq(RANK_CNT - 1 - row, col);
+				const QRect tile(origin + QPoint(col * m_tileSize, row * m_tileSize), QSize(m_tileSize, m_tileSize));
+				painter.fillRect(tile, sq.color() == WHITE ? WHITE_TILE_COLOR : BLACK_TILE_COLOR);
+				if (const Piece piece = board.pieces[sq]; piece != PIECE_NULL)
+					m_sprites.draw(painter, piece, tile);
+			}
+	}
+	painter.end();
+}
+
+void MultiBoardView::resizeEvent(QResizeEvent* eventInfo)
+{
+	QWidget::resizeEvent(eventInfo);
+	layoutGrid();
+}
+
+void MultiBoardView::refresh(void)
+{
+	for (int i = 0; i < boardCount(); ++i)
+	{
+		Board& board = m_boards[i];
+		if (board.pendingFEN.isEmpty())
+			continue;
+		Piece pieces[SQUARE_CNT];
+		if (parsePlacement(board.pendingFEN, pieces)
+			&& !std::equal(std::begin(pieces), std::end(pieces), std::begin(board.pieces)))
+		{
+			std::copy(std::begin(pieces), std::end(pieces), std::begin(board.pieces));
+			update(boardRect(i));
+		}
+		board.pendingFEN.clear();
+	}
+}
+
+void MultiBoardView::layoutGrid(void)
+{
+	const int count = std::max(boardCount(), 1);
+	// Columns giving the largest boards which fit
+	m_tileSize = MIN_TILE_SIZE;
+	m_columns = 1;
+	for (int columns = 1; columns <= count; ++columns)
+	{
+		const int rows = (count + columns - 1) / columns;
+		const int cellWidth = width() / columns, cellHeight = height() / rows;
+		const int tileSize = std::min(cellWidth - 2 * CELL_MARGIN,
+			cellHeight - 2 * CELL_MARGIN - m_titleHeight) / FILE_CNT;
+		if (tileSize > m_tileSize)
+		{
+			m_tileSize = tileSize;
+			m_columns = columns;
+		}
+	}
+}
+
+QRect MultiBoardView::cellRect(int board) const
+{
+	const int cellWidth = FILE_CNT * m_tileSize + 2 * CELL_MARGIN;
+	const int cellHeight = RANK_CNT * m_tileSize + 2 * CELL_MARGIN + m_titleHeight;
+	return QRect((board % m_columns) * cellWidth + CELL_MARGIN, (board / m_columns) * cellHeight + CELL_MARGIN,
+		cellWidth - 2 * CELL_MARGIN, cellHeight - 2 * CELL_MARGIN);
+}
+
+QRect MultiBoardView::boardRect(int board) const
+{
+	const QRect cell = cellRect(board);
+	return QRect(cell.left(), cell.top() + m_titleHeight, FILE_CNT * m_tileSize, RANK_CNT * m_tileSize);
+}
+
+bool MultiBoardView::parsePlacement(const QString& fen, BlendXChess::Piece* pieces)
+{
+	std::fill(pieces, pieces + SQUARE_CNT, PIECE_NULL);
+	int rank = RANK_CNT - 1, file = 0;
+	for (const QChar c : fen)
+	{
+		if (c == ' ')
+			break;
+		if (c == '/')
+		{
+			--rank;
+			file = 0;
+		}
+		else if (c.isDigit())
+			file += c.digitValue();
+		else
+		{
+			static const QString PIECE_CHARS = "pnbrqk";
+			const int type = PIECE_CHARS.indexOf(c.toLower());
+			if (type < 0 || rank < 0 || file >= FILE_CNT)
+				return false;
+			pieces[Square(rank, file)] = makePiece(c.isUpper() ? WHITE : BLACK, PieceType(PAWN + type));
+			++file;
+		}
+	}
+	return rank == 0;
+}
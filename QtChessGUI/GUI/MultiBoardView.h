@@ -0,0 +1,63 @@
+#pragma once
+#include <QtWidgets>
+#include <vector>
+#include "Engine/engine.h"
+
+class PieceSprites;
+
+// Grid of small boards showing live games (e.g. of TournamentRunner slots). Positions
+// coming from game threads are only stored, boards are updated by timer at most once per
+// REFRESH_INTERVAL and only changed ones are repainted, so that many fast games don't flood
+// GUI thread with paints. Pieces are drawn from sprites shared with the main board
+class MultiBoardView : public QWidget
+{
+	Q_OBJECT
+
+public:
+	static constexpr int REFRESH_INTERVAL = 100; // ms
+
+	MultiBoardView(QWidget* parent, PieceSprites& sprites);
+	void setBoardCount(int count);
+	inline int boardCount(void) const noexcept;
+	// Position of the board by FEN, shown on next refresh
+	void setPosition(int board, const QString& fen);
+	void setTitle(int board, const QString& title);
+	inline const QString& title(int board) const;
+	QSize sizeHint(void) const override;
+protected:
+	void paintEvent(QPaintEvent* eventInfo) override;
+	void resizeEvent(QResizeEvent* eventInfo) override;
+private:
+	struct Board
+	{
+		BlendXChess::Piece pieces[BlendXChess::SQUARE_CNT];
+		QString title;
+		QString pendingFEN; // Received since last refresh, empty if none
+	};
+	// Apply pending positions, repainting changed boards
+	void refresh(void);
+	void layoutGrid(void);
+	// Area of board with its title
+	QRect cellRect(int board) const;
+	QRect boardRect(int board) const;
+	// Fill pieces by placement field of FEN. Returns false if it's malformed
+	static bool parsePlacement(const QString& fen, BlendXChess::Piece* pieces);
+
+	PieceSprites& m_sprites;
+	std::vector<Board> m_boards;
+	QTimer m_refreshTimer;
+	int m_columns;
+	int m_tileSize;
+	int m_titleHeight;
+	int m_spritePixelSize; // Size of sprites prepared for boards
+};
+
+inline int MultiBoardView::boardCount(void) const noexcept
+{
+	return int(m_boards.size());
+}
+
+inline const QString& MultiBoardView::title(int board) const
+{
+	return m_boards[board].title;
+}
@@ -1,33 +1,69 @@
 #include "OpenDBBrowser.h"
 #include <fstream>
 
-OpenDBBrowser::OpenDBBrowser(QWidget* parent)
+OpenDBBrowser::OpenDBBrowser(QWidget* parent, const GamesTableModel::Filter& filter)
 	: QDialog(parent), ok(false), m_selectedGameId(-1)
 {
-	model = new QSqlQueryModel;
-	model->setQuery("call ExtGames()");
-	model->setHeaderData(model->record().indexOf("wname"), Qt::Horizontal, "White Name");
-	model->setHeaderData(model->record().indexOf("bname"), Qt::Horizontal, "Black Name");
-	model->setHeaderData(model->record().indexOf("wtype"), Qt::Horizontal, "White Type");
-	model->setHeaderData(model->record().indexOf("btype"), Qt::Horizontal, "Black Type");
-	if (model->lastError().isValid())
+	// Whole table is never loaded, only pages the user scrolls to
+	m_gamesModel = new GamesTableModel(this, filter);
+	connect(m_gamesModel, &GamesTableModel::errorOccurred, [this](const QString& error) {
+		QMessageBox::warning(this, "Error", error); });
+	connect(m_gamesModel, &GamesTableModel::firstPageLoaded, [this](qint64 elapsed) {
+		setWindowTitle(windowTitle().section(" (", 0, 0)
+			+ QString(" (first page loaded in %1 ms)").arg(elapsed)); });
+	setWindowTitle("Games");
+
+	m_playerFilter = new QLineEdit(filter.player);
+	m_playerFilter->setPlaceholderText("Player");
+	m_playerFilter->setClearButtonEnabled(true);
+	// Minimum date is shown as "Any" and means no bound
+	m_fromFilter = new QDateEdit;
+	m_toFilter = new QDateEdit;
+	for (QDateEdit* dateEdit : { m_fromFilter, m_toFilter })
 	{
-		QMessageBox::warning(this, "Error", "Could not fetch data from table: "
-			+ model->lastError().text());
-		reject();
-		return;
+		dateEdit->setCalendarPopup(true);
+		dateEdit->setMinimumDate(QDate(1900, 1, 1));
+		dateEdit->setSpecialValueText("Any");
+		dateEdit->setDate(dateEdit->minimumDate());
 	}
+	if (filter.from.isValid())
+		m_fromFilter->setDate(filter.from);
+	if (filter.to.isValid())
+		m_toFilter->setDate(filter.to);
+	m_resultFilter = new QComboBox;
+	m_resultFilter->addItem("Any result", QString());
+	for (const char* result : { "1-0", "0-1", "1/2-1/2", "Active" })
+		m_resultFilter->addItem(result, QString(result));
+	m_resultFilter->setCurrentIndex(std::max(m_resultFilter->findData(filter.result), 0));
+
+	QHBoxLayout* filterLayout = new QHBoxLayout;
+	filterLayout->addWidget(m_playerFilter);
+	filterLayout->addWidget(new QLabel("From"));
+	filterLayout->addWidget(m_fromFilter);
+	filterLayout->addWidget(new QLabel("To"));
+	filterLayout->addWidget(m_toFilter);
+	filterLayout->addWidget(m_resultFilter);
+
+	connect(m_playerFilter, &QLineEdit::editingFinished, this, &OpenDBBrowser::sApplyFilter);
+	connect(m_fromFilter, &QDateEdit::dateChanged, this, &OpenDBBrowser::sApplyFilter);
+	connect(m_toFilter, &QDateEdit::dateChanged, this, &OpenDBBrowser::sApplyFilter);
+	connect(m_resultFilter, QOverload<int>::of(&QComboBox::currentIndexChanged),
+		this, &OpenDBBrowser::sApplyFilter);
 
 	view = new QTableView;
-	view->setModel(model);
+	view->setModel(m_gamesModel);
 	view->hideColumn(0);
 	view->hideColumn(1);
 	view->hideColumn(2);
 	view->setSelectionBehavior(QAbstractItemView::SelectRows);
 	view->horizontalHeader()->setStretchLastSection(true);
+	// Sorting is done by the database server
+	view->horizontalHeader()->setSortIndicator(GamesTableModel::DATE, Qt::DescendingOrder);
+	view->setSortingEnabled(true);
 	connect(view, &QTableView::doubleClicked, this, &OpenDBBrowser::sViewClicked);
 
 	QVBoxLayout* mainLayout = new QVBoxLayout;
+	mainLayout->addLayout(filterLayout);
 	mainLayout->addWidget(view);
 	setLayout(mainLayout);
 
@@ -54,6 +90,20 @@ int OpenDBBrowser::getSelectedGameId(void) const
 
 void OpenDBBrowser::sViewClicked(const QModelIndex& index)
 {
-	m_selectedGameId = model->data(model->index(index.row(), 0)).toInt();
+	m_selectedGameId = m_gamesModel->gameId(index.row());
 	accept();
 }
+
+void OpenDBBrowser::sApplyFilter(void)
+{
+	GamesTableModel::Filter filter = m_gamesModel->filter();
+	filter.player = m_playerFilter->text().trimmed();
+	filter.from = m_fromFilter->date() != m_fromFilter->minimumDate() ? m_fromFilter->date() : QDate();
+	filter.to = m_toFilter->date() != m_toFilter->minimumDate() ? m_toFilter->date() : QDate();
+	filter.result = m_resultFilter->currentData().toString();
+	const GamesTableModel::Filter& current = m_gamesModel->filter();
+	if (filter.player == current.player && filter.from == current.from
+		&& filter.to == current.to && filter.result == current.result)
+		return; // editingFinished is emitted on every focus loss
+	m_gamesModel->setFilter(filter);
+}
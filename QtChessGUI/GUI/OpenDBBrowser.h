@@ -2,23 +2,30 @@
 
 #include <QtWidgets>
 #include <QtSql>
+#include "Core/GamesTableModel.h"
 
 class OpenDBBrowser : public QDialog
 {
 	Q_OBJECT
 
 public:
-	OpenDBBrowser(QWidget *parent);
+	// Shows games matching initial filter page by page, the filter can be narrowed by user
+	OpenDBBrowser(QWidget *parent, const GamesTableModel::Filter& filter = GamesTableModel::Filter());
 	~OpenDBBrowser();
 	bool isOK(void) const;
 	int getSelectedGameId(void) const;
 	void resizeEvent(QResizeEvent*) override;
 private:
 	void sViewClicked(const QModelIndex& index);
+	void sApplyFilter(void);
 
 	bool ok;
 	int m_selectedGameId;
 	QString qString;
-	QSqlQueryModel* model;
+	GamesTableModel* m_gamesModel;
+	QLineEdit* m_playerFilter;
+	QDateEdit* m_fromFilter;
+	QDateEdit* m_toFilter;
+	QComboBox* m_resultFilter;
 	QTableView* view;
 };
@@ -0,0 +1,139 @@
+#include "PieceSprites.h"
+#include <algorithm>
+#include <cstdlib>
+
+using namespace BlendXChess;
+
+namespace
+{
+	// Pieces in order of their sprites in atlas, with names of their files
+	constexpr Piece ATLAS_PIECES[] = {
+		W_PAWN, W_KNIGHT, W_BISHOP, W_ROOK, W_QUEEN, W_KING,
+		B_PAWN, B_KNIGHT, B_BISHOP, B_ROOK, B_QUEEN, B_KING
+	};
+	constexpr const char* PIECE_FILES[] = {
+		"whitePawn.svg", "whiteKnight.svg", "whiteBishop.svg", "whiteRook.svg", "whiteQueen.svg", "whiteKing.svg",
+		"blackPawn.svg", "blackKnight.svg", "blackBishop.svg", "blackRook.svg", "blackQueen.svg", "blackKing.svg"
+	};
+	constexpr int ATLAS_SIZE = sizeof(ATLAS_PIECES) / sizeof(ATLAS_PIECES[0]);
+
+	int atlasIndex(Piece piece)
+	{
+		return int(std::find(ATLAS_PIECES, ATLAS_PIECES + ATLAS_SIZE, piece) - ATLAS_PIECES);
+	}
+
+	void loadRenderers(const QString& themeDir, std::map<Piece, QSvgRenderer>& renderers)
+	{
+		const QDir dir(themeDir);
+		for (int i = 0; i < ATLAS_SIZE; ++i)
+			renderers[ATLAS_PIECES[i]].load(dir.filePath(PIECE_FILES[i]));
+	}
+
+	QImage paintAtlas(std::map<Piece, QSvgRenderer>& renderers, int size)
+	{
+		QImage atlas(ATLAS_SIZE * size, size, QImage::Format_ARGB32_Premultiplied);
+		atlas.fill(Qt::transparent);
+		QPainter painter(&atlas);
+		painter.setRenderHint(QPainter::HighQualityAntialiasing);
+		for (int i = 0; i < ATLAS_SIZE; ++i)
+			renderers[ATLAS_PIECES[i]].render(&painter, QRectF(i * size, 0, size, size));
+		painter.end();
+		return atlas;
+	}
+}
+
+PieceSprites::PieceSprites(const QString& themeDir)
+	: m_caching(true)
+{
+	setTheme(themeDir);
+}
+
+void PieceSprites::setTheme(const QString& themeDir)
+{
+	m_theme = themeDir;
+	loadRenderers(themeDir, m_svgPieces);
+	invalidate();
+}
+
+void PieceSprites::draw(QPainter& painter, BlendXChess::Piece piece, const QRect& target)
+{
+	const int index = atlasIndex(piece);
+	if (index == ATLAS_SIZE)
+		return;
+	if (!m_caching)
+	{
+		painter.save();
+		painter.setRenderHint(QPainter::HighQualityAntialiasing);
+		m_svgPieces[piece].render(&painter, target);
+		painter.restore();
+		return;
+	}
+	const int size = qRound(target.width() * painter.device()->devicePixelRatioF());
+	auto it = m_atlases.find(size);
+	if (it == m_atlases.end())
+	{
+		// Nearest size is stretched, only the first atlas is rasterized here
+		it = std::min_element(m_atlases.begin(), m_atlases.end(), [size](const auto& lhs, const auto& rhs) {
+			return std::abs(lhs.first - size) < std::abs(rhs.first - size); });
+		if (it == m_atlases.end())
+			it = m_atlases.emplace(size, QPixmap::fromImage(paintAtlas(m_svgPieces, size))).first;
+	}
+	const int spriteSize = it->first;
+	painter.drawPixmap(QRectF(target), it->second, QRectF(index * spriteSize, 0, spriteSize, spriteSize));
+}
+
+bool PieceSprites::hasAtlas(int size) const
+{
+	return m_atlases.count(size) != 0;
+}
+
+void PieceSprites::setAtlas(int size, QPixmap atlas, QObject* user)
+{
+	m_atlases[size] = std::move(atlas);
+	use(size, user);
+}
+
+void PieceSprites::prepare(int size, QObject* user)
+{
+	if (!hasAtlas(size))
+		m_atlases.emplace(size, QPixmap::fromImage(paintAtlas(m_svgPieces, size)));
+	use(size, user);
+}
+
+void PieceSprites::use(int size, QObject* user)
+{
+	// Pointers of destroyed boards are null
+	m_users.erase(std::remove_if(m_users.begin(), m_users.end(),
+		[user](const auto& entry) { return entry.first.isNull() || entry.first == user; }), m_users.end());
+	m_users.emplace_back(user, size);
+	for (auto it = m_atlases.begin(); it != m_atlases.end();)
+		if (std::none_of(m_users.begin(), m_users.end(), [it](const auto& entry) { return entry.second == it->first; }))
+			it = m_atlases.erase(it);
+		else
+			++it;
+}
+
+void PieceSprites::invalidate(void)
+{
+	m_atlases.clear();
+}
+
+QImage PieceSprites::renderAtlas(const QString& themeDir, int size)
+{
+	// Renderers of the object belong to GUI thread, so the caller gets its own
+	std::map<Piece, QSvgRenderer> renderers;
+	loadRenderers(themeDir, renderers);
+	return paintAtlas(renderers, size);
+}
+
+QRect PieceSprites::spriteRect(BlendXChess::Piece piece, int size)
+{
+	const int index = atlasIndex(piece);
+	return index == ATLAS_SIZE ? QRect() : QRect(index * size, 0, size, size);
+}
+
+QString PieceSprites::spriteFile(BlendXChess::Piece piece)
+{
+	const int index = atlasIndex(piece);
+	return index == ATLAS_SIZE ? QString() : QString(PIECE_FILES[index]);
+}
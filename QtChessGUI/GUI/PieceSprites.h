@@ -0,0 +1,62 @@
+#pragma once
+#include <QtWidgets>
+#include <QtSvg>
+#include <map>
+#include <vector>
+#include "Engine/engine.h"
+
+// Piece images of a theme. SVG is rasterized into an atlas pixmap (a row of all pieces)
+// per sprite size in device pixels, so that painting a piece is a plain blit. When there's
+// no atlas of the needed size, the nearest one is stretched instead, so that painting never
+// waits for rasterization: new size is rendered off GUI thread (see renderAtlas) and set when it's ready.
+// May be shared by several boards, each one using one atlas size. Atlas is dropped when no board uses it
+class PieceSprites
+{
+public:
+	// Load SVG images of pieces from theme directory (whitePawn.svg, ..., blackKing.svg)
+	PieceSprites(const QString& themeDir);
+	void setTheme(const QString& themeDir);
+	inline const QString& theme(void) const noexcept;
+	// Draw piece scaled into target square
+	void draw(QPainter& painter, BlendXChess::Piece piece, const QRect& target);
+	// Whether there's atlas with sprites of given size in device pixels
+	bool hasAtlas(int size) const;
+	// Use atlas rendered by renderAtlas for board user instead of its previous one
+	void setAtlas(int size, QPixmap atlas, QObject* user);
+	// Rasterize atlas of given size now unless it's there, using it for board user instead of its previous one
+	void prepare(int size, QObject* user);
+	void invalidate(void);
+	// Whether atlases are used, otherwise SVG is rendered on every draw (for benchmarking)
+	inline void setCaching(bool caching) noexcept;
+	inline bool caching(void) const noexcept;
+	// Atlas of theme with sprites of given size in device pixels. May be called from any thread
+	static QImage renderAtlas(const QString& themeDir, int size);
+	// Area of piece's sprite in atlas with sprites of given size (null if it isn't a piece)
+	static QRect spriteRect(BlendXChess::Piece piece, int size);
+	// Name of piece's SVG file in theme directory (empty if it isn't a piece)
+	static QString spriteFile(BlendXChess::Piece piece);
+private:
+	// Record size used by user and drop atlases which no living user needs
+	void use(int size, QObject* user);
+
+	QString m_theme;
+	std::map<BlendXChess::Piece, QSvgRenderer> m_svgPieces; // Svg images of pieces
+	std::map<int, QPixmap> m_atlases; // By sprite size in device pixels
+	std::vector<std::pair<QPointer<QObject>, int>> m_users; // Boards with sizes of their atlases
+	bool m_caching;
+};
+
+inline const QString& PieceSprites::theme(void) const noexcept
+{
+	return m_theme;
+}
+
+inline void PieceSprites::setCaching(bool caching) noexcept
+{
+	m_caching = caching;
+}
+
+inline bool PieceSprites::caching(void) const noexcept
+{
+	return m_caching;
+}
@@ -1,39 +1,153 @@
 #include <fstream>
 #include <sstream>
+#include <optional>
 #include "QtChessGUI.h"
 #include "BoardWidget.h"
 #include "EngineInfoWidget.h"
+#include "ExplorerWidget.h"
+#include "MultiBoardView.h"
+#include "MoveStatsGraph.h"
+#include "MoveListWidget.h"
 #include "OpenDBBrowser.h"
 #include "EnginesBrowser.h"
 #include "Engine/engine.h"
+#include "Core/Database.h"
+#include "Core/DBWriter.h"
+#include "Core/PGN.h"
+#include "Core/Tournament.h"
 #include "Dialogs/NewGameDialog.h"
 #include "Dialogs/SaveDBBrowser.h"
+#include "Dialogs/PatternSearchDialog.h"
+#include "Dialogs/TournamentDialog.h"
+
+namespace
+{
+	// Outcome of collecting derived data from all stored games on database worker
+	template<typename Data>
+	struct Rebuilt
+	{
+		std::shared_ptr<Data> data; // nullptr if rebuild was cancelled
+		int processed = 0, skipped = 0;
+	};
+
+	// Pass every stored game to add (games with illegal movetext are skipped), reporting progress.
+	// Returns false if progress function asked to stop
+	template<typename Data, typename Add>
+	bool collectGames(Rebuilt<Data>& rebuilt, const std::function<bool(int, int)>& progress,
+		QSqlDatabase database, Add add)
+	{
+		QSqlQuery countQuery("SELECT COUNT(*) FROM games", database);
+		const int total = countQuery.first() ? countQuery.value(0).toInt() : 0;
+		bool stopped = false;
+		BlendXChess::Game game;
+		db::forEachGame([&](const db::GameRecord& record) {
+			try
+			{
+				db::loadStoredGame(game, record.moves, record.startFEN, record.PGN);
+				add(record, game);
+			}
+			catch (const std::runtime_error&)
+			{
+				++rebuilt.skipped;
+			}
+			if (++rebuilt.processed % 256 == 0)
+				stopped = !progress(rebuilt.processed, total);
+			return !stopped;
+		}, database);
+		return !stopped;
+	}
+
+	// Result of PGN import thread
+	struct ImportOutcome
+	{
+		DBWriter::Stats stats;
+		int skipped = 0;
+		QString error; // Reading of the file failed
+		QString explorerError; // Set on GUI thread when opening explorer couldn't be updated
+	};
+}
 
 QtChessGUI::QtChessGUI(QWidget* parent)
-	: QMainWindow(parent)
+	: QMainWindow(parent), m_patternIndexChanged(false), m_jobProgress(nullptr), m_importThread(nullptr)
 {
-	db = QSqlDatabase::addDatabase("QMYSQL");
-	db.setHostName("localhost");
-	db.setDatabaseName("chessdb");
-	db.setUserName("root");
-	db.setPassword("LamboV3n3n0");
-	if (!db.open())
-		QMessageBox::critical(this, "Error", "Could not connect to database: "
-			+ db.lastError().text());
+	db = db::openDefault();
+	if (!db.isOpen())
+		QMessageBox::critical(this, "Error", "Could not connect to " + db::backend().name()
+			+ " database: " + db.lastError().text());
 	/*if (!db.driver()->hasFeature(QSqlDriver::Transactions))
 		QMessageBox::warning(this, "Error",
 			"Your database doesn't support transactions");*/
 
 	BlendXChess::Game::initialize();
+	try
+	{
+		m_explorer.open("explorer.bin");
+	}
+	catch (const std::runtime_error& err)
+	{
+		QMessageBox::warning(this, "Error", QString("Opening explorer is unavailable: ") + err.what());
+	}
+	try
+	{
+		m_patternIndex.open("patterns.bin");
+	}
+	catch (const std::runtime_error& err)
+	{
+		QMessageBox::warning(this, "Error", QString("Pattern index is unavailable: ") + err.what());
+	}
 
-	m_newDialog = new NewGameDialog(this);
+	m_newDialog = new NewGameDialog(this, m_dbWorker, m_players);
 	m_engineInfoWidget = new EngineInfoWidget(this);
 	m_boardWidget = new BoardWidget(this, m_engineInfoWidget);
+	m_explorerWidget = new ExplorerWidget(this, m_explorer);
+	m_moveStatsGraph = new MoveStatsGraph(this);
+	m_moveListWidget = new MoveListWidget(this);
+	QComboBox* statsSeriesCB = new QComboBox;
+	statsSeriesCB->addItem("Evaluation", int(MoveStatsGraph::Series::Score));
+	statsSeriesCB->addItem("Depth", int(MoveStatsGraph::Series::Depth));
+	statsSeriesCB->addItem("Nodes", int(MoveStatsGraph::Series::Nodes));
+	statsSeriesCB->addItem("Time per move", int(MoveStatsGraph::Series::Time));
+	QGroupBox* statsGB = new QGroupBox("Move statistics");
+	QVBoxLayout* statsLayout = new QVBoxLayout;
+	statsLayout->addWidget(statsSeriesCB);
+	statsLayout->addWidget(m_moveStatsGraph);
+	statsGB->setLayout(statsLayout);
 	QWidget* centralWidget = new QWidget;
 	QHBoxLayout* mainLayout = new QHBoxLayout;
+	QVBoxLayout* sideLayout = new QVBoxLayout;
 
+	sideLayout->addWidget(m_engineInfoWidget);
+	sideLayout->addWidget(m_moveListWidget);
+	sideLayout->addWidget(statsGB);
+	sideLayout->addWidget(m_explorerWidget);
 	mainLayout->addWidget(m_boardWidget);
-	mainLayout->addWidget(m_engineInfoWidget);
+	mainLayout->addLayout(sideLayout);
+
+	connect(m_boardWidget, &BoardWidget::positionChanged, [this](void) {
+		m_explorerWidget->showPosition(m_boardWidget->game());
+		m_moveListWidget->showGame(m_boardWidget->game());
+	});
+	connect(m_moveListWidget, &MoveListWidget::plyActivated, [this](int ply) {
+		if (!m_boardWidget->jumpToPly(ply)) // Keep selection of the move on board
+			m_moveListWidget->showGame(m_boardWidget->game());
+	});
+	connect(m_explorerWidget, &ExplorerWidget::moveActivated, [this](const QString& move) {
+		if (m_boardWidget->userMoves() && m_boardWidget->doMove(move.toStdString()))
+			m_boardWidget->update();
+	});
+	m_explorerWidget->showPosition(m_boardWidget->game());
+	m_moveListWidget->showGame(m_boardWidget->game());
+	connect(m_boardWidget, &BoardWidget::moveStatsAdded, [this](int ply) {
+		const GameStats& stats = m_boardWidget->moveStats();
+		if (ply == m_moveStatsGraph->plies()) // Next move of the game
+			m_moveStatsGraph->append(stats[ply]);
+		else // Move after undo
+			m_moveStatsGraph->setStats(stats);
+	});
+	connect(m_boardWidget, &BoardWidget::moveStatsReset, [this](void) {
+		m_moveStatsGraph->setStats(m_boardWidget->moveStats()); });
+	connect(statsSeriesCB, QOverload<int>::of(&QComboBox::currentIndexChanged), [this, statsSeriesCB](void) {
+		m_moveStatsGraph->setSeries(MoveStatsGraph::Series(statsSeriesCB->currentData().toInt())); });
 
 	centralWidget->setLayout(mainLayout);
 
@@ -44,9 +158,97 @@ QtChessGUI::QtChessGUI(QWidget* parent)
 
 QtChessGUI::~QtChessGUI(void)
 {
+	// Running job is stopped, so that closing doesn't wait for it
+	if (m_jobCancelled)
+		*m_jobCancelled = true;
+	if (m_importThread)
+	{
+		m_importThread->wait();
+		try
+		{
+			addImportedGames();
+		}
+		catch (const std::runtime_error& err)
+		{
+			qWarning() << "Opening explorer wasn't updated:" << err.what();
+		}
+	}
+	savePatternIndex();
 	db.close();
 }
 
+void QtChessGUI::addToPatternIndex(int gameId, const BlendXChess::Game& game)
+{
+	// Index which isn't built yet is left empty, so that search asks to build it
+	if (m_patternIndex.size() == 0)
+		return;
+	m_patternIndex.addGame(gameId, game);
+	m_patternIndexChanged = true;
+}
+
+std::function<bool(int, int)> QtChessGUI::startJob(const QString& label)
+{
+	m_jobCancelled = std::make_shared<std::atomic<bool>>(false);
+	m_jobProgress = new QProgressDialog(label, "Cancel", 0, 0, this);
+	m_jobProgress->setAutoReset(false);
+	m_jobProgress->setAutoClose(false);
+	connect(m_jobProgress, &QProgressDialog::canceled, [cancelled = m_jobCancelled](void) {
+		*cancelled = true;
+	});
+	m_jobProgress->show();
+	for (QAction* action : { m_rebuildIndexAction, m_rebuildExplorerAction, m_rebuildPatternIndexAction,
+		m_importPGNAction })
+		action->setEnabled(false);
+	// Dialog is deleted by finishJob, which is called after the job has finished posting
+	return [dialog = m_jobProgress, cancelled = m_jobCancelled](int processed, int total) {
+		QMetaObject::invokeMethod(dialog, [dialog, processed, total](void) {
+			if (dialog->wasCanceled())
+				return;
+			dialog->setMaximum(total);
+			dialog->setValue(processed);
+		}, Qt::QueuedConnection);
+		return !cancelled->load();
+	};
+}
+
+void QtChessGUI::finishJob(void)
+{
+	delete m_jobProgress;
+	m_jobProgress = nullptr;
+	m_jobCancelled.reset();
+	for (QAction* action : { m_rebuildIndexAction, m_rebuildExplorerAction, m_rebuildPatternIndexAction,
+		m_importPGNAction })
+		action->setEnabled(true);
+}
+
+void QtChessGUI::addImportedGames(void)
+{
+	// Explorer and pattern index get only stored games, so that duplicates and failed ones aren't counted
+	for (const DBWriter::CommittedGame& committed : m_importWriter->takeCommitted())
+	{
+		BlendXChess::Game game;
+		game.loadMoves(committed.game.moves);
+		m_explorer.addGame(game, db::resultState(committed.game.result),
+			committed.game.whiteElo, committed.game.blackElo);
+		addToPatternIndex(committed.id, game);
+	}
+}
+
+void QtChessGUI::savePatternIndex(void)
+{
+	if (!m_patternIndexChanged)
+		return;
+	try
+	{
+		m_patternIndex.save();
+		m_patternIndexChanged = false;
+	}
+	catch (const std::runtime_error& err)
+	{
+		QMessageBox::warning(this, "Error", QString("Pattern index wasn't saved: ") + err.what());
+	}
+}
+
 void QtChessGUI::createActions(void)
 {
 	m_newAction = new QAction("&New");
@@ -89,6 +291,35 @@ void QtChessGUI::createActions(void)
 	m_enginesAction->setToolTip("Manage engines");
 	connect(m_enginesAction, &QAction::triggered, this, &QtChessGUI::sEngines);
 
+	m_watchTournamentAction = new QAction("&Watch tournament");
+	m_watchTournamentAction->setToolTip("Play a tournament of engines, showing all its games");
+	connect(m_watchTournamentAction, &QAction::triggered, this, &QtChessGUI::sWatchTournament);
+
+	m_findPositionAction = new QAction("&Find games with this position");
+	m_findPositionAction->setToolTip("Search database for games which reached the position on board");
+	m_findPositionAction->setShortcut(QKeySequence::Find);
+	connect(m_findPositionAction, &QAction::triggered, this, &QtChessGUI::sFindPosition);
+
+	m_rebuildIndexAction = new QAction("&Rebuild position index");
+	m_rebuildIndexAction->setToolTip("Reindex positions of all games in database");
+	connect(m_rebuildIndexAction, &QAction::triggered, this, &QtChessGUI::sRebuildPositionIndex);
+
+	m_rebuildExplorerAction = new QAction("Rebuild opening &explorer");
+	m_rebuildExplorerAction->setToolTip("Recollect opening explorer statistics from all games in database");
+	connect(m_rebuildExplorerAction, &QAction::triggered, this, &QtChessGUI::sRebuildExplorer);
+
+	m_searchPatternAction = new QAction("Search by &material/pawns");
+	m_searchPatternAction->setToolTip("Find games with given material and pawn structure");
+	connect(m_searchPatternAction, &QAction::triggered, this, &QtChessGUI::sSearchPattern);
+
+	m_rebuildPatternIndexAction = new QAction("Rebuild &pattern index");
+	m_rebuildPatternIndexAction->setToolTip("Recollect material and pawn structure of all positions in database");
+	connect(m_rebuildPatternIndexAction, &QAction::triggered, this, &QtChessGUI::sRebuildPatternIndex);
+
+	m_importPGNAction = new QAction("&Import PGN file");
+	m_importPGNAction->setToolTip("Store all games from PGN file in database");
+	connect(m_importPGNAction, &QAction::triggered, this, &QtChessGUI::sImportPGN);
+
 	m_quitAction = new QAction("&Quit");
 	m_quitAction->setToolTip("Quit the program");
 	m_quitAction->setShortcut(QKeySequence::Quit);
@@ -124,21 +355,35 @@ void QtChessGUI::createMenus(void)
 	// Engines
 	m_enginesMenu = menuBar()->addMenu("&Engines");
 	m_enginesMenu->addAction(m_enginesAction);
+	m_enginesMenu->addAction(m_watchTournamentAction);
+
+	// Database
+	m_databaseMenu = menuBar()->addMenu("&Database");
+	m_databaseMenu->addAction(m_importPGNAction);
+	m_databaseMenu->addAction(m_findPositionAction);
+	m_databaseMenu->addAction(m_searchPatternAction);
+	m_databaseMenu->addAction(m_rebuildIndexAction);
+	m_databaseMenu->addAction(m_rebuildExplorerAction);
+	m_databaseMenu->addAction(m_rebuildPatternIndexAction);
 
 	// About menu
 	m_aboutMenu = menuBar()->addMenu("&About");
 	m_aboutMenu->addAction(m_aboutAction);
 }
 
-QString QtChessGUI::getEnginePath(int id)
+void QtChessGUI::loadGameFromDB(int id)
 {
-	QSqlQuery query;
-	query.prepare("SELECT path FROM engine_players WHERE id = ?");
-	query.addBindValue(id);
-	if (!query.exec() || !query.first())
-		throw std::runtime_error("Error reading engine path from database: "
-			+ db.lastError().text().toStdString());
-	return query.value("path").toString();
+	statusBar()->showMessage("Loading game...");
+	m_dbWorker.run(this, [id](QSqlDatabase database) {
+			return std::make_pair(db::readGame(id, database), db::readMoveStats(id, database)); },
+		[this](const std::pair<BlendXChess::Game, GameStats>& game) {
+			m_boardWidget->loadGame(game.first, game.second);
+			statusBar()->showMessage("Game loaded successfully");
+		},
+		[this](const QString& error) {
+			statusBar()->clearMessage();
+			QMessageBox::critical(this, "Error", error);
+		});
 }
 
 void QtChessGUI::sNewGame(void)
@@ -146,28 +391,44 @@ void QtChessGUI::sNewGame(void)
 	m_newDialog->refresh();
 	if (m_newDialog->exec() != QDialog::Accepted)
 		return;
-	try
+	if (m_newDialog->pvp())
 	{
-		if (m_newDialog->pvp())
-		{
-			m_boardWidget->startPVP();
-		}
-		else if (m_newDialog->withEngine())
-		{
-			QString enginePath = getEnginePath(m_newDialog->getSelectedEngineId());
-			m_boardWidget->startWithEngine(m_newDialog->getSelectedSide(), enginePath);
-		}
-		else
-		{
-			QString whiteEnginePath = getEnginePath(m_newDialog->getSelectedWhiteEngineId());
-			QString blackEnginePath = getEnginePath(m_newDialog->getSelectedWhiteEngineId());
-			m_boardWidget->startEngineVsEngine(whiteEnginePath, blackEnginePath);
-		}
-	}
-	catch (const std::runtime_error& err)
-	{
-		QMessageBox::critical(this, "Error", err.what());
+		m_boardWidget->startPVP();
+		return;
 	}
+	// Engine paths are normally cached since the dialog listed engines, otherwise
+	// they are loaded in background and the game starts when they arrive
+	const bool withEngine = m_newDialog->withEngine();
+	const BlendXChess::Side userSide = m_newDialog->getSelectedSide();
+	const int firstId = withEngine ? m_newDialog->getSelectedEngineId() : m_newDialog->getSelectedWhiteEngineId();
+	const int secondId = withEngine ? -1 : m_newDialog->getSelectedBlackEngineId();
+	statusBar()->showMessage("Loading engines...");
+	m_players.withPlayers(m_dbWorker, this,
+		[this, withEngine, userSide, firstId, secondId](const PlayerRegistry::Snapshot& players) {
+			statusBar()->clearMessage();
+			const PlayerRegistry::Engine* first = players->engine(firstId);
+			const PlayerRegistry::Engine* second = players->engine(secondId);
+			if (!first || (!withEngine && !second))
+			{
+				QMessageBox::critical(this, "Error", "Selected engine is not in database");
+				return;
+			}
+			try
+			{
+				if (withEngine)
+					m_boardWidget->startWithEngine(userSide, first->path);
+				else
+					m_boardWidget->startEngineVsEngine(first->path, second->path);
+			}
+			catch (const std::runtime_error& err)
+			{
+				QMessageBox::critical(this, "Error", err.what());
+			}
+		},
+		[this](const QString& error) {
+			statusBar()->clearMessage();
+			QMessageBox::critical(this, "Error", error);
+		});
 }
 
 void QtChessGUI::sAbout(void)
@@ -184,23 +445,7 @@ void QtChessGUI::sOpenDB(void)
 {
 	OpenDBBrowser* dbBrowser = new OpenDBBrowser(this);
 	if (dbBrowser->exec() == QDialog::Accepted)
-	{
-		int id = dbBrowser->getSelectedGameId();
-		QSqlQuery query;
-		query.prepare("SELECT PGN FROM games WHERE id = ?;");
-		query.addBindValue(id);
-		if (!query.exec() || !query.first())
-		{
-			QMessageBox::critical(this, "Error", "Error reading PGN from database: "
-				+ db.lastError().text());
-			return;
-		}
-		std::istringstream iss(query.value("PGN").toString().toStdString());
-		if (m_boardWidget->loadPGN(iss))
-			statusBar()->showMessage("Game loaded successfully");
-		else
-			statusBar()->showMessage("Error loading game");
-	}
+		loadGameFromDB(dbBrowser->getSelectedGameId());
 }
 
 void QtChessGUI::sOpenFile(void)
@@ -258,6 +503,326 @@ void QtChessGUI::sRedo(void)
 
 void QtChessGUI::sEngines(void)
 {
-	EnginesBrowser* engineBrowser = new EnginesBrowser(this);
+	EnginesBrowser* engineBrowser = new EnginesBrowser(this, m_dbWorker, m_players);
 	engineBrowser->exec();
 }
+
+void QtChessGUI::sWatchTournament(void)
+{
+	TournamentDialog dialog(this, m_dbWorker, m_players);
+	if (dialog.exec() != QDialog::Accepted)
+		return;
+	// Runner lives until the window is closed, stopping its games then
+	QWidget* window = new QWidget(this, Qt::Window);
+	window->setAttribute(Qt::WA_DeleteOnClose);
+	window->setWindowTitle("Tournament");
+	MultiBoardView* view = new MultiBoardView(window, m_boardWidget->pieceSprites());
+	QLabel* progressLabel = new QLabel;
+	QVBoxLayout* layout = new QVBoxLayout;
+	layout->addWidget(view);
+	layout->addWidget(progressLabel);
+	window->setLayout(layout);
+	TournamentRunner* runner = new TournamentRunner(dialog.config(), window);
+	connect(runner, &TournamentRunner::gameStarted, view, [runner, view](int slot, const QString& white, const QString& black) {
+		if (view->boardCount() != runner->slotCount()) // Slots are created on start
+			view->setBoardCount(runner->slotCount());
+		view->setTitle(slot, white + " - " + black);
+	});
+	connect(runner, &TournamentRunner::positionChanged, view, &MultiBoardView::setPosition);
+	connect(runner, &TournamentRunner::gameFinished, view, [runner, view, progressLabel](int slot, const MatchResult& result) {
+		view->setTitle(slot, view->title(slot) + "  " + result.result);
+		progressLabel->setText(QString("%1/%2 games played").arg(runner->gamesPlayed()).arg(runner->gamesTotal()));
+	});
+	connect(runner, &TournamentRunner::tournamentFinished, progressLabel, [runner, progressLabel] {
+		progressLabel->setText(QString("Tournament finished, %1 games played").arg(runner->gamesPlayed()));
+	});
+	try
+	{
+		runner->start();
+	}
+	catch (const std::exception& exc)
+	{
+		QMessageBox::critical(this, "Error", QString("Unable to start tournament: ") + exc.what());
+		delete window;
+		return;
+	}
+	window->show();
+}
+
+void QtChessGUI::sFindPosition(void)
+{
+	GamesTableModel::Filter filter;
+	filter.position = m_boardWidget->game().getPositionKey();
+	OpenDBBrowser* dbBrowser = new OpenDBBrowser(this, filter);
+	dbBrowser->setWindowTitle("Games with this position");
+	if (dbBrowser->exec() == QDialog::Accepted)
+		loadGameFromDB(dbBrowser->getSelectedGameId());
+}
+
+void QtChessGUI::sRebuildPositionIndex(void)
+{
+	const auto progress = startJob("Indexing game positions...");
+	m_dbWorker.run(this, [progress](QSqlDatabase database) {
+		bool stopped = false;
+		const int indexed = db::rebuildPositionIndex([&progress, &stopped](int processed, int total) {
+			stopped = !progress(processed, total);
+			return !stopped;
+		}, database);
+		return stopped ? std::nullopt : std::optional<int>(indexed); // Cancelled rebuild is rolled back
+	}, [this](std::optional<int> indexed) {
+		finishJob();
+		statusBar()->showMessage(indexed ? QString("Positions of %1 games indexed").arg(*indexed)
+			: QString("Indexing cancelled, previous index is kept"));
+	}, [this](const QString& error) {
+		finishJob();
+		QMessageBox::critical(this, "Error", error);
+	});
+}
+
+void QtChessGUI::sRebuildExplorer(void)
+{
+	if (!m_explorer.isOpen())
+	{
+		QMessageBox::critical(this, "Error", "Opening explorer is unavailable");
+		return;
+	}
+	const std::string path = m_explorer.path() + ".rebuild";
+	const auto progress = startJob("Collecting opening statistics...");
+	m_dbWorker.run(this, [path, progress](QSqlDatabase database) {
+		// Collected into separate files, so that cancelling keeps current statistics
+		Rebuilt<OpeningExplorer> rebuilt;
+		rebuilt.data = std::make_shared<OpeningExplorer>();
+		rebuilt.data->open(path);
+		rebuilt.data->clear(); // Files may be left by interrupted rebuild
+		OpeningExplorer& explorer = *rebuilt.data;
+		const bool finished = collectGames(rebuilt, progress, database,
+			[&explorer](const db::GameRecord& record, const BlendXChess::Game& game) {
+				explorer.addGame(game, db::resultState(record.result), record.whiteElo, record.blackElo);
+			});
+		if (finished)
+			explorer.compact(); // Merged here, so that replacing doesn't do it in GUI thread
+		else
+		{
+			explorer.remove();
+			rebuilt.data.reset();
+		}
+		return rebuilt;
+	}, [this](Rebuilt<OpeningExplorer> rebuilt) {
+		finishJob();
+		if (!rebuilt.data)
+		{
+			statusBar()->showMessage("Collecting opening statistics cancelled, previous ones are kept");
+			return;
+		}
+		try
+		{
+			m_explorer.replace(*rebuilt.data);
+			statusBar()->showMessage(QString("Opening statistics collected from %1 games (%2 skipped)")
+				.arg(rebuilt.processed - rebuilt.skipped).arg(rebuilt.skipped));
+		}
+		catch (const std::runtime_error& err)
+		{
+			QMessageBox::critical(this, "Error", err.what());
+		}
+		m_explorerWidget->showPosition(m_boardWidget->game());
+	}, [this](const QString& error) {
+		finishJob();
+		QMessageBox::critical(this, "Error", error);
+	});
+}
+
+void QtChessGUI::sSearchPattern(void)
+{
+	// Longer lists of games are truncated, they are passed to database in query text
+	constexpr size_t MAX_SHOWN_GAMES = 10000;
+	if (!m_patternIndex.isOpen())
+	{
+		QMessageBox::critical(this, "Error", "Pattern index is unavailable");
+		return;
+	}
+	if (m_patternIndex.size() == 0)
+	{
+		QMessageBox::information(this, "Search", "Pattern index is empty, it should be rebuilt from database first");
+		return;
+	}
+	PatternSearchDialog dialog(this, m_boardWidget->game().getPosition());
+	if (dialog.exec() != QDialog::Accepted)
+		return;
+	const PatternIndex::Result result = m_patternIndex.search(dialog.query());
+	statusBar()->showMessage(QString("%1 games found, %2 positions scanned in %3 ms (%4 million positions/s)")
+		.arg(result.matches.size()).arg(result.scanned).arg(result.seconds * 1000.0, 0, 'f', 1)
+		.arg(result.positionsPerSecond() / 1e6, 0, 'f', 1));
+	GamesTableModel::Filter filter;
+	filter.games.emplace();
+	for (size_t i = 0; i < std::min(result.matches.size(), MAX_SHOWN_GAMES); ++i)
+		filter.games->push_back(result.matches[i].gameId);
+	OpenDBBrowser* dbBrowser = new OpenDBBrowser(this, filter);
+	dbBrowser->setWindowTitle(result.matches.size() > MAX_SHOWN_GAMES
+		? QString("Games matching the pattern (first %1 of %2)").arg(MAX_SHOWN_GAMES).arg(result.matches.size())
+		: QString("Games matching the pattern"));
+	if (dbBrowser->exec() == QDialog::Accepted)
+		loadGameFromDB(dbBrowser->getSelectedGameId());
+}
+
+void QtChessGUI::sRebuildPatternIndex(void)
+{
+	if (!m_patternIndex.isOpen())
+	{
+		QMessageBox::critical(this, "Error", "Pattern index is unavailable");
+		return;
+	}
+	const auto progress = startJob("Collecting material and pawn structures...");
+	m_dbWorker.run(this, [progress](QSqlDatabase database) {
+		// Built apart from current index, so that cancelling keeps it
+		Rebuilt<PatternIndex> rebuilt;
+		rebuilt.data = std::make_shared<PatternIndex>();
+		PatternIndex& index = *rebuilt.data;
+		const bool finished = collectGames(rebuilt, progress, database,
+			[&index](const db::GameRecord& record, const BlendXChess::Game& game) {
+				index.addGame(record.id, game);
+			});
+		if (!finished)
+			rebuilt.data.reset();
+		return rebuilt;
+	}, [this](Rebuilt<PatternIndex> rebuilt) {
+		finishJob();
+		if (!rebuilt.data)
+		{
+			statusBar()->showMessage("Pattern index rebuild cancelled, previous index is kept");
+			return;
+		}
+		try
+		{
+			m_patternIndex.replace(std::move(*rebuilt.data));
+			m_patternIndex.save();
+			m_patternIndexChanged = false;
+			statusBar()->showMessage(QString("Pattern index of %1 positions built from %2 games (%3 skipped)")
+				.arg(m_patternIndex.size()).arg(rebuilt.processed - rebuilt.skipped).arg(rebuilt.skipped));
+		}
+		catch (const std::runtime_error& err)
+		{
+			QMessageBox::critical(this, "Error", err.what());
+		}
+	}, [this](const QString& error) {
+		finishJob();
+		QMessageBox::critical(this, "Error", error);
+	});
+}
+
+void QtChessGUI::sImportPGN(void)
+{
+	QString path = QFileDialog::getOpenFileName(this, "Import PGN file", "", "Portable game notation (*.pgn);;All files (*)");
+	if (path.isEmpty())
+		return;
+	auto inFile = std::make_shared<std::ifstream>(path.toStdString(), std::ios::binary);
+	if (!*inFile)
+	{
+		QMessageBox::critical(this, "Error", "Could not open " + path);
+		return;
+	}
+	// Progress is shown in KiB so that it fits into int
+	const int fileSize = int(QFileInfo(path).size() / 1024);
+	// Players are found or created by the writer, so that parsing doesn't wait for database
+	DBWriter::Options options;
+	options.players = &m_players;
+	options.keepCommitted = m_explorer.isOpen() || m_patternIndex.size() != 0;
+	m_importWriter = std::make_unique<DBWriter>(options);
+	const auto progress = startJob("Importing games...");
+	auto outcome = std::make_shared<ImportOutcome>();
+	// Games are parsed on their own thread, which waits while writer is behind. Explorer
+	// and pattern index are updated in GUI thread, as they are used there
+	const auto onProgress = [this, outcome](void) {
+		if (!m_jobProgress)
+			return;
+		m_jobProgress->setLabelText(QString("Importing games... (%1 stored)").arg(m_importWriter->written()));
+		try
+		{
+			addImportedGames();
+		}
+		catch (const std::runtime_error& err)
+		{
+			outcome->explorerError = err.what();
+			*m_jobCancelled = true;
+		}
+	};
+	DBWriter* writer = m_importWriter.get();
+	m_importThread = QThread::create([this, inFile, fileSize, writer, progress, outcome, onProgress](void) {
+		const auto playerName = [](const std::string& name) {
+			return name.empty() ? QString("?") : QString::fromStdString(name);
+		};
+		pgn::Record record;
+		try
+		{
+			for (int count = 1; pgn::read(*inFile, record); ++count)
+			{
+				// Movetext is parsed from the standard starting position only
+				BlendXChess::Game game;
+				std::istringstream iss(record.movetext);
+				try
+				{
+					if (!record.tag("FEN").empty())
+						throw std::runtime_error("Game doesn't start from standard position");
+					game.loadGame(iss);
+				}
+				catch (const std::runtime_error&)
+				{
+					++outcome->skipped;
+					continue;
+				}
+				const QString result = record.result == "*" ? QString("Active") : QString::fromStdString(record.result);
+				const int whiteElo = std::atoi(record.tag("WhiteElo").c_str());
+				const int blackElo = std::atoi(record.tag("BlackElo").c_str());
+				DBWriter::GameEntry entry{ -1, -1, game.getMoves(), QString(), result,
+					QDate::fromString(QString::fromStdString(record.tag("Date")), "yyyy.MM.dd"), game.getPositionKeys(),
+					playerName(record.tag("White")), playerName(record.tag("Black")), whiteElo, blackElo };
+				// Blocks while writer is behind
+				if (!writer->push(std::move(entry)))
+					break;
+				if (count % 256 == 0)
+				{
+					QMetaObject::invokeMethod(this, onProgress, Qt::QueuedConnection);
+					if (!progress(int(qint64(inFile->tellg()) / 1024), fileSize))
+						break;
+				}
+			}
+		}
+		catch (const std::runtime_error& err)
+		{
+			outcome->error = err.what();
+		}
+		QMetaObject::invokeMethod(this, [this](void) {
+			if (m_jobProgress)
+				m_jobProgress->setLabelText("Finishing...");
+		}, Qt::QueuedConnection);
+		outcome->stats = writer->finish();
+	});
+	m_importThread->setParent(this); // Deleted along with window if it's closed during import
+	connect(m_importThread, &QThread::finished, this, [this, outcome](void) {
+		m_importThread->deleteLater();
+		m_importThread = nullptr;
+		finishJob();
+		if (!outcome->error.isEmpty())
+			QMessageBox::critical(this, "Error", outcome->error);
+		try
+		{
+			addImportedGames();
+		}
+		catch (const std::runtime_error& err)
+		{
+			outcome->explorerError = err.what();
+		}
+		m_importWriter.reset();
+		if (!outcome->explorerError.isEmpty())
+			QMessageBox::warning(this, "Error", "Opening explorer wasn't updated: " + outcome->explorerError);
+		savePatternIndex();
+		const DBWriter::Stats& stats = outcome->stats;
+		if (stats.failed > 0)
+			QMessageBox::warning(this, "Error", QString("%1 games couldn't be stored: %2")
+				.arg(stats.failed).arg(stats.lastError));
+		statusBar()->showMessage(QString("%1 games imported (%2 skipped, %3 already stored) in %4 s, %5 games/s")
+			.arg(stats.written).arg(outcome->skipped).arg(stats.duplicates).arg(stats.elapsed / 1000.0, 0, 'f', 1)
+			.arg(stats.gamesPerSecond(), 0, 'f', 0));
+		m_explorerWidget->showPosition(m_boardWidget->game());
+	});
+	m_importThread->start();
+}
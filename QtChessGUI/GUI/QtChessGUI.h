@@ -2,10 +2,22 @@
 
 #include <QtSql>
 #include <QMainWindow>
+#include <atomic>
+#include <memory>
+#include "Core/OpeningExplorer.h"
+#include "Core/PatternIndex.h"
+#include "Core/DBWorker.h"
+#include "Core/DBWriter.h"
+#include "Core/PlayerRegistry.h"
 
 class NewGameDialog;
 class BoardWidget;
 class EngineInfoWidget;
+class ExplorerWidget;
+class MoveStatsGraph;
+class MoveListWidget;
+class QProgressDialog;
+class QThread;
 
 class QtChessGUI : public QMainWindow
 {
@@ -15,10 +27,22 @@ public:
 	QtChessGUI(QWidget *parent = Q_NULLPTR);
 	~QtChessGUI(void);
 	inline BoardWidget* getBoardWidget(void) const;
+	inline OpeningExplorer& openingExplorer(void) noexcept;
+	inline DBWorker& dbWorker(void) noexcept;
+	inline PlayerRegistry& playerRegistry(void) noexcept;
+	// Add stored game to pattern index unless it isn't built yet. Index is saved after import or on exit
+	void addToPatternIndex(int gameId, const BlendXChess::Game& game);
 private:
 	void createActions(void);
+	void savePatternIndex(void);
 	void createMenus(void);
-	QString getEnginePath(int id);
+	void loadGameFromDB(int id);
+	// Show progress dialog of background database job and disable starting other ones until
+	// finishJob. Returned function reports progress from any thread and tells whether to go on
+	std::function<bool(int, int)> startJob(const QString& label);
+	void finishJob(void);
+	// Add games committed by PGN import writer to opening explorer and pattern index
+	void addImportedGames(void);
 	// Slots
 	void sNewGame(void);
 	void sAbout(void);
@@ -31,13 +55,24 @@ private:
 	void sUndo(void);
 	void sRedo(void);
 	void sEngines(void);
+	void sWatchTournament(void);
+	void sFindPosition(void);
+	void sRebuildPositionIndex(void);
+	void sRebuildExplorer(void);
+	void sSearchPattern(void);
+	void sRebuildPatternIndex(void);
+	void sImportPGN(void);
 	// Members
 	NewGameDialog* m_newDialog;
 	BoardWidget* m_boardWidget;
 	EngineInfoWidget* m_engineInfoWidget;
+	ExplorerWidget* m_explorerWidget;
+	MoveStatsGraph* m_moveStatsGraph;
+	MoveListWidget* m_moveListWidget;
 	QMenu* m_fileMenu;
 	QMenu* m_aboutMenu;
 	QMenu* m_enginesMenu;
+	QMenu* m_databaseMenu;
 	QAction* m_newAction;
 	QAction* m_openFromFileAction;
 	QAction* m_openFromDBAction;
@@ -47,12 +82,43 @@ private:
 	QAction* m_undoAction;
 	QAction* m_redoAction;
 	QAction* m_enginesAction;
+	QAction* m_watchTournamentAction;
+	QAction* m_findPositionAction;
+	QAction* m_rebuildIndexAction;
+	QAction* m_rebuildExplorerAction;
+	QAction* m_searchPatternAction;
+	QAction* m_rebuildPatternIndexAction;
+	QAction* m_importPGNAction;
 	QAction* m_quitAction;
 	QAction* m_aboutAction;
 	QSqlDatabase db;
+	OpeningExplorer m_explorer;
+	PatternIndex m_patternIndex;
+	bool m_patternIndexChanged; // Games were added since the index was saved
+	PlayerRegistry m_players; // Shared by dialogs, so that players aren't queried each time
+	QProgressDialog* m_jobProgress; // Of running background job, nullptr if there's none
+	std::shared_ptr<std::atomic<bool>> m_jobCancelled; // Set by cancelling the running job
+	std::unique_ptr<DBWriter> m_importWriter; // Stores games of running PGN import
+	QThread* m_importThread; // Parses PGN file of running import
+	DBWorker m_dbWorker; // Database access of dialogs which shouldn't block GUI
 };
 
 inline BoardWidget* QtChessGUI::getBoardWidget(void) const
 {
 	return m_boardWidget;
+}
+
+inline OpeningExplorer& QtChessGUI::openingExplorer(void) noexcept
+{
+	return m_explorer;
+}
+
+inline DBWorker& QtChessGUI::dbWorker(void) noexcept
+{
+	return m_dbWorker;
+}
+
+inline PlayerRegistry& QtChessGUI::playerRegistry(void) noexcept
+{
+	return m_players;
 }
\ No newline at end of file
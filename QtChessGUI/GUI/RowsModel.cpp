@@ -0,0 +1,39 @@
+#include "RowsModel.h"
+
+RowsModel::RowsModel(QObject* parent, const QStringList& headers)
+	: QAbstractTableModel(parent), m_headers(headers), m_columns(headers.size())
+{}
+
+void RowsModel::setRows(db::Rows rows)
+{
+	beginResetModel();
+	m_rows = std::move(rows);
+	if (!m_rows.isEmpty())
+		m_columns = std::max(m_columns, m_rows.front().size());
+	endResetModel();
+}
+
+int RowsModel::rowCount(const QModelIndex& parent) const
+{
+	return parent.isValid() ? 0 : m_rows.size();
+}
+
+int RowsModel::columnCount(const QModelIndex& parent) const
+{
+	return parent.isValid() ? 0 : m_columns;
+}
+
+QVariant RowsModel::data(const QModelIndex& index, int role) const
+{
+	if (!index.isValid() || (role != Qt::DisplayRole && role != Qt::EditRole)
+		|| index.column() >= m_rows[index.row()].size())
+		return QVariant();
+	return m_rows[index.row()][index.column()];
+}
+
+QVariant RowsModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+	if (orientation == Qt::Horizontal && role == Qt::DisplayRole && section < m_headers.size())
+		return m_headers[section];
+	return QAbstractTableModel::headerData(section, orientation, role);
+}
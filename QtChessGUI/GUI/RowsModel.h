@@ -0,0 +1,20 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include "Core/Database.h"
+
+// Read-only table of rows loaded in background by DBWorker
+class RowsModel : public QAbstractTableModel
+{
+public:
+	RowsModel(QObject* parent, const QStringList& headers = QStringList());
+	void setRows(db::Rows rows);
+	int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+	int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+	QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+	QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+private:
+	QStringList m_headers;
+	db::Rows m_rows;
+	int m_columns;
+};
@@ -1,9 +1,139 @@
 #include "GUI/QtChessGUI.h"
+#include "GUI/BoardBenchmarks.h"
+#include "GUI/BoardRenderer.h"
+#include "Core/Tournament.h"
+#include "Core/Benchmarks.h"
+#include "Core/Database.h"
+#include "Core/MatchStats.h"
 #include <QtWidgets/QApplication>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+	// Convert movetext of games stored by older versions into packed moves
+	int migrateMoves(void)
+	{
+		int migrated = 0;
+		{
+			QSqlDatabase database = db::openDefault();
+			if (!database.isOpen())
+			{
+				std::cerr << "Could not connect to database: " << database.lastError().text().toStdString() << std::endl;
+				return 1;
+			}
+			try
+			{
+				migrated = db::migrateMoves([](int processed, int total) {
+					std::cout << processed << '/' << total << " games processed" << std::endl;
+					return true;
+				}, database);
+			}
+			catch (const std::runtime_error& err)
+			{
+				std::cerr << err.what() << std::endl;
+				return 1;
+			}
+		}
+		QSqlDatabase::removeDatabase(QSqlDatabase::defaultConnection);
+		std::cout << migrated << " games converted" << std::endl;
+		return 0;
+	}
+
+	// Check SPRT decisions of match statistics on one-sided results
+	int checkStats(void)
+	{
+		using Result = MatchStats::SPRTResult;
+		const MatchStats::SPRTParams params;
+		int failed = 0;
+		const auto check = [&failed](bool ok, const char* what) {
+			std::cout << (ok ? "ok      " : "FAILED  ") << what << std::endl;
+			failed += !ok;
+		};
+		MatchStats wins, losses, draws, wonPairs, fewWins;
+		for (int i = 0; i < 100; ++i)
+		{
+			wins.addGame(1.0);
+			losses.addGame(0.0);
+			draws.addGame(0.5);
+		}
+		for (int i = 0; i < 50; ++i)
+		{
+			wonPairs.addGame(1.0);
+			wonPairs.addGame(1.0);
+			wonPairs.addPair(1.0, 1.0);
+		}
+		for (int i = 0; i < 5; ++i)
+			fewWins.addGame(1.0);
+		check(wins.sprt(params) == Result::AcceptH1, "100 wins accept H1");
+		check(losses.sprt(params) == Result::AcceptH0, "100 losses accept H0");
+		check(std::isfinite(draws.llr(params)) && draws.llr(params) < 0.0, "100 draws lean to H0");
+		check(wonPairs.sprt(params) == Result::AcceptH1, "50 won pairs accept H1");
+		check(fewWins.sprt(params) == Result::Continue, "5 wins don't decide");
+		return failed == 0 ? 0 : 1;
+	}
+}
 
 int main(int argc, char *argv[])
 {
+	// "--storage mysql[:database]|sqlite:path" selects database for all modes,
+	// it's removed from arguments so that modes' parsers don't see it
+	for (int i = 1; i + 1 < argc; ++i)
+		if (std::strcmp(argv[i], "--storage") == 0)
+		{
+			try
+			{
+				db::setBackend(StorageBackend::create(QString::fromLocal8Bit(argv[i + 1])));
+			}
+			catch (const std::runtime_error& err)
+			{
+				std::fprintf(stderr, "%s\n", err.what());
+				return 1;
+			}
+			std::copy(argv + i + 2, argv + argc + 1, argv + i);
+			argc -= 2;
+			break;
+		}
+	// Headless modes don't need widgets, so they run without QApplication
+	if (argc > 1 && std::strcmp(argv[1], "--tournament") == 0)
+	{
+		QCoreApplication app(argc, argv);
+		return TournamentRunner::runFromCommandLine(app);
+	}
+	if (argc > 1 && std::strcmp(argv[1], "--bench-uci") == 0)
+	{
+		QCoreApplication app(argc, argv);
+		return bench::runUCI(app);
+	}
+	if (argc > 1 && std::strcmp(argv[1], "--bench-storage") == 0)
+	{
+		QCoreApplication app(argc, argv);
+		return bench::runStorage(app);
+	}
+	if (argc > 1 && std::strcmp(argv[1], "--migrate-moves") == 0)
+	{
+		QCoreApplication app(argc, argv);
+		return migrateMoves();
+	}
+	if (argc > 1 && std::strcmp(argv[1], "--check-stats") == 0)
+		return checkStats();
+	// Diagrams are painted into images, so only GUI library is needed
+	if (argc > 1 && std::strcmp(argv[1], "--render-diagrams") == 0)
+	{
+		QGuiApplication app(argc, argv);
+		return BoardRenderer::runFromCommandLine(app);
+	}
+	// Board is rendered in device pixels, so it's sharp on high-DPI screens
+	QApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
+	QApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);
 	QApplication app(argc, argv);
+	if (argc > 1 && std::strcmp(argv[1], "--bench-paint") == 0)
+		return bench::runPaint(app);
+	if (argc > 1 && std::strcmp(argv[1], "--bench-click") == 0)
+		return bench::runClick(app);
 	QFile file("defaultStyle.qss");
 	file.open(QFile::ReadOnly);
 	QString styleSheet = QLatin1String(file.readAll());